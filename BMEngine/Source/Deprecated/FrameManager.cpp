@@ -22,6 +22,7 @@
 #include "VulkanInterface/VulkanInterface.h"
 #include "Engine/Systems/Render/VulkanHelper.h"
 #include "Engine/Systems/Render/RenderResources.h"
+#include "Engine/Systems/Render/DeviceMemoryAllocator.h"
 
 #include "Util/Util.h"
 
@@ -32,6 +33,7 @@ namespace FrameManager
 
 	static const VkDescriptorType BufferType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	static VulkanInterface::UniformBuffer Buffer;
+	static VulkanHelper::DeviceMemoryAllocation BufferMemory;
 	static u64 BufferAlignment;
 	static u64 NextUniformMemoryHandle;
 
@@ -43,17 +45,13 @@ namespace FrameManager
 
 	void Init()
 	{
-		VkPhysicalDevice PhysicalDevice = VulkanInterface::GetPhysicalDevice();
 		VkDevice Device = VulkanInterface::GetDevice();
 
 		BufferMultiFrameSize = BufferSingleFrameSize * VulkanInterface::GetImageCount();
 
 		Buffer.Buffer = VulkanHelper::CreateBuffer(Device, BufferMultiFrameSize, VulkanHelper::BufferUsageFlag::UniformFlag);
-		VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device, Buffer.Buffer,
-			VulkanHelper::MemoryPropertyFlag::HostCompatible);
-		Buffer.Memory = AllocResult.Memory;
-		BufferAlignment = AllocResult.Alignment;
-		vkBindBufferMemory(Device, Buffer.Buffer, Buffer.Memory, 0);
+		BufferMemory = DeviceMemoryAllocator::AllocateBufferMemory(Buffer.Buffer, VulkanHelper::MemoryPropertyFlag::HostCompatible);
+		BufferAlignment = BufferMemory.Alignment;
 
 		const VkDeviceSize VpBufferSize = sizeof(ViewProjectionBuffer);
 		const VkShaderStageFlags VpStageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -86,7 +84,7 @@ namespace FrameManager
 		vkDestroyDescriptorSetLayout(Device, VpLayout, nullptr);
 
 		vkDestroyBuffer(Device, Buffer.Buffer, nullptr);
-		vkFreeMemory(Device, Buffer.Memory, nullptr);
+		DeviceMemoryAllocator::Free(&BufferMemory);
 	}
 
 	void UpdateViewProjection(const ViewProjectionBuffer* Data)
@@ -103,7 +101,7 @@ namespace FrameManager
 
 	void UpdateUniformMemory(UniformMemoryHnadle Handle, const void* Data, u64 Size)
 	{
-		VulkanHelper::UpdateHostCompatibleBufferMemory(VulkanInterface::GetDevice(), Buffer.Memory, Size,
+		VulkanHelper::UpdateHostCompatibleBufferMemory(&BufferMemory, Size,
 			Handle + (Size * VulkanInterface::TestGetImageIndex()), Data);
 	}
 
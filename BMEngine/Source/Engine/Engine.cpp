@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <thread>
 #include <filesystem>
+#include <cstring>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/string_cast.hpp>
@@ -21,6 +22,7 @@
 #include "Deprecated/FrameManager.h"
 #include "Engine/Systems/EngineResources.h"
 #include "Engine/Systems/Render/TransferSystem.h"
+#include "Engine/Systems/Render/DeletionQueue.h"
 #include "Engine/Systems/Concurrency/TaskSystem.h"
 
 #include <gli/gli.hpp>
@@ -61,16 +63,33 @@ namespace Engine
 		}
 	}
 
-	static void ParseAndCreateShaders(Yaml::Node& ShadersNode)
+	struct ShaderSource
 	{
-		for (auto It = ShadersNode.Begin(); It != ShadersNode.End(); It++)
+		std::string Name;
+		std::string Path;
+	};
+
+	struct ShaderJob
+	{
+		std::vector<ShaderSource> Sources;
+		std::atomic<u32> NextSource;
+		TaskSystem::TaskGroup Group;
+	};
+
+	static ShaderJob ShaderLoad;
+
+	static void LoadShaders()
+	{
+		const u32 SourceCount = (u32)ShaderLoad.Sources.size();
+
+		for (u32 i = ShaderLoad.NextSource.fetch_add(1); i < SourceCount; i = ShaderLoad.NextSource.fetch_add(1))
 		{
-			std::string ShaderPath = Util::ParseShaderNode((*It).second);
+			const ShaderSource* Source = &ShaderLoad.Sources[i];
 
 			std::vector<char> ShaderCode;
-			if (Util::OpenAndReadFileFull(ShaderPath.c_str(), ShaderCode, "rb"))
+			if (Util::OpenAndReadFileFull(Source->Path.c_str(), ShaderCode, "rb"))
 			{
-				RenderResources::CreateShader((*It).first, reinterpret_cast<const u32*>(ShaderCode.data()), ShaderCode.size());
+				RenderResources::CreateShader(Source->Name, reinterpret_cast<const u32*>(ShaderCode.data()), ShaderCode.size());
 			}
 			else
 			{
@@ -79,6 +98,35 @@ namespace Engine
 		}
 	}
 
+	// Shader modules are created by jobs while main thread creates other resources, see WaitForShaders
+	static void ParseAndCreateShaders(Yaml::Node& ShadersNode)
+	{
+		for (auto It = ShadersNode.Begin(); It != ShadersNode.End(); It++)
+		{
+			ShaderLoad.Sources.push_back({ (*It).first, Util::ParseShaderNode((*It).second) });
+		}
+
+		const u32 SourceCount = (u32)ShaderLoad.Sources.size();
+		const u32 WorkerCount = TaskSystem::GetWorkerCount();
+		const u32 JobCount = SourceCount < WorkerCount ? SourceCount : WorkerCount;
+
+		ShaderLoad.NextSource.store(0);
+		ShaderLoad.Group.TasksInGroup = 0;
+
+		for (u32 i = 0; i < JobCount; ++i)
+		{
+			TaskSystem::AddTask(LoadShaders, &ShaderLoad.Group);
+		}
+	}
+
+	static void WaitForShaders()
+	{
+		// Main thread picks up shaders that are not taken by workers yet
+		LoadShaders();
+		TaskSystem::WaitForGroup(&ShaderLoad.Group);
+		ShaderLoad.Sources.clear();
+	}
+
 	static void ParseAndCreateSamplers(Yaml::Node& SamplersNode)
 	{
 		for (auto It = SamplersNode.Begin(); It != SamplersNode.End(); It++)
@@ -106,6 +154,7 @@ namespace Engine
 	static void Update(f64 DeltaTime);
 
 	static void SetUpScene();
+	static void ReloadSceneModels();
 
 	static void MoveCamera(GLFWwindow* Window, f32 DeltaTime, Camera& MainCamera);
 
@@ -127,6 +176,7 @@ namespace Engine
 
 	static Render::DrawEntity SkyBox;
 	static Render::LightBuffer LightData;
+	static Render::PointLight PointLightData;
 
 	static UI::GuiData GuiData;
 
@@ -141,6 +191,10 @@ namespace Engine
 
 
 	static Render::DrawScene Scene;
+	// Models of test scene, reloaded from UI
+	static std::vector<EngineResources::ModelLoadRequest> SceneModels;
+
+	static bool BenchmarkPipelineCache = false;
 
 
 
@@ -156,8 +210,16 @@ namespace Engine
 		}
 	}
 
-	int Main()
+	int Main(int ArgCount, char** Args)
 	{
+		for (int i = 1; i < ArgCount; ++i)
+		{
+			if (strcmp(Args[i], "--benchmark-pipeline-cache") == 0)
+			{
+				BenchmarkPipelineCache = true;
+			}
+		}
+
 		Init();
 
 		TaskSystem::TaskGroup Group;
@@ -181,6 +243,7 @@ namespace Engine
 			}
 
 			TaskSystem::WaitForGroup(&Group);
+			DeletionQueue::Update();
 		}
 
 		DeInit();
@@ -224,18 +287,41 @@ namespace Engine
 
 		UI::Init(&GuiData);
 
+		const f64 InitStartTime = glfwGetTime();
+
 		Yaml::Node Root;
 		Yaml::Parse(Root, "./Resources/Settings/RenderResources.yaml");
 
 		RenderResources::Init(Window);
-		ParseAndCreateVertices(Util::GetVertices(Root));
+		const f64 DeviceInitTime = glfwGetTime();
+
+		// Pipelines depend on shaders and layouts, shader jobs run while layouts are created
 		ParseAndCreateShaders(Util::GetShaders(Root));
+		ParseAndCreateVertices(Util::GetVertices(Root));
 		ParseAndCreateSamplers(Util::GetSamplers(Root));
 		RenderResources::CreateDescriptorLayouts(Util::GetDescriptorSetLayouts(Root));
 		RenderResources::PostCreateInit();
 
 		TransferSystem::Init();
+		DeletionQueue::Init();
+		const f64 ResourcesInitTime = glfwGetTime();
+
+		WaitForShaders();
+		const f64 ShadersInitTime = glfwGetTime();
+
+		// Startup cost of pipeline creation, compare first run with runs that load pipeline cache
+		if (BenchmarkPipelineCache)
+		{
+			RenderResources::EnablePipelineCacheBenchmark();
+		}
+
 		Render::Init(Window);
+		const f64 RenderInitTime = glfwGetTime();
+
+		Util::RenderLog(Util::LogType::Info, "Init timings: device %.2f ms, resources %.2f ms, shaders wait %.2f ms, render %.2f ms with %s pipeline cache",
+			(DeviceInitTime - InitStartTime) * 1000.0, (ResourcesInitTime - DeviceInitTime) * 1000.0,
+			(ShadersInitTime - ResourcesInitTime) * 1000.0, (RenderInitTime - ShadersInitTime) * 1000.0,
+			RenderResources::IsPipelineCacheLoaded() ? "warm" : "cold");
 
 		EngineResources::Init();
 
@@ -262,14 +348,30 @@ namespace Engine
 			Request.Position = Util::GetModelPosition(ModelNode);
 
 			EngineResources::RequestModelLoad(Request);
+			SceneModels.push_back(Request);
 		}
 
 		return true;
 	}
 
+	// Every scene model goes through unload path and is loaded again, freed vertex ranges are compacted meanwhile
+	static void ReloadSceneModels()
+	{
+		for (const EngineResources::ModelLoadRequest& Request : SceneModels)
+		{
+			EngineResources::RequestModelUnload(Request.Path);
+		}
+
+		for (const EngineResources::ModelLoadRequest& Request : SceneModels)
+		{
+			EngineResources::RequestModelLoad(Request);
+		}
+	}
+
 	void DeInit()
 	{
 		Render::DeInit();
+		DeletionQueue::DeInit();
 		TransferSystem::DeInit();
 		RenderResources::DeInit();
 		EngineResources::DeInit();
@@ -320,6 +422,10 @@ namespace Engine
 		LightData.SpotLight.LightSpaceMatrix = ViewProjection.Projection * ViewProjection.View;
 
 		Scene.LightEntity = &LightData;
+		Scene.PointLights = &PointLightData;
+		Scene.PointLightCount = 1;
+		Scene.NearPlane = Near;
+		Scene.FarPlane = Far;
 
 		GuiData.DirectionLightDirection = &LightData.DirectionLight.Direction;
 		GuiData.Eye = &Eye;
@@ -347,13 +453,13 @@ namespace Engine
 		ViewProjection.Projection[1][1] *= -1;
 		ViewProjection.View = glm::lookAt(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
-		LightData.PointLight.Position = glm::vec4(0.0f, 0.0f, 10.0f, 1.0f);
-		LightData.PointLight.Ambient = glm::vec3(0.01f, 0.01f, 0.01f);
-		LightData.PointLight.Diffuse = glm::vec3(0.5f, 0.5f, 0.5f);
-		LightData.PointLight.Specular = glm::vec3(1.0f, 1.0f, 1.0f);
-		LightData.PointLight.Constant = 1.0f;
-		LightData.PointLight.Linear = 0.09;
-		LightData.PointLight.Quadratic = 0.032;
+		PointLightData.Position = glm::vec4(0.0f, 0.0f, 10.0f, 1.0f);
+		PointLightData.Ambient = glm::vec3(0.01f, 0.01f, 0.01f);
+		PointLightData.Diffuse = glm::vec3(0.5f, 0.5f, 0.5f);
+		PointLightData.Specular = glm::vec3(1.0f, 1.0f, 1.0f);
+		PointLightData.Constant = 1.0f;
+		PointLightData.Linear = 0.09;
+		PointLightData.Quadratic = 0.032;
 
 		LightData.DirectionLight.Direction = glm::vec3(0.0f, -1.0f, 0.0f);
 		LightData.DirectionLight.Ambient = glm::vec3(0.01f, 0.01f, 0.01f);
@@ -374,6 +480,7 @@ namespace Engine
 		GuiData.Eye = &Eye;
 		GuiData.CameraMercatorPosition = &CameraSphericalPosition;
 		GuiData.Zoom = &Zoom;
+		GuiData.OnReloadModels = ReloadSceneModels;
 	}
 
 	void MoveCamera(GLFWwindow* Window, f32 DeltaTime, Camera& MainCamera)
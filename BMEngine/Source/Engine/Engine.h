@@ -2,5 +2,6 @@
 
 namespace Engine
 {
-	int Main();
+	// --benchmark-pipeline-cache builds startup pipelines with empty cache and with cache read from disk and logs both times
+	int Main(int ArgCount, char** Args);
 }
@@ -26,9 +26,13 @@ namespace TaskSystem
 	static std::atomic<bool> ShutdownFlag = false;
 	
 	static u32 ThreadPoolSize = 1;
+
+	static thread_local u32 CurrentWorkerIndex = 0;
 	
-	static void WorkerThread()
+	static void WorkerThread(u32 WorkerIndex)
 	{
+		CurrentWorkerIndex = WorkerIndex;
+
 		while (!ShutdownFlag.load())
 		{
 			Task CurrentTask;
@@ -60,7 +64,7 @@ namespace TaskSystem
 		
 		for (u32 i = 0; i < ThreadPoolSize; ++i)
 		{
-			WorkerThreads.emplace_back(WorkerThread);
+			WorkerThreads.emplace_back(WorkerThread, i + 1);
 		}
 	}
 	
@@ -92,6 +96,16 @@ namespace TaskSystem
 	{
 		ConcurencyEnabled.store(Enabled, std::memory_order_relaxed);
 	}
+
+	u32 GetWorkerCount()
+	{
+		return ThreadPoolSize;
+	}
+
+	u32 GetCurrentWorkerIndex()
+	{
+		return CurrentWorkerIndex;
+	}
 	
 	void AddTask(TaskFunction Function, TaskGroup* Group)
 	{
@@ -130,4 +144,20 @@ namespace TaskSystem
 
 		Group->TasksInGroup = 0;
 	}
+
+	void RunOnWorkers(TaskFunction Function, u32 WorkItemCount)
+	{
+		const u32 CallCount = WorkItemCount < ThreadPoolSize ? WorkItemCount : ThreadPoolSize;
+
+		TaskGroup Group;
+		Group.TasksInGroup = 0;
+
+		for (u32 i = 1; i < CallCount; ++i)
+		{
+			AddTask(Function, &Group);
+		}
+
+		Function();
+		WaitForGroup(&Group);
+	}
 }
\ No newline at end of file
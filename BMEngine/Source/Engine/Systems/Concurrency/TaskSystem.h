@@ -19,7 +19,14 @@ namespace TaskSystem
 	void DeInit();
 
 	void SetConcurencyEnabled(bool Enabled);
+	u32 GetWorkerCount();
+	// 1 + worker index inside pool threads, 0 on any other thread
+	u32 GetCurrentWorkerIndex();
 	
 	void AddTask(TaskFunction Function, TaskGroup* Group);
 	void WaitForGroup(TaskGroup* Group);
+
+	// Calls Function on calling thread and on helper tasks, one call per worker at most and per work item at most.
+	// Returns once every call is done. Function pulls work items itself and returns when none are left
+	void RunOnWorkers(TaskFunction Function, u32 WorkItemCount);
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "EngineResources.h"
 
 #include "Util/Util.h"
+#include "Util/Math.h"
 #include "Engine/Systems/Render/Render.h"
 #include "Engine/Systems/Render/TransferSystem.h"
+#include "Engine/Systems/Render/Residency.h"
+#include "Engine/Systems/Concurrency/TaskSystem.h"
 #include "Util/DefaultTextureData.h"
 #include <gli/gli.hpp>
 #include <glm/glm.hpp>
@@ -10,26 +13,105 @@
 
 namespace EngineResources
 {
+	struct ModelMeshEntry
+	{
+		u32 StaticMeshIndex;
+		u32 MaterialIndex;
+		// Maps quantized vertex positions to model space, applied before instance transform
+		glm::mat4 Dequantization;
+	};
+
+	// Model meshlets are uploaded without conversion
+	static_assert(sizeof(Util::Model3DMeshlet) == sizeof(RenderResources::Meshlet));
+
+	// Render resources of a model file, every request of the same path after the first one only adds instances
+	struct ModelAsset
+	{
+		Memory::DynamicHeapArray<ModelMeshEntry> Meshes;
+		// Render material of every model material, last one is used by meshes without material
+		Memory::DynamicHeapArray<u32> Materials;
+		// Scene entity of every instance
+		Memory::DynamicHeapArray<u32> Entities;
+		// Texture assets used by materials, each counted once in TextureAsset::ModelCount
+		Memory::DynamicHeapArray<u64> Textures;
+		bool IsCreated;
+	};
+
 	static std::unordered_map<u64, TextureAsset> TextureAssets;
+	static std::unordered_map<u64, ModelAsset> ModelAssets;
 	static std::queue<ModelLoadRequest> ModelLoadRequests;
 	static std::mutex ModelLoadMutex;
 
-	static u32 CreateTexture(const std::string& Path)
+	struct ModelLoadState
 	{
-		gli::texture Texture = gli::load(Path);
-		if (Texture.empty())
+		ModelLoadRequest Request;
+		ModelAsset* Asset;
+		Util::Model3DData ModelData;
+		Util::Model3D Model;
+		u32 NextMesh;
+		u64 VertexByteOffset;
+		u64 NextCompressedBlock;
+		// Block of some mesh failed to decode, load stops and created meshes are unloaded
+		bool HasFailed;
+		bool IsActive;
+		// Instance of every asset mesh, prepared in one batch when instantiation starts
+		Memory::DynamicHeapArray<RenderResources::InstanceData> Instances;
+	};
+
+	struct DecompressionJob
+	{
+		const Util::Model3DCompressedBlock* Blocks;
+		const u8* CompressedData;
+		u8* Dst;
+		u64 DstRawOffset;
+		u64 BlockCount;
+		std::atomic<u64> NextBlock;
+		std::atomic<bool> HasFailed;
+	};
+
+	// Vertex data moved per update
+	static const u64 MaxCompactionBytesPerUpdate = MB2;
+
+	// Model that was stopped by transfer backpressure and continues next update
+	static ModelLoadState CurrentModelLoad;
+	// Only loader touches it and loader runs under ModelLoadMutex
+	static DecompressionJob CurrentDecompression;
+
+	static u32 CreateTexture(const gli::texture& Texture)
+	{
+		const glm::tvec3<u32> Extent = Texture.extent();
+		const u32 MipLevels = (u32)Texture.levels();
+		// Cube faces are uploaded as regular array layers
+		const u32 ArrayLayers = (u32)(Texture.layers() * Texture.faces());
+
+		auto SubresourceOffsets = Memory::AllocateArray<u64>(MipLevels * ArrayLayers);
+		const u8* BaseData = (const u8*)Texture.data();
+
+		for (u64 Layer = 0; Layer < Texture.layers(); ++Layer)
 		{
-			assert(false);
+			for (u64 Face = 0; Face < Texture.faces(); ++Face)
+			{
+				for (u64 Level = 0; Level < Texture.levels(); ++Level)
+				{
+					const u64 Offset = (const u8*)Texture.data(Layer, Face, Level) - BaseData;
+					Memory::PushBackToArray(&SubresourceOffsets, &Offset);
+				}
+			}
 		}
 
-		const glm::tvec3<u32> Extent = Texture.extent();
-
 		RenderResources::TextureDescription TextureDescription;
 		TextureDescription.Width = Extent.x;
 		TextureDescription.Height = Extent.y;
+		TextureDescription.MipLevels = MipLevels;
+		TextureDescription.ArrayLayers = ArrayLayers;
 		TextureDescription.Format = Util::GliFormatToVkFormat(Texture.format());
+		TextureDescription.DataSize = Texture.size();
+		TextureDescription.SubresourceOffsets = SubresourceOffsets.Data;
+
+		const u32 TextureIndex = RenderResources::CreateTexture(&TextureDescription, (void*)Texture.data());
 
-		return RenderResources::CreateTexture(&TextureDescription, Texture.data());
+		Memory::FreeArray(&SubresourceOffsets);
+		return TextureIndex;
 	}
 
 	void Init()
@@ -41,24 +123,46 @@ namespace EngineResources
 			assert(false);
 		}
 		const u64 DefaultAssetId = std::hash<std::string>{ }("Default");
-		const glm::tvec3<u32> DefaultAssetExtent = DefaultTexture.extent();
-
-		RenderResources::TextureDescription DefaultTextureDescription;
-		DefaultTextureDescription.Width = DefaultAssetExtent.x;
-		DefaultTextureDescription.Height = DefaultAssetExtent.y;
-		DefaultTextureDescription.Format = Util::GliFormatToVkFormat(DefaultTexture.format());
 
 		TextureAsset DefaultAsset;
-		DefaultAsset.RenderTextureIndex = RenderResources::CreateTexture(&DefaultTextureDescription, DefaultTexture.data());
+		DefaultAsset.RenderTextureIndex = CreateTexture(DefaultTexture);
+		// Transfer system is empty on init
+		assert(DefaultAsset.RenderTextureIndex != RenderResources::InvalidIndex);
+		// Never destroyed
+		DefaultAsset.ModelCount = 1;
 		DefaultAsset.IsCreated = true;
 
 		TextureAssets[DefaultAssetId] = DefaultAsset;
+
+		CurrentModelLoad.Instances = Memory::AllocateArray<RenderResources::InstanceData>(64);
 	}
 
 	void DeInit()
 	{
 		TextureAssets.clear();
 
+		if (CurrentModelLoad.IsActive)
+		{
+			if (!CurrentModelLoad.Request.IsUnload && !CurrentModelLoad.Asset->IsCreated)
+			{
+				Util::ClearModel3DData(CurrentModelLoad.ModelData);
+			}
+
+			CurrentModelLoad.IsActive = false;
+		}
+
+		Memory::FreeArray(&CurrentModelLoad.Instances);
+
+		for (auto It = ModelAssets.begin(); It != ModelAssets.end(); ++It)
+		{
+			Memory::FreeArray(&It->second.Meshes);
+			Memory::FreeArray(&It->second.Materials);
+			Memory::FreeArray(&It->second.Entities);
+			Memory::FreeArray(&It->second.Textures);
+		}
+
+		ModelAssets.clear();
+
 		std::lock_guard Lock(ModelLoadMutex);
 		while (!ModelLoadRequests.empty())
 		{
@@ -66,87 +170,493 @@ namespace EngineResources
 		}
 	}
 
+	// Returns false when transfer system has no space for texture yet
+	static bool ResolveTexture(TextureAsset* Asset)
+	{
+		if (Asset->IsCreated)
+		{
+			return true;
+		}
+
+		gli::texture Texture = gli::load(Asset->TexturePath);
+		if (Texture.empty())
+		{
+			assert(false);
+		}
+
+		const u32 TextureIndex = CreateTexture(Texture);
+		if (TextureIndex == RenderResources::InvalidIndex)
+		{
+			return false;
+		}
+
+		Asset->RenderTextureIndex = TextureIndex;
+		Asset->IsCreated = true;
+		return true;
+	}
+
+	static void DecompressBlocks()
+	{
+		// Staging memory can be write combined, blocks are decoded to cached memory and copied once
+		thread_local static u8 Scratch[Util::Model3DCompressedBlockSize];
+
+		DecompressionJob* Job = &CurrentDecompression;
+		for (u64 i = Job->NextBlock.fetch_add(1); i < Job->BlockCount; i = Job->NextBlock.fetch_add(1))
+		{
+			const Util::Model3DCompressedBlock* Block = Job->Blocks + i;
+			u8* Dst = Job->Dst + (Block->RawOffset - Job->DstRawOffset);
+			const u8* Src = Job->CompressedData + Block->DataOffset;
+
+			if (Block->CompressedSize == Block->RawSize)
+			{
+				memcpy(Dst, Src, Block->RawSize);
+				continue;
+			}
+
+			// Reserved mesh is submitted anyway to keep transfer order, zeros are uploaded instead of Scratch leftovers
+			if (!Util::DecompressBlock(Src, Block->CompressedSize, Scratch, Block->RawSize))
+			{
+				memset(Dst, 0, Block->RawSize);
+				Job->HasFailed.store(true);
+				continue;
+			}
+
+			memcpy(Dst, Scratch, Block->RawSize);
+		}
+	}
+
+	// Decompresses mesh blocks straight into reserved transfer memory, blocks are shared between workers and loader.
+	// Returns RenderResources::InvalidIndex when transfer system is full
+	static u32 CreateCompressedStaticMesh(ModelLoadState* ModelLoad, RenderResources::MeshDescription* Mesh, u64 VertexDataSize)
+	{
+		const Util::Model3D& Model = ModelLoad->Model;
+
+		void* TransferMemory;
+		const u32 MeshIndex = RenderResources::ReserveStaticMesh(Mesh, &TransferMemory);
+		if (MeshIndex == RenderResources::InvalidIndex)
+		{
+			return MeshIndex;
+		}
+
+		const u64 FirstBlock = ModelLoad->NextCompressedBlock;
+		u64 LastBlock = FirstBlock;
+		while (LastBlock < Model.CompressedBlockCount &&
+			Model.CompressedBlocks[LastBlock].RawOffset < ModelLoad->VertexByteOffset + VertexDataSize)
+		{
+			++LastBlock;
+		}
+
+		DecompressionJob* Job = &CurrentDecompression;
+		Job->Blocks = Model.CompressedBlocks + FirstBlock;
+		Job->CompressedData = Model.CompressedData;
+		Job->Dst = (u8*)TransferMemory;
+		Job->DstRawOffset = ModelLoad->VertexByteOffset;
+		Job->BlockCount = LastBlock - FirstBlock;
+		Job->NextBlock.store(0);
+		Job->HasFailed.store(false);
+
+		TaskSystem::RunOnWorkers(DecompressBlocks, (u32)Job->BlockCount);
+
+		RenderResources::SubmitStaticMesh(MeshIndex, TransferMemory);
+
+		ModelLoad->NextCompressedBlock = LastBlock;
+		ModelLoad->HasFailed = Job->HasFailed.load();
+		return MeshIndex;
+	}
+
+	// Returns false when transfer system is full
+	static bool AddModelInstance(ModelLoadState* ModelLoad, const ModelMeshEntry* MeshEntry, RenderResources::InstanceData* Instance,
+		Render::DrawScene* TmpScene)
+	{
+		Render::DrawEntity Entity = { };
+		Entity.StaticMeshIndex = MeshEntry->StaticMeshIndex;
+		Entity.Instances = 1;
+		Entity.InstanceDataIndex = RenderResources::CreateStaticMeshInstance(Instance);
+		if (Entity.InstanceDataIndex == RenderResources::InvalidIndex)
+		{
+			return false;
+		}
+
+		std::unique_lock Lock(TmpScene->TempLock);
+		const u32 EntityIndex = (u32)TmpScene->DrawEntities.Count;
+		Memory::PushBackToArray(&TmpScene->DrawEntities, &Entity);
+		Memory::PushBackToArray(&ModelLoad->Asset->Entities, &EntityIndex);
+		return true;
+	}
+
+	// Mesh that stopped on transfer backpressure resolves the same textures again on retry
+	static void AddModelTexture(ModelAsset* Asset, u64 TextureId, TextureAsset* Texture)
+	{
+		for (u64 i = 0; i < Asset->Textures.Count; ++i)
+		{
+			if (Asset->Textures.Data[i] == TextureId)
+			{
+				return;
+			}
+		}
+
+		Memory::PushBackToArray(&Asset->Textures, &TextureId);
+		++Texture->ModelCount;
+	}
+
+	// Returns false when transfer system is full, continues from ModelLoad->NextMesh
+	static bool InstantiateModelAsset(ModelLoadState* ModelLoad, Render::DrawScene* TmpScene)
+	{
+		const ModelAsset* Asset = ModelLoad->Asset;
+
+		// Update that stopped on transfer backpressure keeps prepared instances
+		if (ModelLoad->Instances.Count != Asset->Meshes.Count)
+		{
+			Memory::ReserveArray(&ModelLoad->Instances, Asset->Meshes.Count);
+			ModelLoad->Instances.Count = Asset->Meshes.Count;
+
+			const glm::mat4 Translation = glm::translate(glm::mat4(1), ModelLoad->Request.Position);
+			for (u64 i = 0; i < Asset->Meshes.Count; ++i)
+			{
+				RenderResources::InstanceData* Instance = ModelLoad->Instances.Data + i;
+				Instance->MaterialIndex = Asset->Meshes.Data[i].MaterialIndex;
+				Instance->ModelMatrix = Translation * Asset->Meshes.Data[i].Dequantization;
+			}
+
+			RenderResources::ComputeNormalMatrices(ModelLoad->Instances.Data, ModelLoad->Instances.Count);
+		}
+
+		for (; ModelLoad->NextMesh < Asset->Meshes.Count; ++ModelLoad->NextMesh)
+		{
+			if (!AddModelInstance(ModelLoad, Asset->Meshes.Data + ModelLoad->NextMesh, ModelLoad->Instances.Data + ModelLoad->NextMesh, TmpScene))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Creates render mesh of ModelLoad->NextMesh and appends it to asset meshes. Returns false when transfer system
+	// or vertex buffer is full, only textures and material of the mesh may be created then
+	static bool CreateModelMesh(ModelLoadState* ModelLoad)
+	{
+		const Util::Model3D& Model = ModelLoad->Model;
+		ModelAsset* Asset = ModelLoad->Asset;
+
+		const u32 i = ModelLoad->NextMesh;
+
+		const u64 VerticesCount = Model.VerticesCounts[i];
+		const u32 IndicesCount = Model.IndicesCounts[i];
+
+		u32 AlbedoTextureIndex = 0;
+		u32 SpecularTextureIndex = 0;
+
+		const u32 ModelMaterialIndex = Model.Header.MaterialCount > 0 ? Model.MaterialIndices[i] : Model.Header.MaterialCount;
+		u32* RenderMaterialIndex = Asset->Materials.Data + ModelMaterialIndex;
+
+		if (*RenderMaterialIndex == UINT32_MAX && ModelMaterialIndex < Model.Header.MaterialCount)
+		{
+			const Util::Model3DMaterial& material = Model.Materials[ModelMaterialIndex];
+
+			auto it = TextureAssets.find(material.DiffuseTextureHash);
+			if (it != TextureAssets.end())
+			{
+				if (!ResolveTexture(&it->second))
+				{
+					return false;
+				}
+
+				AddModelTexture(Asset, it->first, &it->second);
+				AlbedoTextureIndex = it->second.RenderTextureIndex;
+				SpecularTextureIndex = AlbedoTextureIndex;
+			}
+
+			it = TextureAssets.find(material.SpecularTextureHash);
+			if (it != TextureAssets.end())
+			{
+				if (!ResolveTexture(&it->second))
+				{
+					return false;
+				}
+
+				AddModelTexture(Asset, it->first, &it->second);
+				SpecularTextureIndex = it->second.RenderTextureIndex;
+			}
+		}
+
+		const u32 IndexSize = Model.IndexSizes[i];
+		const u32 MeshletCount = Model.MeshletCounts[i];
+
+		// Meshlets follow indices and are uploaded with them
+		const u64 VertexDataSize = Util::GetModel3DMeshDataSize(Model, i);
+
+		// Meshes with the same model material share render material
+		if (*RenderMaterialIndex == UINT32_MAX)
+		{
+			RenderResources::Material Mat;
+			Mat.AlbedoTexIndex = AlbedoTextureIndex;
+			Mat.SpecularTexIndex = SpecularTextureIndex;
+			Mat.Shininess = 32.0f;
+
+			// Stays UINT32_MAX when transfer system is full, material is created again on retry
+			*RenderMaterialIndex = RenderResources::CreateMaterial(&Mat);
+			if (*RenderMaterialIndex == RenderResources::InvalidIndex)
+			{
+				return false;
+			}
+		}
+
+		RenderResources::MeshDescription Mesh;
+		Mesh.IndicesCount = IndicesCount;
+		Mesh.VertexSize = sizeof(StaticMeshVertex);
+		Mesh.VerticesCount = VerticesCount;
+		Mesh.IndexType = IndexSize == sizeof(u16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		Mesh.BoundingSphere = Model.MeshBounds[i].BoundingSphere;
+
+		const Util::Model3DMeshLods* ModelLods = Model.MeshLods + i;
+		RenderResources::MeshLod Lods[MAX_MESH_LODS];
+		for (u32 Lod = 0; Lod < ModelLods->LodCount; ++Lod)
+		{
+			Lods[Lod].FirstIndex = ModelLods->Lods[Lod].FirstIndex;
+			Lods[Lod].IndicesCount = ModelLods->Lods[Lod].IndexCount;
+			Lods[Lod].Error = ModelLods->Lods[Lod].Error;
+		}
+
+		Mesh.LodCount = ModelLods->LodCount;
+		Mesh.Lods = Lods;
+		Mesh.MeshletCount = MeshletCount;
+
+		u32 StaticMeshIndex;
+		if (Model.VertexData != nullptr)
+		{
+			StaticMeshIndex = RenderResources::CreateStaticMesh(&Mesh, Model.VertexData + ModelLoad->VertexByteOffset);
+		}
+		else
+		{
+			StaticMeshIndex = CreateCompressedStaticMesh(ModelLoad, &Mesh, VertexDataSize);
+		}
+
+		if (StaticMeshIndex == RenderResources::InvalidIndex)
+		{
+			return false;
+		}
+
+		const glm::vec4 Dequantization = Model.MeshBounds[i].Dequantization;
+
+		ModelMeshEntry* MeshEntry = Memory::ArrayGetNew(&Asset->Meshes);
+		MeshEntry->StaticMeshIndex = StaticMeshIndex;
+		MeshEntry->MaterialIndex = *RenderMaterialIndex;
+		MeshEntry->Dequantization = glm::scale(glm::translate(glm::mat4(1), glm::vec3(Dequantization)), glm::vec3(Dequantization.w));
+
+		ModelLoad->VertexByteOffset += VertexDataSize;
+
+		return true;
+	}
+
+	// Returns false when transfer system is full, load continues from ModelLoad->NextMesh.
+	// Stops with ModelLoad->HasFailed on decode error
+	static bool LoadModelMeshes(ModelLoadState* ModelLoad)
+	{
+		for (; ModelLoad->NextMesh < ModelLoad->Model.Header.MeshCount; ++ModelLoad->NextMesh)
+		{
+			if (!CreateModelMesh(ModelLoad))
+			{
+				return false;
+			}
+
+			if (ModelLoad->HasFailed)
+			{
+				return true;
+			}
+		}
+
+		return true;
+	}
+
+	// Returns false while any resource of model is still uploading, it is retried next update.
+	// Materials stay in material buffer, it is append only
+	static bool UnloadModelAsset(const std::string& Path, Render::DrawScene* TmpScene)
+	{
+		auto AssetIt = ModelAssets.find(std::hash<std::string>{ }(Path));
+		if (AssetIt == ModelAssets.end())
+		{
+			return true;
+		}
+
+		ModelAsset* Asset = &AssetIt->second;
+
+		std::unique_lock Lock(TmpScene->TempLock);
+
+		for (u64 i = 0; i < Asset->Entities.Count; ++i)
+		{
+			const Render::DrawEntity* Entity = TmpScene->DrawEntities.Data + Asset->Entities.Data[i];
+			for (u32 j = 0; j < Entity->Instances; ++j)
+			{
+				if (!RenderResources::IsResourceLoaded(Entity->InstanceDataIndex + j, RenderResources::ResourceType::Instance))
+				{
+					return false;
+				}
+			}
+		}
+
+		for (u64 i = 0; i < Asset->Meshes.Count; ++i)
+		{
+			if (!RenderResources::IsResourceLoaded(Asset->Meshes.Data[i].StaticMeshIndex, RenderResources::ResourceType::Mesh))
+			{
+				return false;
+			}
+		}
+
+		for (u64 i = 0; i < Asset->Textures.Count; ++i)
+		{
+			const TextureAsset* Texture = &TextureAssets[Asset->Textures.Data[i]];
+			if (Texture->ModelCount == 1 && !RenderResources::IsResourceLoaded(Texture->RenderTextureIndex, RenderResources::ResourceType::Texture))
+			{
+				return false;
+			}
+		}
+
+		for (u64 i = 0; i < Asset->Entities.Count; ++i)
+		{
+			const u32 EntityIndex = Asset->Entities.Data[i];
+			const Render::DrawEntity* Entity = TmpScene->DrawEntities.Data + EntityIndex;
+
+			Residency::OnEntityRemoved(EntityIndex);
+			for (u32 j = 0; j < Entity->Instances; ++j)
+			{
+				RenderResources::DestroyStaticMeshInstance(Entity->InstanceDataIndex + j);
+			}
+		}
+
+		Lock.unlock();
+
+		// Freed vertex ranges let CompactStaticMeshes merge free space
+		for (u64 i = 0; i < Asset->Meshes.Count; ++i)
+		{
+			RenderResources::DestroyStaticMesh(Asset->Meshes.Data[i].StaticMeshIndex);
+		}
+
+		for (u64 i = 0; i < Asset->Textures.Count; ++i)
+		{
+			TextureAsset* Texture = &TextureAssets[Asset->Textures.Data[i]];
+			if (--Texture->ModelCount == 0)
+			{
+				RenderResources::DestroyTexture(Texture->RenderTextureIndex);
+				Texture->IsCreated = false;
+			}
+		}
+
+		Memory::FreeArray(&Asset->Meshes);
+		Memory::FreeArray(&Asset->Materials);
+		Memory::FreeArray(&Asset->Entities);
+		Memory::FreeArray(&Asset->Textures);
+		ModelAssets.erase(AssetIt);
+
+		return true;
+	}
+
 	void Update(Render::DrawScene* TmpScene)
 	{
 		std::lock_guard Lock(ModelLoadMutex);
-		while (!ModelLoadRequests.empty())
+		while (true)
 		{
-			ModelLoadRequest Request = ModelLoadRequests.front();
-			ModelLoadRequests.pop();
+			if (!CurrentModelLoad.IsActive)
+			{
+				if (ModelLoadRequests.empty())
+				{
+					break;
+				}
 
-			Util::Model3DData ModelData = Util::LoadModel3DData(Request.Path.c_str());
-			Util::Model3D Model = Util::ParseModel3D(ModelData);
+				CurrentModelLoad.Request = ModelLoadRequests.front();
+				ModelLoadRequests.pop();
 
-			u64 ModelVertexByteOffset = 0;
-			for (u32 i = 0; i < Model.Header.MeshCount; i++)
-			{
-				const u64 VerticesCount = Model.VerticesCounts[i];
-				const u32 IndicesCount = Model.IndicesCounts[i];
+				CurrentModelLoad.IsActive = true;
+				if (CurrentModelLoad.Request.IsUnload)
+				{
+					continue;
+				}
 
-				u32 AlbedoTextureIndex = 0;
-				u32 SpecularTextureIndex = 0;
+				const u64 AssetId = std::hash<std::string>{ }(CurrentModelLoad.Request.Path);
+				CurrentModelLoad.Asset = &ModelAssets[AssetId];
+				CurrentModelLoad.NextMesh = 0;
+				Memory::ClearArray(&CurrentModelLoad.Instances);
 
-				if (Model.Header.MaterialCount > 0)
+				// Requests are served one by one, so asset is either created or seen for the first time
+				if (!CurrentModelLoad.Asset->IsCreated)
 				{
-					const u32 MaterialIndex = Model.MaterialIndices[i];
-					const Util::Model3DMaterial& material = Model.Materials[MaterialIndex];
+					const char* Path = CurrentModelLoad.Request.Path.c_str();
 
-					auto it = TextureAssets.find(material.DiffuseTextureHash);
-					if (it != TextureAssets.end())
+					u64 DataSize;
+					CurrentModelLoad.ModelData = Util::LoadModel3DData(Path, &DataSize);
+					if (CurrentModelLoad.ModelData == nullptr)
 					{
-						if (!it->second.IsCreated)
-						{
-							it->second.RenderTextureIndex = CreateTexture(it->second.TexturePath);
-							it->second.IsCreated = true;
-						}
-
-						AlbedoTextureIndex = it->second.RenderTextureIndex;
-						SpecularTextureIndex = AlbedoTextureIndex;
+						Util::RenderLog(Util::LogType::Warning, "Failed to read model %s", Path);
+						ModelAssets.erase(AssetId);
+						CurrentModelLoad.IsActive = false;
+						continue;
 					}
 
-					it = TextureAssets.find(material.SpecularTextureHash);
-					if (it != TextureAssets.end())
+					if (!Util::ParseModel3D(CurrentModelLoad.ModelData, DataSize, &CurrentModelLoad.Model))
 					{
-						if (!it->second.IsCreated)
-						{
-							it->second.RenderTextureIndex = CreateTexture(it->second.TexturePath);
-							it->second.IsCreated = true;
-						}
-
-						SpecularTextureIndex = it->second.RenderTextureIndex;
+						Util::RenderLog(Util::LogType::Warning, "Model %s is corrupted, load is skipped", Path);
+						Util::ClearModel3DData(CurrentModelLoad.ModelData);
+						ModelAssets.erase(AssetId);
+						CurrentModelLoad.IsActive = false;
+						continue;
 					}
-				}
 
-				const u64 VertexDataSize = VerticesCount * sizeof(StaticMeshVertex) + IndicesCount * sizeof(u32);
-
-				RenderResources::Material Mat;
-				Mat.AlbedoTexIndex = AlbedoTextureIndex;
-				Mat.SpecularTexIndex = SpecularTextureIndex;
-				Mat.Shininess = 32.0f;
+					CurrentModelLoad.VertexByteOffset = 0;
+					CurrentModelLoad.NextCompressedBlock = 0;
+					CurrentModelLoad.HasFailed = false;
+
+					const u32 MaterialCount = CurrentModelLoad.Model.Header.MaterialCount + 1;
+					CurrentModelLoad.Asset->Meshes = Memory::AllocateArray<ModelMeshEntry>(CurrentModelLoad.Model.Header.MeshCount + 1);
+					CurrentModelLoad.Asset->Materials = Memory::AllocateArray<u32>(MaterialCount);
+					CurrentModelLoad.Asset->Materials.Count = MaterialCount;
+					memset(CurrentModelLoad.Asset->Materials.Data, 0xFF, MaterialCount * sizeof(u32));
+					CurrentModelLoad.Asset->Entities = Memory::AllocateArray<u32>(CurrentModelLoad.Model.Header.MeshCount + 1);
+					CurrentModelLoad.Asset->Textures = Memory::AllocateArray<u64>(MaterialCount * 2);
+				}
+			}
 
-				RenderResources::InstanceData Instance;
-				Instance.MaterialIndex = RenderResources::CreateMaterial(&Mat);
-				Instance.ModelMatrix = glm::translate(glm::mat4(1), Request.Position);
+			if (CurrentModelLoad.Request.IsUnload)
+			{
+				if (!UnloadModelAsset(CurrentModelLoad.Request.Path, TmpScene))
+				{
+					break;
+				}
+			}
+			else
+			{
+				if (!CurrentModelLoad.Asset->IsCreated)
+				{
+					if (!LoadModelMeshes(&CurrentModelLoad))
+					{
+						break;
+					}
 
-				RenderResources::MeshDescription Mesh;
-				Mesh.IndicesCount = IndicesCount;
-				Mesh.VertexSize = sizeof(StaticMeshVertex);
-				Mesh.VerticesCount = VerticesCount;
+					Util::ClearModel3DData(CurrentModelLoad.ModelData);
+					CurrentModelLoad.Asset->IsCreated = true;
 
-				Render::DrawEntity Entity = { };
-				Entity.StaticMeshIndex = RenderResources::CreateStaticMesh(&Mesh, Model.VertexData + ModelVertexByteOffset);
-				Entity.Instances = 1;
-				Entity.InstanceDataIndex = RenderResources::CreateStaticMeshInstance(&Instance);
+					// Whole model fails, meshes created so far are removed once their uploads finish
+					if (CurrentModelLoad.HasFailed)
+					{
+						Util::RenderLog(Util::LogType::Warning, "Model %s has corrupted vertex data, created meshes are unloaded", CurrentModelLoad.Request.Path.c_str());
+						CurrentModelLoad.Request.IsUnload = true;
+						continue;
+					}
 
-				std::unique_lock Lock(TmpScene->TempLock);
-				Memory::PushBackToArray(&TmpScene->DrawEntities, &Entity);
-				Lock.unlock();
+					// New asset gets its instances the same way as already created one
+					CurrentModelLoad.NextMesh = 0;
+				}
 
-				ModelVertexByteOffset += VertexDataSize;
+				if (!InstantiateModelAsset(&CurrentModelLoad, TmpScene))
+				{
+					break;
+				}
 			}
 
-			Util::ClearModel3DData(ModelData);
+			CurrentModelLoad.IsActive = false;
 		}
+
+		// Returns right away unless vertex buffer is fragmented, mesh that found no vertex range is retried after free space is merged
+		RenderResources::CompactStaticMeshes(MaxCompactionBytesPerUpdate);
 	}
 
 	void RegisterTextureAsset(const std::string& Name, const std::string& Path)
@@ -154,6 +664,7 @@ namespace EngineResources
 		TextureAsset Asset;
 		Asset.TexturePath = Path;
 		Asset.RenderTextureIndex = 0;
+		Asset.ModelCount = 0;
 		Asset.IsCreated = false;
 
 		TextureAssets[std::hash<std::string>{ }(Name)] = Asset;
@@ -164,4 +675,15 @@ namespace EngineResources
 		std::lock_guard Lock(ModelLoadMutex);
 		ModelLoadRequests.push(Request);
 	}
+
+	void RequestModelUnload(const std::string& Path)
+	{
+		ModelLoadRequest Request;
+		Request.Position = glm::vec3(0.0f);
+		Request.Path = Path;
+		Request.IsUnload = true;
+
+		std::lock_guard Lock(ModelLoadMutex);
+		ModelLoadRequests.push(Request);
+	}
 }
\ No newline at end of file
@@ -14,17 +14,23 @@ namespace Render
 
 namespace EngineResources
 {
+	// Quantized vertex written by Util::ObjToModel3D
 	struct StaticMeshVertex
 	{
-		glm::vec3 Position;
-		glm::vec2 TextureCoords;
-		glm::vec3 Normal;
+		// Unorm inside mesh bounds, see Util::Model3DMeshBounds, w is padding
+		u16 Position[4];
+		// Half floats
+		u16 TextureCoords[2];
+		// Octahedral encoded unit vector, snorm
+		s16 Normal[2];
 	};
 
 	struct TextureAsset
 	{
 		std::string TexturePath;
 		u32 RenderTextureIndex;
+		// Models whose materials use texture, render texture is destroyed when last of them is unloaded
+		u32 ModelCount;
 		bool IsCreated;
 	};
 
@@ -32,6 +38,8 @@ namespace EngineResources
 	{
 		glm::vec3 Position;
 		std::string Path;
+		// Set by RequestModelUnload, model at Path is destroyed instead
+		bool IsUnload = false;
 	};
 
 	void Init();
@@ -41,4 +49,6 @@ namespace EngineResources
 
 	void RegisterTextureAsset(const std::string& Name, const std::string& Path);
 	void RequestModelLoad(const ModelLoadRequest& Request);
+	// Destroys every instance of model, its meshes and textures that no other model uses. Served in order with loads
+	void RequestModelUnload(const std::string& Path);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "MemoryManagmentSystem.h"
 
 #include <mutex>
+#include <cstring>
 
 namespace Memory
 {
@@ -99,4 +100,189 @@ namespace Memory
 	{
 		Memory->Head = Memory->Base;
 	}
+
+	static void RemoveFreeRange(RangeAllocator* Allocator, u64 Index)
+	{
+		DynamicHeapArray<FreeRange>* Ranges = &Allocator->FreeRanges;
+		memmove(Ranges->Data + Index, Ranges->Data + Index + 1, (Ranges->Count - Index - 1) * sizeof(FreeRange));
+		--Ranges->Count;
+	}
+
+	static void InsertFreeRange(RangeAllocator* Allocator, u64 Index, u64 Offset, u64 Size)
+	{
+		DynamicHeapArray<FreeRange>* Ranges = &Allocator->FreeRanges;
+		ArrayGetNew(Ranges);
+		memmove(Ranges->Data + Index + 1, Ranges->Data + Index, (Ranges->Count - Index - 1) * sizeof(FreeRange));
+		Ranges->Data[Index] = { Offset, Size };
+	}
+
+	// Takes Size units at Offset from free range with Index
+	static void SplitFreeRange(RangeAllocator* Allocator, u64 Index, u64 Offset, u64 Size)
+	{
+		FreeRange* Range = Allocator->FreeRanges.Data + Index;
+		assert(Offset >= Range->Offset && Offset + Size <= Range->Offset + Range->Size);
+
+		const u64 HeadSize = Offset - Range->Offset;
+		const u64 TailSize = Range->Offset + Range->Size - (Offset + Size);
+
+		if (HeadSize == 0 && TailSize == 0)
+		{
+			RemoveFreeRange(Allocator, Index);
+		}
+		else if (HeadSize == 0)
+		{
+			Range->Offset += Size;
+			Range->Size = TailSize;
+		}
+		else
+		{
+			Range->Size = HeadSize;
+			if (TailSize != 0)
+			{
+				InsertFreeRange(Allocator, Index + 1, Offset + Size, TailSize);
+			}
+		}
+
+		Allocator->Used += Size;
+	}
+
+	RangeAllocator CreateRangeAllocator(u64 Capacity, u64 Granularity)
+	{
+		assert(Granularity != 0 && (Granularity & (Granularity - 1)) == 0);
+
+		RangeAllocator Allocator = { };
+		Allocator.Capacity = Capacity - Capacity % Granularity;
+		Allocator.Granularity = Granularity;
+		Allocator.Used = 0;
+		Allocator.FreeRanges = AllocateArray<FreeRange>(64);
+
+		const FreeRange WholeRange = { 0, Allocator.Capacity };
+		PushBackToArray(&Allocator.FreeRanges, &WholeRange);
+
+		return Allocator;
+	}
+
+	void DestroyRangeAllocator(RangeAllocator* Allocator)
+	{
+		FreeArray(&Allocator->FreeRanges);
+		*Allocator = { };
+	}
+
+	bool RangeAlloc(RangeAllocator* Allocator, u64 Size, u64* OutOffset)
+	{
+		assert(Size != 0);
+		Size = Math::AlignNumber(Size, Allocator->Granularity);
+
+		u64 BestIndex = UINT64_MAX;
+		for (u64 i = 0; i < Allocator->FreeRanges.Count; ++i)
+		{
+			const FreeRange* Range = Allocator->FreeRanges.Data + i;
+			if (Range->Size >= Size && (BestIndex == UINT64_MAX || Range->Size < Allocator->FreeRanges.Data[BestIndex].Size))
+			{
+				BestIndex = i;
+				if (Range->Size == Size)
+				{
+					break;
+				}
+			}
+		}
+
+		if (BestIndex == UINT64_MAX)
+		{
+			return false;
+		}
+
+		*OutOffset = Allocator->FreeRanges.Data[BestIndex].Offset;
+		SplitFreeRange(Allocator, BestIndex, *OutOffset, Size);
+		return true;
+	}
+
+	bool RangeAllocBelow(RangeAllocator* Allocator, u64 Size, u64 Limit, u64* OutOffset)
+	{
+		assert(Size != 0);
+		Size = Math::AlignNumber(Size, Allocator->Granularity);
+
+		for (u64 i = 0; i < Allocator->FreeRanges.Count; ++i)
+		{
+			const FreeRange* Range = Allocator->FreeRanges.Data + i;
+			if (Range->Offset + Size > Limit)
+			{
+				break;
+			}
+
+			if (Range->Size >= Size)
+			{
+				*OutOffset = Range->Offset;
+				SplitFreeRange(Allocator, i, *OutOffset, Size);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void RangeFree(RangeAllocator* Allocator, u64 Offset, u64 Size)
+	{
+		assert(Size != 0);
+		Size = Math::AlignNumber(Size, Allocator->Granularity);
+		assert(Offset % Allocator->Granularity == 0 && Offset + Size <= Allocator->Capacity);
+		assert(Size <= Allocator->Used);
+
+		DynamicHeapArray<FreeRange>* Ranges = &Allocator->FreeRanges;
+
+		// First free range after freed one
+		u64 Low = 0;
+		u64 High = Ranges->Count;
+		while (Low < High)
+		{
+			const u64 Middle = (Low + High) / 2;
+			if (Ranges->Data[Middle].Offset < Offset)
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+
+		const u64 Next = Low;
+		assert(Next == Ranges->Count || Offset + Size <= Ranges->Data[Next].Offset);
+		assert(Next == 0 || Ranges->Data[Next - 1].Offset + Ranges->Data[Next - 1].Size <= Offset);
+
+		const bool MergePrevious = Next > 0 && Ranges->Data[Next - 1].Offset + Ranges->Data[Next - 1].Size == Offset;
+		const bool MergeNext = Next < Ranges->Count && Offset + Size == Ranges->Data[Next].Offset;
+
+		if (MergePrevious && MergeNext)
+		{
+			Ranges->Data[Next - 1].Size += Size + Ranges->Data[Next].Size;
+			RemoveFreeRange(Allocator, Next);
+		}
+		else if (MergePrevious)
+		{
+			Ranges->Data[Next - 1].Size += Size;
+		}
+		else if (MergeNext)
+		{
+			Ranges->Data[Next].Offset = Offset;
+			Ranges->Data[Next].Size += Size;
+		}
+		else
+		{
+			InsertFreeRange(Allocator, Next, Offset, Size);
+		}
+
+		Allocator->Used -= Size;
+	}
+
+	u64 RangeLargestFree(const RangeAllocator* Allocator)
+	{
+		u64 Largest = 0;
+		for (u64 i = 0; i < Allocator->FreeRanges.Count; ++i)
+		{
+			Largest = Allocator->FreeRanges.Data[i].Size > Largest ? Allocator->FreeRanges.Data[i].Size : Largest;
+		}
+
+		return Largest;
+	}
 }
\ No newline at end of file
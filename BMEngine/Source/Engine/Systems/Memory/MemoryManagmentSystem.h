@@ -59,6 +59,32 @@ namespace Memory
 		RingBufferControl ControlBlock;
 	};
 
+	struct FreeRange
+	{
+		u64 Offset;
+		u64 Size;
+	};
+
+	// Offsets and sizes are in abstract units, every request is rounded up to Granularity
+	struct RangeAllocator
+	{
+		// Sorted by offset, neighbours are always merged
+		DynamicHeapArray<FreeRange> FreeRanges;
+		u64 Capacity;
+		u64 Granularity;
+		u64 Used;
+	};
+
+	RangeAllocator CreateRangeAllocator(u64 Capacity, u64 Granularity);
+	void DestroyRangeAllocator(RangeAllocator* Allocator);
+
+	// Best fit, returns false when no free range is large enough
+	bool RangeAlloc(RangeAllocator* Allocator, u64 Size, u64* OutOffset);
+	// First fit from the lowest offset, allocated range ends not after Limit
+	bool RangeAllocBelow(RangeAllocator* Allocator, u64 Size, u64 Limit, u64* OutOffset);
+	void RangeFree(RangeAllocator* Allocator, u64 Offset, u64 Size);
+	u64 RangeLargestFree(const RangeAllocator* Allocator);
+
 	template <typename T>
 	static DynamicHeapArray<T> AllocateArray(u64 Count)
 	{
@@ -97,6 +123,19 @@ namespace Memory
 		Array->Capacity = NewCapacity;
 	}
 
+	// Grows capacity to at least Capacity elements, content is kept
+	template <typename T>
+	static void ReserveArray(DynamicHeapArray<T>* Array, u64 Capacity)
+	{
+		assert(Array->Capacity != 0);
+
+		if (Array->Capacity < Capacity)
+		{
+			Array->Data = static_cast<T*>(realloc(Array->Data, Capacity * sizeof(T)));
+			Array->Capacity = Capacity;
+		}
+	}
+
 	template <typename T>
 	static void PushBackToArray(DynamicHeapArray<T>* Array, const T* NewElement)
 	{
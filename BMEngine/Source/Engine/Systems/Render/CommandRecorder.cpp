@@ -0,0 +1,165 @@
+#include "CommandRecorder.h"
+
+#include "Render.h"
+#include "Engine/Systems/Concurrency/TaskSystem.h"
+
+#include <atomic>
+#include <cstdlib>
+
+namespace CommandRecorder
+{
+	static const u32 MaxBuffersPerPool = 16;
+
+	struct WorkerPool
+	{
+		VkCommandPool Pool;
+		VkCommandBuffer Buffers[MaxBuffersPerPool];
+		u32 AllocatedCount;
+		u32 UsedCount;
+	};
+
+	struct RecorderState
+	{
+		// PoolsPerFrame pools of every frame, indexed with TaskSystem::GetCurrentWorkerIndex
+		WorkerPool* Pools;
+		u32 PoolsPerFrame;
+		u32 CurrentFrame;
+
+		RecordTask* Tasks;
+		u32 TaskCount;
+		std::atomic<u32> NextTask;
+	};
+
+	static RecorderState Recorder;
+
+	void Init()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		Recorder.PoolsPerFrame = TaskSystem::GetWorkerCount() + 1;
+		Recorder.CurrentFrame = 0;
+
+		const u32 PoolCount = Recorder.PoolsPerFrame * VulkanHelper::MAX_DRAW_FRAMES;
+		Recorder.Pools = (WorkerPool*)malloc(PoolCount * sizeof(WorkerPool));
+
+		VkCommandPoolCreateInfo PoolInfo = { };
+		PoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		// Buffers are reset together with pool
+		PoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		PoolInfo.queueFamilyIndex = VulkanInterface::GetQueueGraphicsFamilyIndex();
+
+		for (u32 i = 0; i < PoolCount; ++i)
+		{
+			WorkerPool* Pool = Recorder.Pools + i;
+			VULKAN_CHECK_RESULT(vkCreateCommandPool(Device, &PoolInfo, nullptr, &Pool->Pool));
+			Pool->AllocatedCount = 0;
+			Pool->UsedCount = 0;
+		}
+	}
+
+	void DeInit()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		const u32 PoolCount = Recorder.PoolsPerFrame * VulkanHelper::MAX_DRAW_FRAMES;
+		for (u32 i = 0; i < PoolCount; ++i)
+		{
+			vkDestroyCommandPool(Device, Recorder.Pools[i].Pool, nullptr);
+		}
+
+		free(Recorder.Pools);
+	}
+
+	void BeginFrame(u32 Frame)
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		Recorder.CurrentFrame = Frame;
+
+		WorkerPool* FramePools = Recorder.Pools + Frame * Recorder.PoolsPerFrame;
+		for (u32 i = 0; i < Recorder.PoolsPerFrame; ++i)
+		{
+			WorkerPool* Pool = FramePools + i;
+			if (Pool->UsedCount == 0)
+			{
+				continue;
+			}
+
+			VULKAN_CHECK_RESULT(vkResetCommandPool(Device, Pool->Pool, 0));
+			Pool->UsedCount = 0;
+		}
+	}
+
+	static VkCommandBuffer AcquireBuffer(WorkerPool* Pool)
+	{
+		assert(Pool->UsedCount < MaxBuffersPerPool);
+
+		if (Pool->UsedCount == Pool->AllocatedCount)
+		{
+			VkCommandBufferAllocateInfo AllocateInfo = { };
+			AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			AllocateInfo.commandPool = Pool->Pool;
+			AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			AllocateInfo.commandBufferCount = 1;
+
+			VULKAN_CHECK_RESULT(vkAllocateCommandBuffers(VulkanInterface::GetDevice(), &AllocateInfo, Pool->Buffers + Pool->AllocatedCount));
+			++Pool->AllocatedCount;
+		}
+
+		return Pool->Buffers[Pool->UsedCount++];
+	}
+
+	static void RecordTaskBuffer(WorkerPool* Pool, RecordTask* Task)
+	{
+		const VulkanHelper::AttachmentData* Attachments = Task->Attachments;
+
+		VkCommandBufferInheritanceRenderingInfo RenderingInfo = { };
+		RenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		RenderingInfo.viewMask = 0;
+		RenderingInfo.colorAttachmentCount = Attachments->ColorAttachmentCount;
+		RenderingInfo.pColorAttachmentFormats = Attachments->ColorAttachmentFormats;
+		RenderingInfo.depthAttachmentFormat = Attachments->DepthAttachmentFormat;
+		RenderingInfo.stencilAttachmentFormat = Attachments->StencilAttachmentFormat;
+		RenderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkCommandBufferInheritanceInfo InheritanceInfo = { };
+		InheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		InheritanceInfo.pNext = &RenderingInfo;
+
+		VkCommandBufferBeginInfo BeginInfo = { };
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		BeginInfo.pInheritanceInfo = &InheritanceInfo;
+
+		VkCommandBuffer CmdBuffer = AcquireBuffer(Pool);
+		VULKAN_CHECK_RESULT(vkBeginCommandBuffer(CmdBuffer, &BeginInfo));
+
+		Task->Function(CmdBuffer, Task->Argument);
+
+		VULKAN_CHECK_RESULT(vkEndCommandBuffer(CmdBuffer));
+		Task->CmdBuffer = CmdBuffer;
+	}
+
+	static void RecordTasks()
+	{
+		// Pool is only touched by thread it belongs to
+		const u32 WorkerIndex = TaskSystem::GetCurrentWorkerIndex();
+		assert(WorkerIndex < Recorder.PoolsPerFrame);
+
+		WorkerPool* Pool = Recorder.Pools + Recorder.CurrentFrame * Recorder.PoolsPerFrame + WorkerIndex;
+
+		for (u32 i = Recorder.NextTask.fetch_add(1); i < Recorder.TaskCount; i = Recorder.NextTask.fetch_add(1))
+		{
+			RecordTaskBuffer(Pool, Recorder.Tasks + i);
+		}
+	}
+
+	void Record(RecordTask* Tasks, u32 Count)
+	{
+		Recorder.Tasks = Tasks;
+		Recorder.TaskCount = Count;
+		Recorder.NextTask.store(0);
+
+		TaskSystem::RunOnWorkers(RecordTasks, Count);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+#include "VulkanHelper.h"
+
+#include <vulkan/vulkan.h>
+
+namespace CommandRecorder
+{
+	typedef void (*RecordFunction)(VkCommandBuffer CmdBuffer, u32 Argument);
+
+	struct RecordTask
+	{
+		RecordFunction Function;
+		u32 Argument;
+		// Formats of dynamic rendering that executes recorded buffer
+		const VulkanHelper::AttachmentData* Attachments;
+		// Secondary command buffer filled by Record
+		VkCommandBuffer CmdBuffer;
+	};
+
+	void Init();
+	void DeInit();
+
+	// Resets command pools of Frame, previous submit of Frame has to be finished
+	void BeginFrame(u32 Frame);
+
+	// Records every task into its own secondary command buffer with TaskSystem jobs, every worker allocates from
+	// its own pool. Rendering that executes them has to begin with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+	void Record(RecordTask* Tasks, u32 Count);
+}
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include "CullingPass.h"
+
+#include "Render.h"
+#include "RenderResources.h"
+#include "InstanceBatcher.h"
+#include "FrustumCulling.h"
+#include "VulkanHelper.h"
+#include "DeviceMemoryAllocator.h"
+
+#include "Util/Math.h"
+#include "Util/Util.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace CullingPass
+{
+	// CullMeshlets reads normal matrix columns as floats 17 to 25 of instance
+	static_assert(offsetof(RenderResources::InstanceData, NormalMatrix) == 17 * sizeof(f32));
+
+	struct CullFrameBuffers
+	{
+		// Host written view planes, batches, batch index of every batched instance and instances that draw meshlets
+		VkBuffer Input;
+		VulkanHelper::DeviceMemoryAllocation InputAllocation;
+		// Draw count, commands and visible counters of every view
+		VkBuffer Output;
+		VulkanHelper::DeviceMemoryAllocation OutputAllocation;
+		VkDescriptorSet Set;
+	};
+
+	static const u32 PlanesPerView = 6;
+	static const u32 WorkGroupSize = 64;
+	// Output view starts with draw counts of 16 and 32 bit index batch draws and then meshlet draws
+	static const u32 OutputCommandsWordOffset = 4;
+	static const u32 OutputMeshletCountsWordOffset = 2;
+	static const u32 IndexTypeCount = 2;
+	static const u32 CommandWords = sizeof(VkDrawIndexedIndirectCommand) / sizeof(u32);
+	// Meshes with less meshlets are drawn whole, per meshlet draws don't pay off for them
+	static const u32 MinCulledMeshlets = 4;
+	// Meshlet draws of every view, batches that can't fit are drawn whole
+	static const u32 MaxMeshletDrawCount = 32768;
+
+	struct CullingState
+	{
+		CullFrameBuffers Frames[VulkanHelper::MAX_DRAW_FRAMES];
+
+		VkDescriptorSetLayout Layout;
+		VkPipelineLayout PipelineLayout;
+		VkPipeline CullPipeline;
+		VkPipeline EmitPipeline;
+		VkPipeline MeshletPipeline;
+
+		u64 BatchesOffset;
+		u64 InstanceBatchesOffset;
+		u64 MeshletInstancesOffset;
+		u64 InputSize;
+		// In u32 words
+		u32 OutputViewStride;
+		u32 MaxDrawCount;
+		// Batches of every index type in dispatched frame, 16 bit first
+		u32 IndexTypeBatchCounts[IndexTypeCount];
+		// Upper bound of meshlet draws of every index type in dispatched frame
+		u32 IndexTypeMeshletDrawCounts[IndexTypeCount];
+		u32 MeshletCommandsOffset;
+		u32 DispatchedFrame;
+		bool Enabled;
+	};
+
+	static CullingState Culling;
+
+	static VkPipeline CreateComputePipeline(VkDevice Device, const char* ShaderName)
+	{
+		VkPipelineShaderStageCreateInfo StageInfo = { };
+		StageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		StageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		StageInfo.module = RenderResources::GetShader(ShaderName);
+		StageInfo.pName = "main";
+
+		VkComputePipelineCreateInfo PipelineInfo = { };
+		PipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		PipelineInfo.stage = StageInfo;
+		PipelineInfo.layout = Culling.PipelineLayout;
+
+		VkPipeline Pipeline;
+		VULKAN_CHECK_RESULT(vkCreateComputePipelines(Device, RenderResources::GetPipelineCache(), 1, &PipelineInfo, nullptr, &Pipeline));
+		return Pipeline;
+	}
+
+	void Init()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		Culling.Enabled = RenderResources::GetCoreContext()->IsDrawIndirectCountSupported;
+		Culling.DispatchedFrame = 0;
+		if (!Culling.Enabled)
+		{
+			Util::RenderLog(Util::LogType::Warning, "vkCmdDrawIndexedIndirectCount is not supported, GPU culling is disabled");
+			return;
+		}
+
+		const u32 MaxInstances = RenderResources::GetMaxMeshInstances();
+		// Every instance can end up in its own batch
+		Culling.MaxDrawCount = MaxInstances;
+
+		const u64 PlanesSize = MAX_DRAW_VIEWS * PlanesPerView * sizeof(glm::vec4);
+		const u64 StorageOffsetAlignment = RenderResources::GetCoreContext()->MinStorageBufferOffsetAlignment;
+		Culling.BatchesOffset = Math::AlignNumber(PlanesSize, StorageOffsetAlignment);
+		Culling.InstanceBatchesOffset = Math::AlignNumber(Culling.BatchesOffset + Culling.MaxDrawCount * sizeof(CullBatch), StorageOffsetAlignment);
+		Culling.MeshletInstancesOffset = Math::AlignNumber(Culling.InstanceBatchesOffset + MaxInstances * sizeof(u32), StorageOffsetAlignment);
+		Culling.InputSize = Culling.MeshletInstancesOffset + MaxInstances * sizeof(u32);
+
+		// Draw counts, commands and visible instance counter of every batch, then meshlet commands
+		Culling.MeshletCommandsOffset = OutputCommandsWordOffset + Culling.MaxDrawCount * (CommandWords + 1);
+		Culling.OutputViewStride = Math::AlignNumber(Culling.MeshletCommandsOffset + MaxMeshletDrawCount * CommandWords, 4u);
+		const u64 OutputSize = Culling.OutputViewStride * MAX_DRAW_VIEWS * sizeof(u32);
+
+		// Instance buffer is bound up to the end of last view region
+		const u64 InstanceRange = (u64)(RenderResources::GetInstanceViewRegion(VulkanHelper::MAX_DRAW_FRAMES - 1, MAX_DRAW_VIEWS - 1) + MaxInstances) *
+			sizeof(RenderResources::InstanceData);
+
+		Culling.Layout = RenderResources::GetSetLayout("CullingLayout");
+
+		VkPushConstantRange PushConstants = { };
+		PushConstants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		PushConstants.offset = 0;
+		PushConstants.size = sizeof(CullConstants);
+
+		VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo = { };
+		PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		PipelineLayoutCreateInfo.setLayoutCount = 1;
+		PipelineLayoutCreateInfo.pSetLayouts = &Culling.Layout;
+		PipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		PipelineLayoutCreateInfo.pPushConstantRanges = &PushConstants;
+
+		VULKAN_CHECK_RESULT(vkCreatePipelineLayout(Device, &PipelineLayoutCreateInfo, nullptr, &Culling.PipelineLayout));
+
+		Culling.CullPipeline = CreateComputePipeline(Device, "CullInstancesCompute");
+		Culling.EmitPipeline = CreateComputePipeline(Device, "EmitCulledDrawsCompute");
+		Culling.MeshletPipeline = CreateComputePipeline(Device, "CullMeshletsCompute");
+
+		for (u32 i = 0; i < VulkanHelper::MAX_DRAW_FRAMES; ++i)
+		{
+			CullFrameBuffers* Frame = Culling.Frames + i;
+
+			Frame->Input = VulkanHelper::CreateBuffer(Device, Culling.InputSize, VulkanHelper::BufferUsageFlag::StorageFlag);
+			Frame->InputAllocation = DeviceMemoryAllocator::AllocateBufferMemory(Frame->Input, VulkanHelper::MemoryPropertyFlag::HostCompatible);
+
+			Frame->Output = VulkanHelper::CreateBuffer(Device, OutputSize, VulkanHelper::BufferUsageFlag::IndirectStorageFlag);
+			Frame->OutputAllocation = DeviceMemoryAllocator::AllocateBufferMemory(Frame->Output, VulkanHelper::MemoryPropertyFlag::GPULocal);
+
+			VkDescriptorSetAllocateInfo AllocInfo = { };
+			AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			AllocInfo.descriptorPool = RenderResources::GetMainPool();
+			AllocInfo.descriptorSetCount = 1;
+			AllocInfo.pSetLayouts = &Culling.Layout;
+			VULKAN_CHECK_RESULT(vkAllocateDescriptorSets(Device, &AllocInfo, &Frame->Set));
+
+			const VkDescriptorBufferInfo BufferInfos[] =
+			{
+				{ Frame->Input, 0, PlanesSize },
+				{ Frame->Input, Culling.BatchesOffset, Culling.MaxDrawCount * sizeof(CullBatch) },
+				{ Frame->Input, Culling.InstanceBatchesOffset, MaxInstances * sizeof(u32) },
+				{ RenderResources::GetInstanceBuffer(), 0, InstanceRange },
+				{ Frame->Output, 0, OutputSize },
+				// Meshlets are read from mesh ranges of vertex buffer
+				{ RenderResources::GetVertexStageBuffer(), 0, VK_WHOLE_SIZE },
+				{ Frame->Input, Culling.MeshletInstancesOffset, MaxInstances * sizeof(u32) },
+			};
+			VulkanHelper::WriteStorageBufferDescriptors(Device, Frame->Set, BufferInfos, sizeof(BufferInfos) / sizeof(BufferInfos[0]));
+		}
+	}
+
+	void DeInit()
+	{
+		if (!Culling.Enabled)
+		{
+			return;
+		}
+
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		for (u32 i = 0; i < VulkanHelper::MAX_DRAW_FRAMES; ++i)
+		{
+			vkDestroyBuffer(Device, Culling.Frames[i].Input, nullptr);
+			DeviceMemoryAllocator::Free(&Culling.Frames[i].InputAllocation);
+			vkDestroyBuffer(Device, Culling.Frames[i].Output, nullptr);
+			DeviceMemoryAllocator::Free(&Culling.Frames[i].OutputAllocation);
+		}
+
+		vkDestroyPipeline(Device, Culling.CullPipeline, nullptr);
+		vkDestroyPipeline(Device, Culling.EmitPipeline, nullptr);
+		vkDestroyPipeline(Device, Culling.MeshletPipeline, nullptr);
+		vkDestroyPipelineLayout(Device, Culling.PipelineLayout, nullptr);
+	}
+
+	static u32 GetIndexTypeSlot(VkIndexType IndexType)
+	{
+		return IndexType == VK_INDEX_TYPE_UINT16 ? 0 : 1;
+	}
+
+	// Returns count of batched instances, OutMeshletInstanceCount receives count of instances that draw meshlets
+	static u32 WriteInput(u32 Frame, u32* OutMeshletInstanceCount)
+	{
+		u8* MappedData = Culling.Frames[Frame].InputAllocation.MappedData;
+
+		memcpy(MappedData, FrustumCulling::GetViewPlanes(), MAX_DRAW_VIEWS * PlanesPerView * sizeof(glm::vec4));
+
+		const InstanceBatcher::InstanceBatch* Batches = InstanceBatcher::GetBatches();
+		const u32 BatchCount = InstanceBatcher::GetBatchCount();
+		const u32 BatchRegion = RenderResources::GetInstanceBatchRegion(Frame);
+
+		auto CullBatches = (CullBatch*)(MappedData + Culling.BatchesOffset);
+		auto InstanceBatches = (u32*)(MappedData + Culling.InstanceBatchesOffset);
+		auto MeshletInstances = (u32*)(MappedData + Culling.MeshletInstancesOffset);
+
+		Culling.IndexTypeBatchCounts[0] = 0;
+		Culling.IndexTypeBatchCounts[1] = 0;
+		Culling.IndexTypeMeshletDrawCounts[0] = 0;
+		Culling.IndexTypeMeshletDrawCounts[1] = 0;
+
+		u32 InstanceCount = 0;
+		u32 MeshletInstanceCount = 0;
+		u32 MeshletDrawCount = 0;
+		for (u32 i = 0; i < BatchCount; ++i)
+		{
+			const InstanceBatcher::InstanceBatch* Batch = Batches + i;
+			const RenderResources::VertexData* Mesh = RenderResources::GetStaticMesh(Batch->StaticMeshIndex);
+
+			CullBatch* Dst = CullBatches + i;
+			Dst->BoundingSphere = Mesh->BoundingSphere;
+			for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+			{
+				const RenderResources::MeshLod* Lod = Mesh->Lods + Batch->Lods[View];
+				Dst->IndexCount[View] = Lod->IndicesCount;
+				Dst->FirstIndex[View] = Mesh->IndexOffset / Mesh->IndexSize + Lod->FirstIndex;
+			}
+			Dst->VertexOffset = (s32)(Mesh->VertexOffset / Mesh->VertexSize);
+			Dst->FirstInstance = Batch->FirstInstance - BatchRegion;
+			Dst->InstanceCount = Batch->InstanceCount;
+			Dst->IndexType = GetIndexTypeSlot(Mesh->IndexType);
+
+			++Culling.IndexTypeBatchCounts[Dst->IndexType];
+
+			// Meshlets cover LOD 0 only, every instance can draw every meshlet in a view
+			assert(Mesh->MeshletOffset % sizeof(RenderResources::Meshlet) == 0);
+			Dst->FirstMeshlet = (u32)(Mesh->MeshletOffset / sizeof(RenderResources::Meshlet));
+			Dst->MeshletCount = Mesh->MeshletCount;
+			Dst->MeshletViews = 0;
+
+			const u32 BatchMeshletDraws = Batch->InstanceCount * Mesh->MeshletCount;
+			if (Mesh->MeshletCount >= MinCulledMeshlets && MeshletDrawCount + BatchMeshletDraws <= MaxMeshletDrawCount)
+			{
+				for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+				{
+					Dst->MeshletViews |= Batch->Lods[View] == 0 ? 1u << View : 0;
+				}
+			}
+
+			if (Dst->MeshletViews != 0)
+			{
+				MeshletDrawCount += BatchMeshletDraws;
+				Culling.IndexTypeMeshletDrawCounts[Dst->IndexType] += BatchMeshletDraws;
+			}
+
+			for (u32 j = 0; j < Batch->InstanceCount; ++j)
+			{
+				if (Dst->MeshletViews != 0)
+				{
+					MeshletInstances[MeshletInstanceCount++] = InstanceCount;
+				}
+
+				InstanceBatches[InstanceCount++] = i;
+			}
+		}
+
+		*OutMeshletInstanceCount = MeshletInstanceCount;
+		return InstanceCount;
+	}
+
+	void Dispatch(VkCommandBuffer CmdBuffer, const Render::DrawScene* Scene, u32 Frame)
+	{
+		if (!Culling.Enabled)
+		{
+			return;
+		}
+
+		// Input was last read by submit that is already waited with frame fence
+		u32 MeshletInstanceCount;
+		const u32 InstanceCount = WriteInput(Frame, &MeshletInstanceCount);
+		const u32 BatchCount = InstanceBatcher::GetBatchCount();
+		Culling.DispatchedFrame = Frame;
+
+		VkBuffer Output = Culling.Frames[Frame].Output;
+
+		// Draw counts and visible counters start from zero
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			const u64 ViewOffset = (u64)View * Culling.OutputViewStride * sizeof(u32);
+			vkCmdFillBuffer(CmdBuffer, Output, ViewOffset, OutputCommandsWordOffset * sizeof(u32), 0);
+
+			if (BatchCount > 0)
+			{
+				const u64 CountersOffset = ViewOffset + (OutputCommandsWordOffset + Culling.MaxDrawCount * CommandWords) * sizeof(u32);
+				vkCmdFillBuffer(CmdBuffer, Output, CountersOffset, BatchCount * sizeof(u32), 0);
+			}
+		}
+
+		VkBufferMemoryBarrier2 FillBarrier = { };
+		FillBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+		FillBarrier.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT;
+		FillBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		FillBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+		FillBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+		FillBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		FillBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		FillBarrier.buffer = Output;
+		FillBarrier.offset = 0;
+		FillBarrier.size = VK_WHOLE_SIZE;
+
+		VkDependencyInfo FillDepInfo = { };
+		FillDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		FillDepInfo.bufferMemoryBarrierCount = 1;
+		FillDepInfo.pBufferMemoryBarriers = &FillBarrier;
+
+		vkCmdPipelineBarrier2(CmdBuffer, &FillDepInfo);
+
+		if (BatchCount == 0)
+		{
+			return;
+		}
+
+		CullConstants Constants = { };
+		Constants.InstanceCount = InstanceCount;
+		Constants.BatchCount = BatchCount;
+		Constants.InstanceStride = sizeof(RenderResources::InstanceData) / sizeof(f32);
+		Constants.BatchRegion = RenderResources::GetInstanceBatchRegion(Frame);
+		Constants.ViewRegion = RenderResources::GetInstanceViewRegion(Frame, 0);
+		Constants.ViewRegionStride = RenderResources::GetInstanceViewRegion(Frame, 1) - Constants.ViewRegion;
+		Constants.OutputViewStride = Culling.OutputViewStride;
+		Constants.MaxDrawCount = Culling.MaxDrawCount;
+		Constants.WideIndexBase = Culling.IndexTypeBatchCounts[0];
+		Constants.MeshletInstanceCount = MeshletInstanceCount;
+		Constants.MeshletCommandsOffset = Culling.MeshletCommandsOffset;
+		Constants.MeshletWideBase = Culling.IndexTypeMeshletDrawCounts[0];
+		Constants.CameraPosition = glm::inverse(Scene->ViewProjection.View)[3];
+
+		vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culling.PipelineLayout,
+			0, 1, &Culling.Frames[Frame].Set, 0, nullptr);
+		vkCmdPushConstants(CmdBuffer, Culling.PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &Constants);
+
+		// One invocation per batched instance and view, visible instances are copied into view region
+		vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culling.CullPipeline);
+		vkCmdDispatch(CmdBuffer, (InstanceCount + WorkGroupSize - 1) / WorkGroupSize, MAX_DRAW_VIEWS, 1);
+
+		VkMemoryBarrier2 CullBarrier = { };
+		CullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+		CullBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		CullBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+		CullBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		CullBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+		VkDependencyInfo CullDepInfo = { };
+		CullDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		CullDepInfo.memoryBarrierCount = 1;
+		CullDepInfo.pMemoryBarriers = &CullBarrier;
+
+		vkCmdPipelineBarrier2(CmdBuffer, &CullDepInfo);
+
+		// One invocation per batch and view, batches with visible instances append draw command
+		vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culling.EmitPipeline);
+		vkCmdDispatch(CmdBuffer, (BatchCount + WorkGroupSize - 1) / WorkGroupSize, MAX_DRAW_VIEWS, 1);
+
+		// One work group per instance and view, every invocation tests its share of meshlets and appends draws of visible ones.
+		// Writes other output words than emit pass and doesn't read cull pass results, so no barrier between them
+		if (MeshletInstanceCount > 0)
+		{
+			vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culling.MeshletPipeline);
+			vkCmdDispatch(CmdBuffer, MeshletInstanceCount, MAX_DRAW_VIEWS, 1);
+		}
+
+		VkMemoryBarrier2 DrawBarrier = { };
+		DrawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+		DrawBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		DrawBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+		DrawBarrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+		DrawBarrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+
+		VkDependencyInfo DrawDepInfo = { };
+		DrawDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		DrawDepInfo.memoryBarrierCount = 1;
+		DrawDepInfo.pMemoryBarriers = &DrawBarrier;
+
+		vkCmdPipelineBarrier2(CmdBuffer, &DrawDepInfo);
+	}
+
+	bool IsEnabled()
+	{
+		return Culling.Enabled;
+	}
+
+	void GetViewDraws(u32 View, VkIndexType IndexType, VkBuffer* OutBuffer, u64* OutCountOffset, u64* OutCommandsOffset,
+		u32* OutMaxDrawCount)
+	{
+		assert(View < MAX_DRAW_VIEWS);
+
+		const u32 Slot = GetIndexTypeSlot(IndexType);
+		const u32 FirstCommand = Slot == 0 ? 0 : Culling.IndexTypeBatchCounts[0];
+		const u64 ViewOffset = (u64)View * Culling.OutputViewStride * sizeof(u32);
+
+		*OutBuffer = Culling.Frames[Culling.DispatchedFrame].Output;
+		*OutCountOffset = ViewOffset + Slot * sizeof(u32);
+		*OutCommandsOffset = ViewOffset + (OutputCommandsWordOffset + FirstCommand * CommandWords) * sizeof(u32);
+		*OutMaxDrawCount = Culling.IndexTypeBatchCounts[Slot];
+	}
+
+	void GetViewMeshletDraws(u32 View, VkIndexType IndexType, VkBuffer* OutBuffer, u64* OutCountOffset, u64* OutCommandsOffset,
+		u32* OutMaxDrawCount)
+	{
+		assert(View < MAX_DRAW_VIEWS);
+
+		const u32 Slot = GetIndexTypeSlot(IndexType);
+		const u32 FirstCommand = Slot == 0 ? 0 : Culling.IndexTypeMeshletDrawCounts[0];
+		const u64 ViewOffset = (u64)View * Culling.OutputViewStride * sizeof(u32);
+
+		*OutBuffer = Culling.Frames[Culling.DispatchedFrame].Output;
+		*OutCountOffset = ViewOffset + (OutputMeshletCountsWordOffset + Slot) * sizeof(u32);
+		*OutCommandsOffset = ViewOffset + (Culling.MeshletCommandsOffset + FirstCommand * CommandWords) * sizeof(u32);
+		*OutMaxDrawCount = Culling.IndexTypeMeshletDrawCounts[Slot];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+namespace Render
+{
+	struct DrawScene;
+}
+
+namespace CullingPass
+{
+	// Matches CullBatch of CullingCommon.glsli with std430 layout
+	struct CullBatch
+	{
+		glm::vec4 BoundingSphere;
+		// Indices of LOD drawn in every view
+		u32 IndexCount[MAX_DRAW_VIEWS];
+		u32 FirstIndex[MAX_DRAW_VIEWS];
+		s32 VertexOffset;
+		// Relative to frame batch region, also used as offset inside view regions
+		u32 FirstInstance;
+		u32 InstanceCount;
+		// 0 for 16 bit indices, 1 for 32 bit indices
+		u32 IndexType;
+		// Index of first meshlet in vertex buffer viewed as Meshlet array
+		u32 FirstMeshlet;
+		u32 MeshletCount;
+		// Bit of every view where instances draw culled meshlets of LOD 0 instead of whole batch
+		u32 MeshletViews;
+		u32 Padding[3];
+	};
+
+	static_assert(sizeof(CullBatch) == 80);
+
+	// Matches push constant block of CullingCommon.glsli
+	struct CullConstants
+	{
+		u32 InstanceCount;
+		u32 BatchCount;
+		u32 InstanceStride;
+		u32 BatchRegion;
+		u32 ViewRegion;
+		u32 ViewRegionStride;
+		u32 OutputViewStride;
+		u32 MaxDrawCount;
+		// First command of 32 bit index draws inside view, equal to count of 16 bit index batches
+		u32 WideIndexBase;
+		// Batched instances that draw meshlets in at least one view
+		u32 MeshletInstanceCount;
+		// In u32 words from view start
+		u32 MeshletCommandsOffset;
+		// First command of 32 bit index meshlet draws, equal to most 16 bit index meshlet draws
+		u32 MeshletWideBase;
+		// Origin of camera view for meshlet backface cones
+		glm::vec4 CameraPosition;
+	};
+
+	static_assert(sizeof(CullConstants) == 64);
+
+	void Init();
+	void DeInit();
+
+	// Tests batched instances against camera and light frustums on GPU and writes compacted draws of every view.
+	// Instances of meshes with enough meshlets are culled per meshlet with frustum and camera backface cones instead
+	// and draw every visible meshlet on its own. Has to be recorded after InstanceBatcher::Build and outside of rendering
+	void Dispatch(VkCommandBuffer CmdBuffer, const Render::DrawScene* Scene, u32 Frame);
+
+	// Requires vkCmdDrawIndexedIndirectCount, without it only per entity FrustumCulling results are drawn
+	bool IsEnabled();
+
+	// View 0 is camera, 1 + LightCaster for light casters. Draws of every index type are counted separately,
+	// draw count is at CountOffset, commands at CommandsOffset, MaxDrawCount is 0 when frame has no such draws
+	void GetViewDraws(u32 View, VkIndexType IndexType, VkBuffer* OutBuffer, u64* OutCountOffset, u64* OutCommandsOffset,
+		u32* OutMaxDrawCount);
+	// Same as GetViewDraws for draws of visible meshlets, every command draws one meshlet of one instance
+	void GetViewMeshletDraws(u32 View, VkIndexType IndexType, VkBuffer* OutBuffer, u64* OutCountOffset, u64* OutCommandsOffset,
+		u32* OutMaxDrawCount);
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "DeletionQueue.h"
+
+#include <mutex>
+
+#include "Engine/Systems/Memory/MemoryManagmentSystem.h"
+#include "Render.h"
+#include "TransferSystem.h"
+#include "VulkanHelper.h"
+#include "DeviceMemoryAllocator.h"
+#include "Util/Util.h"
+
+namespace DeletionQueue
+{
+	enum class DeletionType
+	{
+		Buffer,
+		Image,
+		ImageView,
+		Memory,
+		Callback,
+	};
+
+	struct DeferredCall
+	{
+		DeletionCallback Callback;
+		u64 Data0;
+		u64 Data1;
+	};
+
+	struct DeletionTask
+	{
+		union
+		{
+			VkBuffer Buffer;
+			VkImage Image;
+			VkImageView View;
+			VulkanHelper::DeviceMemoryAllocation Allocation;
+			DeferredCall Call;
+		};
+
+		DeletionType Type;
+
+		// Timeline values of the last work that could reference the resource
+		u64 GraphicsValue;
+		u64 TransferValue;
+	};
+
+	struct DeletionQueueState
+	{
+		std::mutex QueueLock;
+		Memory::DynamicHeapArray<DeletionTask> Tasks;
+	};
+
+	static DeletionQueueState QueueState;
+
+	static void DestroyResource(VkDevice Device, const DeletionTask* Task)
+	{
+		switch (Task->Type)
+		{
+			case DeletionType::Buffer:
+				vkDestroyBuffer(Device, Task->Buffer, nullptr);
+				break;
+			case DeletionType::Image:
+				vkDestroyImage(Device, Task->Image, nullptr);
+				break;
+			case DeletionType::ImageView:
+				vkDestroyImageView(Device, Task->View, nullptr);
+				break;
+			case DeletionType::Memory:
+				DeviceMemoryAllocator::Free(&Task->Allocation);
+				break;
+			case DeletionType::Callback:
+				Task->Call.Callback(Task->Call.Data0, Task->Call.Data1);
+				break;
+			default:
+				assert(false);
+				break;
+		}
+	}
+
+	static void PushTask(DeletionTask* Task)
+	{
+		// Work that is being recorded right now is covered by the next graphics value
+		Task->GraphicsValue = Render::GetGraphicsTimelineValue();
+		Task->TransferValue = TransferSystem::GetTransferTimelineValue();
+
+		std::unique_lock Lock(QueueState.QueueLock);
+		Memory::PushBackToArray(&QueueState.Tasks, Task);
+	}
+
+	void Init()
+	{
+		QueueState.Tasks = Memory::AllocateArray<DeletionTask>(256);
+	}
+
+	void DeInit()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		// Device is idle at this point
+		for (u64 i = 0; i < QueueState.Tasks.Count; ++i)
+		{
+			DestroyResource(Device, QueueState.Tasks.Data + i);
+		}
+
+		Memory::FreeArray(&QueueState.Tasks);
+	}
+
+	void Update()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		u64 CompletedGraphics = 0;
+		u64 CompletedTransfer = 0;
+		VULKAN_CHECK_RESULT(vkGetSemaphoreCounterValue(Device, Render::GetGraphicsSemaphore(), &CompletedGraphics));
+		VULKAN_CHECK_RESULT(vkGetSemaphoreCounterValue(Device, TransferSystem::GetTransferSemaphore(), &CompletedTransfer));
+
+		std::unique_lock Lock(QueueState.QueueLock);
+
+		u64 KeptCount = 0;
+		for (u64 i = 0; i < QueueState.Tasks.Count; ++i)
+		{
+			DeletionTask* Task = QueueState.Tasks.Data + i;
+			if (Task->GraphicsValue <= CompletedGraphics && Task->TransferValue <= CompletedTransfer)
+			{
+				DestroyResource(Device, Task);
+			}
+			else
+			{
+				QueueState.Tasks.Data[KeptCount++] = *Task;
+			}
+		}
+
+		QueueState.Tasks.Count = KeptCount;
+	}
+
+	void DestroyBuffer(VkBuffer Buffer)
+	{
+		DeletionTask Task = { };
+		Task.Buffer = Buffer;
+		Task.Type = DeletionType::Buffer;
+		PushTask(&Task);
+	}
+
+	void DestroyImage(VkImage Image)
+	{
+		DeletionTask Task = { };
+		Task.Image = Image;
+		Task.Type = DeletionType::Image;
+		PushTask(&Task);
+	}
+
+	void DestroyImageView(VkImageView View)
+	{
+		DeletionTask Task = { };
+		Task.View = View;
+		Task.Type = DeletionType::ImageView;
+		PushTask(&Task);
+	}
+
+	void FreeMemory(const VulkanHelper::DeviceMemoryAllocation* Allocation)
+	{
+		DeletionTask Task = { };
+		Task.Allocation = *Allocation;
+		Task.Type = DeletionType::Memory;
+		PushTask(&Task);
+	}
+
+	void DeferCallback(DeletionCallback Callback, u64 Data0, u64 Data1)
+	{
+		DeletionTask Task = { };
+		Task.Call.Callback = Callback;
+		Task.Call.Data0 = Data0;
+		Task.Call.Data1 = Data1;
+		Task.Type = DeletionType::Callback;
+		PushTask(&Task);
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+
+#include "VulkanHelper.h"
+
+#include <vulkan/vulkan.h>
+
+namespace DeletionQueue
+{
+	typedef void (*DeletionCallback)(u64 Data0, u64 Data1);
+
+	void Init();
+	void DeInit();
+
+	// Destroys resources that are no longer referenced by submitted graphics and transfer work
+	void Update();
+
+	void DestroyBuffer(VkBuffer Buffer);
+	void DestroyImage(VkImage Image);
+	void DestroyImageView(VkImageView View);
+	void FreeMemory(const VulkanHelper::DeviceMemoryAllocation* Allocation);
+	// Releases ranges of shared buffers, called under queue lock so callback must not push new tasks
+	void DeferCallback(DeletionCallback Callback, u64 Data0, u64 Data1);
+}
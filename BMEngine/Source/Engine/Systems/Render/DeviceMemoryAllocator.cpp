@@ -0,0 +1,376 @@
+#include "DeviceMemoryAllocator.h"
+
+#include <mutex>
+#include <bit>
+#include <algorithm>
+
+#include "Engine/Systems/Memory/MemoryManagmentSystem.h"
+#include "Util/Util.h"
+
+namespace DeviceMemoryAllocator
+{
+	// Resources bigger than half of block get dedicated vkAllocateMemory
+	static constexpr u64 BlockSize = MB64;
+	static constexpr u64 MinNodeSize = 4096;
+
+	struct MemoryBlock
+	{
+		VkDeviceMemory Memory;
+		u8* MappedData;
+		u64 Size;
+		u64 RequestedSize;
+		u64 AllocatedSize;
+		u32 MemoryTypeIndex;
+		u32 MaxOrder;
+		// Buddy tree, per node order + 1 of the largest free node in subtree, 0 when subtree is full
+		u8* FreeOrders;
+		bool IsDedicated;
+	};
+
+	struct AllocatorState
+	{
+		VkPhysicalDevice PhysicalDevice;
+		VkDevice Device;
+		VkPhysicalDeviceMemoryProperties MemoryProperties;
+		// Smallest buddy node, never less than bufferImageGranularity so linear and optimal
+		// resources never share a granularity page
+		u64 NodeSize;
+
+		std::mutex Lock;
+		Memory::DynamicHeapArray<MemoryBlock> Blocks;
+	};
+
+	static AllocatorState State;
+
+	static u64 GetNodeSize(u32 Order)
+	{
+		return State.NodeSize << Order;
+	}
+
+	static u64 GetFirstNodeAtOrder(const MemoryBlock* Block, u32 Order)
+	{
+		return (1ull << (Block->MaxOrder - Order)) - 1;
+	}
+
+	static void UpdateParents(MemoryBlock* Block, u64 Node, u32 Order)
+	{
+		while (Node > 0)
+		{
+			Node = (Node - 1) / 2;
+			++Order;
+
+			const u8 Left = Block->FreeOrders[2 * Node + 1];
+			const u8 Right = Block->FreeOrders[2 * Node + 2];
+
+			// Both halves are free, merge them back
+			if (Left == Order && Right == Order)
+			{
+				Block->FreeOrders[Node] = Order + 1;
+			}
+			else
+			{
+				Block->FreeOrders[Node] = std::max(Left, Right);
+			}
+		}
+	}
+
+	static bool AllocateFromBlock(MemoryBlock* Block, u32 Order, u64* OutOffset)
+	{
+		if (Block->FreeOrders[0] < Order + 1)
+		{
+			return false;
+		}
+
+		u64 Node = 0;
+		for (u32 NodeOrder = Block->MaxOrder; NodeOrder > Order; --NodeOrder)
+		{
+			const u64 Left = 2 * Node + 1;
+			const u8 LeftFree = Block->FreeOrders[Left];
+			const u8 RightFree = Block->FreeOrders[Left + 1];
+
+			// Best fit, take the half with smaller free node that still fits
+			if (LeftFree >= Order + 1 && (RightFree < Order + 1 || LeftFree <= RightFree))
+			{
+				Node = Left;
+			}
+			else
+			{
+				Node = Left + 1;
+			}
+		}
+
+		Block->FreeOrders[Node] = 0;
+		UpdateParents(Block, Node, Order);
+
+		*OutOffset = (Node - GetFirstNodeAtOrder(Block, Order)) * GetNodeSize(Order);
+		return true;
+	}
+
+	static void FreeFromBlock(MemoryBlock* Block, u64 Offset, u32 Order)
+	{
+		const u64 Node = GetFirstNodeAtOrder(Block, Order) + Offset / GetNodeSize(Order);
+		assert(Block->FreeOrders[Node] == 0);
+
+		Block->FreeOrders[Node] = Order + 1;
+		UpdateParents(Block, Node, Order);
+	}
+
+	static u32 CreateBlock(u32 MemoryTypeIndex, u64 Size, bool IsDedicated)
+	{
+		u32 BlockIndex = 0;
+		for (; BlockIndex < State.Blocks.Count; ++BlockIndex)
+		{
+			if (State.Blocks.Data[BlockIndex].Memory == VK_NULL_HANDLE)
+			{
+				break;
+			}
+		}
+
+		if (BlockIndex == State.Blocks.Count)
+		{
+			Memory::ArrayGetNew(&State.Blocks);
+		}
+
+		MemoryBlock* Block = State.Blocks.Data + BlockIndex;
+		*Block = { };
+		Block->Size = Size;
+		Block->MemoryTypeIndex = MemoryTypeIndex;
+		Block->IsDedicated = IsDedicated;
+
+		VkMemoryAllocateInfo MemoryAllocInfo = { };
+		MemoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		MemoryAllocInfo.allocationSize = Size;
+		MemoryAllocInfo.memoryTypeIndex = MemoryTypeIndex;
+
+		VULKAN_CHECK_RESULT(vkAllocateMemory(State.Device, &MemoryAllocInfo, nullptr, &Block->Memory));
+
+		if (State.MemoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			VULKAN_CHECK_RESULT(vkMapMemory(State.Device, Block->Memory, 0, VK_WHOLE_SIZE, 0, (void**)&Block->MappedData));
+		}
+
+		if (!IsDedicated)
+		{
+			Block->MaxOrder = (u32)std::countr_zero(Size / State.NodeSize);
+
+			const u64 NodeCount = (2ull << Block->MaxOrder) - 1;
+			Block->FreeOrders = (u8*)malloc(NodeCount);
+
+			for (u32 Order = 0; Order <= Block->MaxOrder; ++Order)
+			{
+				const u64 FirstNode = GetFirstNodeAtOrder(Block, Order);
+				memset(Block->FreeOrders + FirstNode, Order + 1, FirstNode + 1);
+			}
+		}
+
+		return BlockIndex;
+	}
+
+	static void DestroyBlock(MemoryBlock* Block)
+	{
+		if (Block->MappedData != nullptr)
+		{
+			vkUnmapMemory(State.Device, Block->Memory);
+		}
+
+		vkFreeMemory(State.Device, Block->Memory, nullptr);
+		free(Block->FreeOrders);
+
+		*Block = { };
+	}
+
+	static VulkanHelper::DeviceMemoryAllocation Allocate(const VkMemoryRequirements* Requirements, VulkanHelper::MemoryPropertyFlag Properties)
+	{
+		const u32 MemoryTypeIndex = VulkanHelper::GetMemoryTypeIndex(State.PhysicalDevice, Requirements->memoryTypeBits, (VkFlags)Properties);
+		const u64 NodeSize = std::bit_ceil(std::max({ (u64)Requirements->size, (u64)Requirements->alignment, State.NodeSize }));
+
+		VulkanHelper::DeviceMemoryAllocation Allocation = { };
+		Allocation.Size = Requirements->size;
+		Allocation.Alignment = Requirements->alignment;
+
+		std::unique_lock Lock(State.Lock);
+
+		u64 AllocatedSize = 0;
+		if (NodeSize > BlockSize / 2)
+		{
+			Allocation.BlockIndex = CreateBlock(MemoryTypeIndex, Requirements->size, true);
+			Allocation.Offset = 0;
+			Allocation.Order = 0;
+
+			AllocatedSize = Requirements->size;
+		}
+		else
+		{
+			Allocation.Order = (u32)std::countr_zero(NodeSize / State.NodeSize);
+
+			bool Allocated = false;
+			for (u32 i = 0; i < State.Blocks.Count && !Allocated; ++i)
+			{
+				MemoryBlock* Block = State.Blocks.Data + i;
+				if (Block->Memory != VK_NULL_HANDLE && !Block->IsDedicated && Block->MemoryTypeIndex == MemoryTypeIndex)
+				{
+					Allocated = AllocateFromBlock(Block, Allocation.Order, &Allocation.Offset);
+					Allocation.BlockIndex = i;
+				}
+			}
+
+			if (!Allocated)
+			{
+				Allocation.BlockIndex = CreateBlock(MemoryTypeIndex, BlockSize, false);
+				Allocated = AllocateFromBlock(State.Blocks.Data + Allocation.BlockIndex, Allocation.Order, &Allocation.Offset);
+				assert(Allocated);
+			}
+
+			AllocatedSize = NodeSize;
+		}
+
+		MemoryBlock* Block = State.Blocks.Data + Allocation.BlockIndex;
+		Block->RequestedSize += Requirements->size;
+		Block->AllocatedSize += AllocatedSize;
+
+		Allocation.Memory = Block->Memory;
+		Allocation.MappedData = Block->MappedData != nullptr ? Block->MappedData + Allocation.Offset : nullptr;
+
+		return Allocation;
+	}
+
+	void Init(VkPhysicalDevice PhysicalDevice, VkDevice Device)
+	{
+		State.PhysicalDevice = PhysicalDevice;
+		State.Device = Device;
+		vkGetPhysicalDeviceMemoryProperties(PhysicalDevice, &State.MemoryProperties);
+
+		VkPhysicalDeviceProperties Properties;
+		vkGetPhysicalDeviceProperties(PhysicalDevice, &Properties);
+		State.NodeSize = std::bit_ceil(std::max(MinNodeSize, (u64)Properties.limits.bufferImageGranularity));
+
+		State.Blocks = Memory::AllocateArray<MemoryBlock>(16);
+	}
+
+	void DeInit()
+	{
+		LogStatistics();
+
+		for (u32 i = 0; i < State.Blocks.Count; ++i)
+		{
+			MemoryBlock* Block = State.Blocks.Data + i;
+			if (Block->Memory != VK_NULL_HANDLE)
+			{
+				Util::RenderLog(Util::LogType::Warning, "Device memory block %u is not empty on shutdown, %llu bytes in use",
+					i, Block->RequestedSize);
+				DestroyBlock(Block);
+			}
+		}
+
+		Memory::FreeArray(&State.Blocks);
+	}
+
+	VulkanHelper::DeviceMemoryAllocation AllocateBufferMemory(VkBuffer Buffer, VulkanHelper::MemoryPropertyFlag Properties)
+	{
+		VkMemoryRequirements MemoryRequirements;
+		vkGetBufferMemoryRequirements(State.Device, Buffer, &MemoryRequirements);
+
+		VulkanHelper::DeviceMemoryAllocation Allocation = Allocate(&MemoryRequirements, Properties);
+		VULKAN_CHECK_RESULT(vkBindBufferMemory(State.Device, Buffer, Allocation.Memory, Allocation.Offset));
+
+		return Allocation;
+	}
+
+	VulkanHelper::DeviceMemoryAllocation AllocateImageMemory(VkImage Image, VulkanHelper::MemoryPropertyFlag Properties)
+	{
+		VkMemoryRequirements MemoryRequirements;
+		vkGetImageMemoryRequirements(State.Device, Image, &MemoryRequirements);
+
+		VulkanHelper::DeviceMemoryAllocation Allocation = Allocate(&MemoryRequirements, Properties);
+		VULKAN_CHECK_RESULT(vkBindImageMemory(State.Device, Image, Allocation.Memory, Allocation.Offset));
+
+		return Allocation;
+	}
+
+	void Free(const VulkanHelper::DeviceMemoryAllocation* Allocation)
+	{
+		if (Allocation->Memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::unique_lock Lock(State.Lock);
+
+		MemoryBlock* Block = State.Blocks.Data + Allocation->BlockIndex;
+		assert(Block->Memory == Allocation->Memory);
+
+		Block->RequestedSize -= Allocation->Size;
+
+		if (Block->IsDedicated)
+		{
+			DestroyBlock(Block);
+			return;
+		}
+
+		FreeFromBlock(Block, Allocation->Offset, Allocation->Order);
+		Block->AllocatedSize -= GetNodeSize(Allocation->Order);
+
+		if (Block->AllocatedSize == 0)
+		{
+			DestroyBlock(Block);
+		}
+	}
+
+	Statistics GetStatistics()
+	{
+		std::unique_lock Lock(State.Lock);
+
+		Statistics Stats = { };
+		u64 FreeSize = 0;
+
+		for (u32 i = 0; i < State.Blocks.Count; ++i)
+		{
+			const MemoryBlock* Block = State.Blocks.Data + i;
+			if (Block->Memory == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			Stats.ReservedSize += Block->Size;
+			Stats.AllocatedSize += Block->AllocatedSize;
+			Stats.RequestedSize += Block->RequestedSize;
+
+			if (Block->IsDedicated)
+			{
+				++Stats.DedicatedCount;
+				continue;
+			}
+
+			++Stats.BlockCount;
+			FreeSize += Block->Size - Block->AllocatedSize;
+
+			if (Block->FreeOrders[0] > 0)
+			{
+				Stats.LargestFreeRange = std::max(Stats.LargestFreeRange, GetNodeSize(Block->FreeOrders[0] - 1));
+			}
+		}
+
+		if (Stats.AllocatedSize > 0)
+		{
+			Stats.InternalFragmentation = (f32)(Stats.AllocatedSize - Stats.RequestedSize) / (f32)Stats.AllocatedSize;
+		}
+
+		if (FreeSize > 0)
+		{
+			Stats.ExternalFragmentation = 1.0f - (f32)Stats.LargestFreeRange / (f32)FreeSize;
+		}
+
+		return Stats;
+	}
+
+	void LogStatistics()
+	{
+		const Statistics Stats = GetStatistics();
+
+		Util::RenderLog(Util::LogType::Info,
+			"Device memory: %llu blocks, %llu dedicated, reserved %llu, allocated %llu, requested %llu, "
+			"largest free %llu, internal fragmentation %.2f, external fragmentation %.2f",
+			Stats.BlockCount, Stats.DedicatedCount, Stats.ReservedSize, Stats.AllocatedSize, Stats.RequestedSize,
+			Stats.LargestFreeRange, Stats.InternalFragmentation, Stats.ExternalFragmentation);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+#include "VulkanHelper.h"
+
+#include <vulkan/vulkan.h>
+
+namespace DeviceMemoryAllocator
+{
+	struct Statistics
+	{
+		u64 BlockCount;
+		u64 DedicatedCount;
+		// Memory taken with vkAllocateMemory
+		u64 ReservedSize;
+		// Memory taken by buddy nodes, includes power of two padding
+		u64 AllocatedSize;
+		// Memory asked by resources
+		u64 RequestedSize;
+		u64 LargestFreeRange;
+		// Padding inside nodes relative to AllocatedSize
+		f32 InternalFragmentation;
+		// 1 - LargestFreeRange / free memory inside blocks
+		f32 ExternalFragmentation;
+	};
+
+	void Init(VkPhysicalDevice PhysicalDevice, VkDevice Device);
+	void DeInit();
+
+	// Allocates and binds memory, host compatible memory is persistently mapped
+	VulkanHelper::DeviceMemoryAllocation AllocateBufferMemory(VkBuffer Buffer, VulkanHelper::MemoryPropertyFlag Properties);
+	VulkanHelper::DeviceMemoryAllocation AllocateImageMemory(VkImage Image, VulkanHelper::MemoryPropertyFlag Properties);
+	// Allocation has to be unused by device, see DeletionQueue::FreeMemory
+	void Free(const VulkanHelper::DeviceMemoryAllocation* Allocation);
+
+	Statistics GetStatistics();
+	void LogStatistics();
+}
@@ -0,0 +1,389 @@
+#include "FrustumCulling.h"
+
+#include "Render.h"
+#include "RenderResources.h"
+#include "Residency.h"
+#include "Engine/Systems/Concurrency/TaskSystem.h"
+#include "Engine/Systems/Memory/MemoryManagmentSystem.h"
+
+#include "Util/Math.h"
+
+#include <atomic>
+#include <mutex>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define FRUSTUM_CULLING_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FRUSTUM_CULLING_AVX2_TARGET
+#else
+#define FRUSTUM_CULLING_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace FrustumCulling
+{
+	static const u32 PlanesPerView = 6;
+
+	// Structure of arrays, one element per drawable entity in Residency order
+	struct EntityBounds
+	{
+		Memory::DynamicHeapArray<f32> CenterX;
+		Memory::DynamicHeapArray<f32> CenterY;
+		Memory::DynamicHeapArray<f32> CenterZ;
+		Memory::DynamicHeapArray<f32> Radius;
+		Memory::DynamicHeapArray<u32> EntityIndices;
+	};
+
+	struct CullingState
+	{
+		EntityBounds Bounds;
+		glm::vec4 Planes[MAX_DRAW_VIEWS * PlanesPerView];
+
+		// Bounds indices while culling, entity indices after
+		Memory::DynamicHeapArray<u32> Visible[MAX_DRAW_VIEWS];
+		Memory::DynamicHeapArray<u32> VisibleAnyView;
+		Memory::DynamicHeapArray<u8> ViewMasks;
+
+		std::atomic<u32> NextView;
+		bool IsAvx2Supported;
+	};
+
+	static CullingState Culling;
+
+	static bool QueryAvx2Support()
+	{
+#if defined(FRUSTUM_CULLING_SIMD) && defined(_MSC_VER)
+		int Info[4];
+		__cpuid(Info, 0);
+		if (Info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(Info, 1);
+		const bool IsOsXSaveEnabled = (Info[2] & (1 << 27)) != 0;
+		const bool IsAvxSupported = (Info[2] & (1 << 28)) != 0;
+		// Upper halves of YMM registers have to be saved by OS
+		if (!IsOsXSaveEnabled || !IsAvxSupported || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(Info, 7, 0);
+		return (Info[1] & (1 << 5)) != 0;
+#elif defined(FRUSTUM_CULLING_SIMD)
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+	static glm::vec4 TransformSphere(const glm::vec4& Sphere, const glm::mat4& Model)
+	{
+		const glm::vec3 Center = glm::vec3(Model * glm::vec4(glm::vec3(Sphere), 1.0f));
+		const f32 Scale = glm::max(glm::length(glm::vec3(Model[0])), glm::max(glm::length(glm::vec3(Model[1])), glm::length(glm::vec3(Model[2]))));
+		return glm::vec4(Center, Sphere.w * Scale);
+	}
+
+	static glm::vec4 MergeSpheres(const glm::vec4& A, const glm::vec4& B)
+	{
+		const glm::vec3 Offset = glm::vec3(B) - glm::vec3(A);
+		const f32 Distance = glm::length(Offset);
+
+		if (Distance + B.w <= A.w)
+		{
+			return A;
+		}
+
+		if (Distance + A.w <= B.w)
+		{
+			return B;
+		}
+
+		const f32 Radius = (Distance + A.w + B.w) * 0.5f;
+		return glm::vec4(glm::vec3(A) + Offset * ((Radius - A.w) / Distance), Radius);
+	}
+
+	static void AppendVisible(u32 First, u32 LaneMask, u32 LaneCount, Memory::DynamicHeapArray<u32>* OutVisible)
+	{
+		for (u32 Lane = 0; Lane < LaneCount; ++Lane)
+		{
+			if (LaneMask & (1 << Lane))
+			{
+				OutVisible->Data[OutVisible->Count++] = First + Lane;
+			}
+		}
+	}
+
+	// Kernels process [First, Last) with their own width and return first element left for narrower kernel
+	static u32 CullScalar(const glm::vec4* Planes, u32 First, u32 Last, Memory::DynamicHeapArray<u32>* OutVisible)
+	{
+		const EntityBounds* Bounds = &Culling.Bounds;
+
+		for (u32 i = First; i < Last; ++i)
+		{
+			bool IsVisible = true;
+			for (u32 Plane = 0; Plane < PlanesPerView && IsVisible; ++Plane)
+			{
+				const glm::vec4& P = Planes[Plane];
+				const f32 Distance = P.x * Bounds->CenterX.Data[i] + P.y * Bounds->CenterY.Data[i] + P.z * Bounds->CenterZ.Data[i] + P.w;
+				IsVisible = Distance >= -Bounds->Radius.Data[i];
+			}
+
+			if (IsVisible)
+			{
+				OutVisible->Data[OutVisible->Count++] = i;
+			}
+		}
+
+		return Last;
+	}
+
+#ifdef FRUSTUM_CULLING_SIMD
+	static u32 CullSse(const glm::vec4* Planes, u32 First, u32 Last, Memory::DynamicHeapArray<u32>* OutVisible)
+	{
+		const EntityBounds* Bounds = &Culling.Bounds;
+
+		__m128 PlaneX[PlanesPerView];
+		__m128 PlaneY[PlanesPerView];
+		__m128 PlaneZ[PlanesPerView];
+		__m128 PlaneW[PlanesPerView];
+		for (u32 Plane = 0; Plane < PlanesPerView; ++Plane)
+		{
+			PlaneX[Plane] = _mm_set1_ps(Planes[Plane].x);
+			PlaneY[Plane] = _mm_set1_ps(Planes[Plane].y);
+			PlaneZ[Plane] = _mm_set1_ps(Planes[Plane].z);
+			PlaneW[Plane] = _mm_set1_ps(Planes[Plane].w);
+		}
+
+		u32 i = First;
+		for (; i + 4 <= Last; i += 4)
+		{
+			const __m128 X = _mm_loadu_ps(Bounds->CenterX.Data + i);
+			const __m128 Y = _mm_loadu_ps(Bounds->CenterY.Data + i);
+			const __m128 Z = _mm_loadu_ps(Bounds->CenterZ.Data + i);
+			const __m128 NegativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(Bounds->Radius.Data + i));
+
+			__m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (u32 Plane = 0; Plane < PlanesPerView; ++Plane)
+			{
+				__m128 Distance = _mm_add_ps(_mm_mul_ps(PlaneX[Plane], X), PlaneW[Plane]);
+				Distance = _mm_add_ps(Distance, _mm_mul_ps(PlaneY[Plane], Y));
+				Distance = _mm_add_ps(Distance, _mm_mul_ps(PlaneZ[Plane], Z));
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Distance, NegativeRadius));
+			}
+
+			AppendVisible(i, (u32)_mm_movemask_ps(Inside), 4, OutVisible);
+		}
+
+		return i;
+	}
+
+	FRUSTUM_CULLING_AVX2_TARGET
+	static u32 CullAvx2(const glm::vec4* Planes, u32 First, u32 Last, Memory::DynamicHeapArray<u32>* OutVisible)
+	{
+		const EntityBounds* Bounds = &Culling.Bounds;
+
+		__m256 PlaneX[PlanesPerView];
+		__m256 PlaneY[PlanesPerView];
+		__m256 PlaneZ[PlanesPerView];
+		__m256 PlaneW[PlanesPerView];
+		for (u32 Plane = 0; Plane < PlanesPerView; ++Plane)
+		{
+			PlaneX[Plane] = _mm256_set1_ps(Planes[Plane].x);
+			PlaneY[Plane] = _mm256_set1_ps(Planes[Plane].y);
+			PlaneZ[Plane] = _mm256_set1_ps(Planes[Plane].z);
+			PlaneW[Plane] = _mm256_set1_ps(Planes[Plane].w);
+		}
+
+		u32 i = First;
+		for (; i + 8 <= Last; i += 8)
+		{
+			const __m256 X = _mm256_loadu_ps(Bounds->CenterX.Data + i);
+			const __m256 Y = _mm256_loadu_ps(Bounds->CenterY.Data + i);
+			const __m256 Z = _mm256_loadu_ps(Bounds->CenterZ.Data + i);
+			const __m256 NegativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(Bounds->Radius.Data + i));
+
+			__m256 Inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (u32 Plane = 0; Plane < PlanesPerView; ++Plane)
+			{
+				__m256 Distance = _mm256_add_ps(_mm256_mul_ps(PlaneX[Plane], X), PlaneW[Plane]);
+				Distance = _mm256_add_ps(Distance, _mm256_mul_ps(PlaneY[Plane], Y));
+				Distance = _mm256_add_ps(Distance, _mm256_mul_ps(PlaneZ[Plane], Z));
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(Distance, NegativeRadius, _CMP_GE_OQ));
+			}
+
+			AppendVisible(i, (u32)_mm256_movemask_ps(Inside), 8, OutVisible);
+		}
+
+		return i;
+	}
+#endif
+
+	static void CullView(u32 View)
+	{
+		const glm::vec4* Planes = Culling.Planes + View * PlanesPerView;
+		Memory::DynamicHeapArray<u32>* Visible = Culling.Visible + View;
+		const u32 Count = (u32)Culling.Bounds.EntityIndices.Count;
+
+		u32 i = 0;
+#ifdef FRUSTUM_CULLING_SIMD
+		if (Culling.IsAvx2Supported)
+		{
+			i = CullAvx2(Planes, i, Count, Visible);
+		}
+
+		i = CullSse(Planes, i, Count, Visible);
+#endif
+		CullScalar(Planes, i, Count, Visible);
+	}
+
+	static void CullViews()
+	{
+		for (u32 View = Culling.NextView.fetch_add(1); View < MAX_DRAW_VIEWS; View = Culling.NextView.fetch_add(1))
+		{
+			CullView(View);
+		}
+	}
+
+	void Init()
+	{
+		Culling.Bounds.CenterX = Memory::AllocateArray<f32>(1024);
+		Culling.Bounds.CenterY = Memory::AllocateArray<f32>(1024);
+		Culling.Bounds.CenterZ = Memory::AllocateArray<f32>(1024);
+		Culling.Bounds.Radius = Memory::AllocateArray<f32>(1024);
+		Culling.Bounds.EntityIndices = Memory::AllocateArray<u32>(1024);
+
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Culling.Visible[View] = Memory::AllocateArray<u32>(1024);
+		}
+
+		Culling.VisibleAnyView = Memory::AllocateArray<u32>(1024);
+		Culling.ViewMasks = Memory::AllocateArray<u8>(1024);
+
+		Culling.IsAvx2Supported = QueryAvx2Support();
+	}
+
+	void DeInit()
+	{
+		Memory::FreeArray(&Culling.Bounds.CenterX);
+		Memory::FreeArray(&Culling.Bounds.CenterY);
+		Memory::FreeArray(&Culling.Bounds.CenterZ);
+		Memory::FreeArray(&Culling.Bounds.Radius);
+		Memory::FreeArray(&Culling.Bounds.EntityIndices);
+
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Memory::FreeArray(&Culling.Visible[View]);
+		}
+
+		Memory::FreeArray(&Culling.VisibleAnyView);
+		Memory::FreeArray(&Culling.ViewMasks);
+	}
+
+	static void GatherBounds(Render::DrawScene* Scene)
+	{
+		EntityBounds* Bounds = &Culling.Bounds;
+
+		Memory::ClearArray(&Bounds->CenterX);
+		Memory::ClearArray(&Bounds->CenterY);
+		Memory::ClearArray(&Bounds->CenterZ);
+		Memory::ClearArray(&Bounds->Radius);
+		Memory::ClearArray(&Bounds->EntityIndices);
+
+		u32 DrawableCount;
+		const u32* Drawable = Residency::GetDrawableEntities(&DrawableCount);
+
+		std::unique_lock Lock(Scene->TempLock);
+
+		for (u32 i = 0; i < DrawableCount; ++i)
+		{
+			const Render::DrawEntity* Entity = Scene->DrawEntities.Data + Drawable[i];
+
+			const glm::vec4 MeshSphere = RenderResources::GetStaticMesh(Entity->StaticMeshIndex)->BoundingSphere;
+
+			// Single sphere encloses every instance of entity
+			glm::vec4 Sphere = TransformSphere(MeshSphere, RenderResources::GetInstanceData(Entity->InstanceDataIndex)->ModelMatrix);
+			for (u32 Instance = 1; Instance < Entity->Instances; ++Instance)
+			{
+				const glm::mat4& Model = RenderResources::GetInstanceData(Entity->InstanceDataIndex + Instance)->ModelMatrix;
+				Sphere = MergeSpheres(Sphere, TransformSphere(MeshSphere, Model));
+			}
+
+			*Memory::ArrayGetNew(&Bounds->CenterX) = Sphere.x;
+			*Memory::ArrayGetNew(&Bounds->CenterY) = Sphere.y;
+			*Memory::ArrayGetNew(&Bounds->CenterZ) = Sphere.z;
+			*Memory::ArrayGetNew(&Bounds->Radius) = Sphere.w;
+			*Memory::ArrayGetNew(&Bounds->EntityIndices) = Drawable[i];
+		}
+	}
+
+	void Cull(Render::DrawScene* Scene)
+	{
+		Math::ExtractFrustumPlanes(Scene->ViewProjection.Projection * Scene->ViewProjection.View, Culling.Planes);
+		Math::ExtractFrustumPlanes(Scene->LightEntity->DirectionLight.LightSpaceMatrix, Culling.Planes + PlanesPerView);
+		Math::ExtractFrustumPlanes(Scene->LightEntity->SpotLight.LightSpaceMatrix, Culling.Planes + PlanesPerView * 2);
+
+		// Entities are only appended, gathered indices stay valid after lock is released
+		GatherBounds(Scene);
+
+		const u64 EntityCount = Culling.Bounds.EntityIndices.Count;
+
+		// Jobs write without growing arrays
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Memory::ReserveArray(&Culling.Visible[View], EntityCount);
+			Memory::ClearArray(&Culling.Visible[View]);
+		}
+
+		Memory::ReserveArray(&Culling.VisibleAnyView, EntityCount);
+		Memory::ReserveArray(&Culling.ViewMasks, EntityCount);
+
+		Culling.NextView.store(0);
+
+		TaskSystem::RunOnWorkers(CullViews, MAX_DRAW_VIEWS);
+
+		memset(Culling.ViewMasks.Data, 0, EntityCount);
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Memory::DynamicHeapArray<u32>* Visible = Culling.Visible + View;
+			for (u64 i = 0; i < Visible->Count; ++i)
+			{
+				Culling.ViewMasks.Data[Visible->Data[i]] |= 1 << View;
+				Visible->Data[i] = Culling.Bounds.EntityIndices.Data[Visible->Data[i]];
+			}
+		}
+
+		Memory::ClearArray(&Culling.VisibleAnyView);
+		for (u64 i = 0; i < EntityCount; ++i)
+		{
+			if (Culling.ViewMasks.Data[i] != 0)
+			{
+				Culling.VisibleAnyView.Data[Culling.VisibleAnyView.Count++] = Culling.Bounds.EntityIndices.Data[i];
+			}
+		}
+	}
+
+	const u32* GetVisibleEntities(u32 View, u32* OutCount)
+	{
+		assert(View < MAX_DRAW_VIEWS);
+
+		*OutCount = (u32)Culling.Visible[View].Count;
+		return Culling.Visible[View].Data;
+	}
+
+	const u32* GetVisibleEntitiesAnyView(u32* OutCount)
+	{
+		*OutCount = (u32)Culling.VisibleAnyView.Count;
+		return Culling.VisibleAnyView.Data;
+	}
+
+	const glm::vec4* GetViewPlanes()
+	{
+		return Culling.Planes;
+	}
+}
\ No newline at end of file
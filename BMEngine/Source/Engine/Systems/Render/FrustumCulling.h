@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+
+#include <glm/glm.hpp>
+
+namespace Render
+{
+	struct DrawScene;
+}
+
+namespace FrustumCulling
+{
+	void Init();
+	void DeInit();
+
+	// Gathers world bounding spheres of loaded entities and tests them against camera and light frustums,
+	// every view is culled by its own TaskSystem job
+	void Cull(Render::DrawScene* Scene);
+
+	// Indices into Scene->DrawEntities in Residency drawable order. View 0 is camera, 1 + LightCaster for light casters
+	const u32* GetVisibleEntities(u32 View, u32* OutCount);
+	// Entities visible from at least one view
+	const u32* GetVisibleEntitiesAnyView(u32* OutCount);
+	// Six planes of every view, see Math::ExtractFrustumPlanes
+	const glm::vec4* GetViewPlanes();
+}
\ No newline at end of file
@@ -0,0 +1,512 @@
+#include "InstanceBatcher.h"
+
+#include "Render.h"
+#include "RenderResources.h"
+#include "VulkanHelper.h"
+#include "CullingPass.h"
+#include "FrustumCulling.h"
+#include "Engine/Systems/Concurrency/TaskSystem.h"
+#include "Engine/Systems/Memory/MemoryManagmentSystem.h"
+#include "Util/Settings.h"
+
+#include <atomic>
+#include <mutex>
+#include <cstring>
+
+namespace InstanceBatcher
+{
+	// Key, high to low bits: pass 2 | pipeline 6 | material 16 | mesh 16 | lod 2 | depth 22
+	// Everything above depth is batch state, batches are split where it changes
+	enum class DrawPass : u64
+	{
+		Opaque,
+	};
+
+	static const u64 SortKeyPassBits = 2;
+	static const u64 SortKeyPipelineBits = 6;
+	static const u64 SortKeyMaterialBits = 16;
+	static const u64 SortKeyMeshBits = 16;
+	static const u64 SortKeyLodBits = 2;
+	static const u64 SortKeyDepthBits = 22;
+
+	static_assert(MAX_MESH_LODS <= (1ull << SortKeyLodBits));
+
+	static const u64 SortKeyMeshMask = (1ull << SortKeyMeshBits) - 1;
+	static const u64 SortKeyMaterialMask = (1ull << SortKeyMaterialBits) - 1;
+
+	static const u32 SortKeyChunkSize = 1024;
+	static const u32 RadixBits = 8;
+	static const u32 RadixBuckets = 1 << RadixBits;
+	static const u32 RadixPasses = 64 / RadixBits;
+
+	// Allowed LOD error in pixels for camera and light views, shadows tolerate coarser meshes
+	static const f32 CameraLodErrorPixels = 1.0f;
+	static const f32 ShadowLodErrorPixels = 4.0f;
+
+	struct BatchEntry
+	{
+		u64 Key;
+		// Index inside entities passed to PackBatches
+		u32 EntityIndex;
+		u8 Lods[MAX_DRAW_VIEWS];
+	};
+
+	struct SortKeyJob
+	{
+		const Render::DrawEntity* Entities;
+		u32 EntityCount;
+		// Near plane of view, distance to it is used as depth
+		glm::vec4 NearPlane;
+		// LOD of every view is picked by distance to camera
+		glm::vec3 CameraPosition;
+		// Pixels covered by one world unit at distance of one unit
+		f32 LodScale;
+		u32 View;
+		std::atomic<u32> NextChunk;
+	};
+
+	struct BatcherState
+	{
+		// Copies of visible scene entities, taken under scene lock so jobs don't hold it
+		Memory::DynamicHeapArray<Render::DrawEntity> Entities;
+		Memory::DynamicHeapArray<BatchEntry> Entries;
+		Memory::DynamicHeapArray<BatchEntry> SortScratch;
+		Memory::DynamicHeapArray<InstanceBatch> Batches;
+		// Used when culling pass is disabled, instances are packed into view regions
+		Memory::DynamicHeapArray<InstanceBatch> ViewBatches[MAX_DRAW_VIEWS];
+		Memory::DynamicHeapArray<VkBufferCopy> CopyRegions;
+	};
+
+	static BatcherState Batcher;
+	static SortKeyJob KeyJob;
+
+	void Init()
+	{
+		Batcher.Entities = Memory::AllocateArray<Render::DrawEntity>(1024);
+		Batcher.Entries = Memory::AllocateArray<BatchEntry>(1024);
+		Batcher.SortScratch = Memory::AllocateArray<BatchEntry>(1024);
+		Batcher.Batches = Memory::AllocateArray<InstanceBatch>(256);
+		Batcher.CopyRegions = Memory::AllocateArray<VkBufferCopy>(1024);
+
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Batcher.ViewBatches[View] = Memory::AllocateArray<InstanceBatch>(256);
+		}
+	}
+
+	void DeInit()
+	{
+		Memory::FreeArray(&Batcher.Entities);
+		Memory::FreeArray(&Batcher.Entries);
+		Memory::FreeArray(&Batcher.SortScratch);
+		Memory::FreeArray(&Batcher.Batches);
+		Memory::FreeArray(&Batcher.CopyRegions);
+
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Memory::FreeArray(&Batcher.ViewBatches[View]);
+		}
+	}
+
+	// Positive float bits keep ordering as integers, top bits are enough for coarse ordering
+	static u64 QuantizeDepth(f32 Depth)
+	{
+		Depth = Depth > 0.0f ? Depth : 0.0f;
+
+		u32 Bits;
+		memcpy(&Bits, &Depth, sizeof(Bits));
+
+		return Bits >> (32 - SortKeyDepthBits);
+	}
+
+	static u64 MakeSortKey(DrawPass Pass, u64 Pipeline, u64 MaterialIndex, u64 MeshIndex, u64 Lod, f32 Depth)
+	{
+		assert(Pipeline < (1ull << SortKeyPipelineBits));
+		assert(MaterialIndex <= SortKeyMaterialMask);
+		assert(MeshIndex <= SortKeyMeshMask);
+
+		const u64 PassKey = (u64)Pass << (64 - SortKeyPassBits);
+		const u64 DepthKey = QuantizeDepth(Depth);
+		const u64 StateKey = (Pipeline << (SortKeyMaterialBits + SortKeyMeshBits + SortKeyLodBits)) |
+			(MaterialIndex << (SortKeyMeshBits + SortKeyLodBits)) | (MeshIndex << SortKeyLodBits) | Lod;
+
+		// State changes first, front to back inside same state for early depth rejection
+		return PassKey | (StateKey << SortKeyDepthBits) | DepthKey;
+	}
+
+	// Coarsest LOD of every view whose error projected at distance from camera stays under view limit
+	static void SelectLods(const RenderResources::VertexData* Mesh, const glm::mat4& ModelMatrix, u8* OutLods)
+	{
+		const glm::vec3 Center = glm::vec3(ModelMatrix * glm::vec4(glm::vec3(Mesh->BoundingSphere), 1.0f));
+		const f32 Scale = glm::max(glm::length(glm::vec3(ModelMatrix[0])), glm::max(glm::length(glm::vec3(ModelMatrix[1])),
+			glm::length(glm::vec3(ModelMatrix[2]))));
+		const f32 Distance = glm::length(Center - KeyJob.CameraPosition) - Mesh->BoundingSphere.w * Scale;
+
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			OutLods[View] = 0;
+			if (Distance <= 0.0f)
+			{
+				continue;
+			}
+
+			const f32 MaxError = (View == 0 ? CameraLodErrorPixels : ShadowLodErrorPixels) * Distance / KeyJob.LodScale;
+			for (u32 Lod = 1; Lod < Mesh->LodCount && Mesh->Lods[Lod].Error * Scale <= MaxError; ++Lod)
+			{
+				OutLods[View] = (u8)Lod;
+			}
+		}
+	}
+
+	static void GenerateSortKeys()
+	{
+		const u32 ChunkCount = (KeyJob.EntityCount + SortKeyChunkSize - 1) / SortKeyChunkSize;
+
+		for (u32 Chunk = KeyJob.NextChunk.fetch_add(1); Chunk < ChunkCount; Chunk = KeyJob.NextChunk.fetch_add(1))
+		{
+			const u32 First = Chunk * SortKeyChunkSize;
+			const u32 Last = First + SortKeyChunkSize < KeyJob.EntityCount ? First + SortKeyChunkSize : KeyJob.EntityCount;
+
+			for (u32 i = First; i < Last; ++i)
+			{
+				const Render::DrawEntity* Entity = KeyJob.Entities + i;
+
+				BatchEntry* Entry = Batcher.Entries.Data + i;
+				Entry->EntityIndex = i;
+
+				// Culled lists only hold Residency drawable entities
+				const RenderResources::InstanceData* Instance = RenderResources::GetInstanceData(Entity->InstanceDataIndex);
+				const glm::vec3 Position = glm::vec3(Instance->ModelMatrix[3]);
+				const f32 Depth = glm::dot(glm::vec3(KeyJob.NearPlane), Position) + KeyJob.NearPlane.w;
+
+				// Instances of entity share LOD of the first one
+				SelectLods(RenderResources::GetStaticMesh(Entity->StaticMeshIndex), Instance->ModelMatrix, Entry->Lods);
+
+				// Single mesh pipeline per pass for now
+				Entry->Key = MakeSortKey(DrawPass::Opaque, 0, Instance->MaterialIndex, Entity->StaticMeshIndex, Entry->Lods[KeyJob.View], Depth);
+			}
+		}
+	}
+
+	// Least significant digit first, digits that are equal for every key are skipped
+	static void RadixSort(Memory::DynamicHeapArray<BatchEntry>* Entries)
+	{
+		const u64 Count = Entries->Count;
+		if (Count < 2)
+		{
+			return;
+		}
+
+		Memory::ReserveArray(&Batcher.SortScratch, Count);
+
+		static u32 Histograms[RadixPasses][RadixBuckets];
+		memset(Histograms, 0, sizeof(Histograms));
+
+		for (u64 i = 0; i < Count; ++i)
+		{
+			const u64 Key = Entries->Data[i].Key;
+			for (u32 Pass = 0; Pass < RadixPasses; ++Pass)
+			{
+				++Histograms[Pass][(Key >> (Pass * RadixBits)) & (RadixBuckets - 1)];
+			}
+		}
+
+		BatchEntry* Src = Entries->Data;
+		BatchEntry* Dst = Batcher.SortScratch.Data;
+
+		for (u32 Pass = 0; Pass < RadixPasses; ++Pass)
+		{
+			u32* Histogram = Histograms[Pass];
+			const u32 Shift = Pass * RadixBits;
+
+			if (Histogram[(Src[0].Key >> Shift) & (RadixBuckets - 1)] == Count)
+			{
+				continue;
+			}
+
+			u32 Offset = 0;
+			for (u32 Bucket = 0; Bucket < RadixBuckets; ++Bucket)
+			{
+				const u32 BucketCount = Histogram[Bucket];
+				Histogram[Bucket] = Offset;
+				Offset += BucketCount;
+			}
+
+			for (u64 i = 0; i < Count; ++i)
+			{
+				Dst[Histogram[(Src[i].Key >> Shift) & (RadixBuckets - 1)]++] = Src[i];
+			}
+
+			BatchEntry* Temp = Src;
+			Src = Dst;
+			Dst = Temp;
+		}
+
+		if (Src != Entries->Data)
+		{
+			memcpy(Entries->Data, Src, Count * sizeof(BatchEntry));
+		}
+	}
+
+	// Sorts entities by key and packs instances of neighbouring entities with same mesh, material and LOD of View
+	// into region starting at RegionFirstInstance, returns amount of packed instances
+	static u32 PackBatches(const Render::DrawScene* Scene, const Render::DrawEntity* Entities, u32 EntityCount, u32 View, u32 RegionFirstInstance,
+		Memory::DynamicHeapArray<InstanceBatch>* OutBatches)
+	{
+		const u64 InstanceSize = sizeof(RenderResources::InstanceData);
+		const u32 RegionCapacity = RenderResources::GetMaxMeshInstances();
+
+		// Jobs write entries in place
+		Memory::ReserveArray(&Batcher.Entries, EntityCount);
+		Batcher.Entries.Count = EntityCount;
+
+		KeyJob.Entities = Entities;
+		KeyJob.EntityCount = EntityCount;
+		KeyJob.NearPlane = FrustumCulling::GetViewPlanes()[View * 6 + 4];
+		KeyJob.CameraPosition = glm::vec3(glm::inverse(Scene->ViewProjection.View)[3]);
+		KeyJob.LodScale = glm::abs(Scene->ViewProjection.Projection[1][1]) * MainScreenExtent.height * 0.5f;
+		KeyJob.View = View;
+		KeyJob.NextChunk.store(0);
+
+		const u32 ChunkCount = (EntityCount + SortKeyChunkSize - 1) / SortKeyChunkSize;
+		TaskSystem::RunOnWorkers(GenerateSortKeys, ChunkCount);
+
+		RadixSort(&Batcher.Entries);
+
+		u32 PackedInstances = 0;
+		for (u64 i = 0; i < Batcher.Entries.Count; ++i)
+		{
+			const BatchEntry* Entry = Batcher.Entries.Data + i;
+			const Render::DrawEntity* Entity = Entities + Entry->EntityIndex;
+
+			if (PackedInstances + Entity->Instances > RegionCapacity)
+			{
+				assert(false);
+				break;
+			}
+
+			// Depth bits only order entities inside batch
+			const u64 StateKey = Entry->Key >> SortKeyDepthBits;
+
+			InstanceBatch* Batch;
+			if (i == 0 || (Batcher.Entries.Data[i - 1].Key >> SortKeyDepthBits) != StateKey)
+			{
+				Batch = Memory::ArrayGetNew(OutBatches);
+				Batch->StaticMeshIndex = Entity->StaticMeshIndex;
+				Batch->MaterialIndex = (u32)((StateKey >> (SortKeyMeshBits + SortKeyLodBits)) & SortKeyMaterialMask);
+				Batch->FirstInstance = RegionFirstInstance + PackedInstances;
+				Batch->InstanceCount = 0;
+
+				for (u32 LodView = 0; LodView < MAX_DRAW_VIEWS; ++LodView)
+				{
+					Batch->Lods[LodView] = Entry->Lods[LodView];
+				}
+			}
+			else
+			{
+				Batch = OutBatches->Data + OutBatches->Count - 1;
+
+				// Entities of other views only share LOD of View, finest LOD covers all of them
+				for (u32 LodView = 0; LodView < MAX_DRAW_VIEWS; ++LodView)
+				{
+					Batch->Lods[LodView] = glm::min<u32>(Batch->Lods[LodView], Entry->Lods[LodView]);
+				}
+			}
+
+			Batch->InstanceCount += Entity->Instances;
+
+			const u64 SrcOffset = Entity->InstanceDataIndex * InstanceSize;
+			const u64 DstOffset = (RegionFirstInstance + PackedInstances) * InstanceSize;
+			const u64 Size = Entity->Instances * InstanceSize;
+
+			// Entities created together usually have neighbouring instances
+			VkBufferCopy* LastRegion = Batcher.CopyRegions.Count > 0 ? Batcher.CopyRegions.Data + Batcher.CopyRegions.Count - 1 : nullptr;
+			if (LastRegion != nullptr && LastRegion->srcOffset + LastRegion->size == SrcOffset && LastRegion->dstOffset + LastRegion->size == DstOffset)
+			{
+				LastRegion->size += Size;
+			}
+			else
+			{
+				VkBufferCopy* Region = Memory::ArrayGetNew(&Batcher.CopyRegions);
+				Region->srcOffset = SrcOffset;
+				Region->dstOffset = DstOffset;
+				Region->size = Size;
+			}
+
+			PackedInstances += Entity->Instances;
+		}
+
+		return PackedInstances;
+	}
+
+	void Build(VkCommandBuffer CmdBuffer, Render::DrawScene* Scene, u32 Frame)
+	{
+		Memory::ClearArray(&Batcher.Batches);
+		Memory::ClearArray(&Batcher.CopyRegions);
+
+		for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+		{
+			Memory::ClearArray(&Batcher.ViewBatches[View]);
+		}
+
+		// Culling pass refines every view on GPU, batches hold instances of entities visible from any view
+		const u32 ListCount = CullingPass::IsEnabled() ? 1 : MAX_DRAW_VIEWS;
+		const u32* VisibleLists[MAX_DRAW_VIEWS];
+		u32 VisibleCounts[MAX_DRAW_VIEWS];
+		u32 TotalCount = 0;
+
+		for (u32 List = 0; List < ListCount; ++List)
+		{
+			VisibleLists[List] = CullingPass::IsEnabled() ? FrustumCulling::GetVisibleEntitiesAnyView(VisibleCounts + List) :
+				FrustumCulling::GetVisibleEntities(List, VisibleCounts + List);
+			TotalCount += VisibleCounts[List];
+		}
+
+		Memory::ReserveArray(&Batcher.Entities, TotalCount);
+		Batcher.Entities.Count = TotalCount;
+
+		// Loader appends entities under the lock, key jobs read copies and never wait for it
+		std::unique_lock Lock(Scene->TempLock);
+
+		Render::DrawEntity* Entities = Batcher.Entities.Data;
+		for (u32 List = 0; List < ListCount; ++List)
+		{
+			for (u32 i = 0; i < VisibleCounts[List]; ++i)
+			{
+				*Entities++ = Scene->DrawEntities.Data[VisibleLists[List][i]];
+			}
+		}
+
+		Lock.unlock();
+
+		Entities = Batcher.Entities.Data;
+		if (CullingPass::IsEnabled())
+		{
+			// Camera depth orders instances, light views draw from same batches
+			PackBatches(Scene, Entities, VisibleCounts[0], 0, RenderResources::GetInstanceBatchRegion(Frame), &Batcher.Batches);
+		}
+		else
+		{
+			for (u32 View = 0; View < MAX_DRAW_VIEWS; ++View)
+			{
+				PackBatches(Scene, Entities, VisibleCounts[View], View, RenderResources::GetInstanceViewRegion(Frame, View), &Batcher.ViewBatches[View]);
+				Entities += VisibleCounts[View];
+			}
+		}
+
+		if (Batcher.CopyRegions.Count == 0)
+		{
+			return;
+		}
+
+		// Frame regions were last read by submit that is already waited with frame fence
+		VkBuffer InstanceBuffer = RenderResources::GetInstanceBuffer();
+		vkCmdCopyBuffer(CmdBuffer, InstanceBuffer, InstanceBuffer, (u32)Batcher.CopyRegions.Count, Batcher.CopyRegions.Data);
+
+		VkBufferMemoryBarrier2 Barrier = { };
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+		Barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		Barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		// Culling pass reads batched instances as storage buffer
+		Barrier.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		Barrier.dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+		Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.buffer = InstanceBuffer;
+		// Batch region and view regions of frame are not adjacent
+		Barrier.offset = 0;
+		Barrier.size = VK_WHOLE_SIZE;
+
+		VkDependencyInfo DepInfo = { };
+		DepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		DepInfo.bufferMemoryBarrierCount = 1;
+		DepInfo.pBufferMemoryBarriers = &Barrier;
+
+		vkCmdPipelineBarrier2(CmdBuffer, &DepInfo);
+	}
+
+	void Draw(VkCommandBuffer CmdBuffer, u32 View)
+	{
+		// Meshes are addressed with vertexOffset and firstIndex, instances with firstInstance
+		const VkBuffer Buffers[] =
+		{
+			RenderResources::GetVertexStageBuffer(),
+			RenderResources::GetInstanceBuffer()
+		};
+
+		const u64 Offsets[] = { 0, 0 };
+
+		vkCmdBindVertexBuffers(CmdBuffer, 0, 2, Buffers, Offsets);
+
+		if (CullingPass::IsEnabled())
+		{
+			// Index buffer is rebound at 0 with other type, firstIndex of commands is in units of index type
+			const VkIndexType IndexTypes[] = { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 };
+			for (VkIndexType IndexType : IndexTypes)
+			{
+				VkBuffer CulledBuffer;
+				u64 CountOffset;
+				u64 CommandsOffset;
+				u32 MaxDrawCount;
+				CullingPass::GetViewDraws(View, IndexType, &CulledBuffer, &CountOffset, &CommandsOffset, &MaxDrawCount);
+
+				VkBuffer MeshletBuffer;
+				u64 MeshletCountOffset;
+				u64 MeshletCommandsOffset;
+				u32 MaxMeshletDrawCount;
+				CullingPass::GetViewMeshletDraws(View, IndexType, &MeshletBuffer, &MeshletCountOffset, &MeshletCommandsOffset, &MaxMeshletDrawCount);
+
+				if (MaxDrawCount == 0 && MaxMeshletDrawCount == 0)
+				{
+					continue;
+				}
+
+				vkCmdBindIndexBuffer(CmdBuffer, RenderResources::GetVertexStageBuffer(), 0, IndexType);
+
+				if (MaxDrawCount > 0)
+				{
+					vkCmdDrawIndexedIndirectCount(CmdBuffer, CulledBuffer, CommandsOffset, CulledBuffer, CountOffset,
+						MaxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+				}
+
+				if (MaxMeshletDrawCount > 0)
+				{
+					vkCmdDrawIndexedIndirectCount(CmdBuffer, MeshletBuffer, MeshletCommandsOffset, MeshletBuffer, MeshletCountOffset,
+						MaxMeshletDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+				}
+			}
+
+			return;
+		}
+
+		VkIndexType BoundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		const Memory::DynamicHeapArray<InstanceBatch>* Batches = Batcher.ViewBatches + View;
+		for (u32 i = 0; i < Batches->Count; ++i)
+		{
+			const InstanceBatch* Batch = Batches->Data + i;
+			const RenderResources::VertexData* Mesh = RenderResources::GetStaticMesh(Batch->StaticMeshIndex);
+
+			if (Mesh->IndexType != BoundIndexType)
+			{
+				vkCmdBindIndexBuffer(CmdBuffer, RenderResources::GetVertexStageBuffer(), 0, Mesh->IndexType);
+				BoundIndexType = Mesh->IndexType;
+			}
+
+			const RenderResources::MeshLod* Lod = Mesh->Lods + Batch->Lods[View];
+
+			vkCmdDrawIndexed(CmdBuffer, Lod->IndicesCount, Batch->InstanceCount, Mesh->IndexOffset / Mesh->IndexSize + Lod->FirstIndex,
+				(s32)(Mesh->VertexOffset / Mesh->VertexSize), Batch->FirstInstance);
+		}
+	}
+
+	const InstanceBatch* GetBatches()
+	{
+		return Batcher.Batches.Data;
+	}
+
+	u32 GetBatchCount()
+	{
+		return (u32)Batcher.Batches.Count;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Render
+{
+	struct DrawScene;
+}
+
+namespace InstanceBatcher
+{
+	struct InstanceBatch
+	{
+		u64 StaticMeshIndex;
+		u32 MaterialIndex;
+		// Instance index inside instance buffer, used as firstInstance
+		u32 FirstInstance;
+		u32 InstanceCount;
+		// LOD drawn in every view, finest one needed by batched entities
+		u32 Lods[MAX_DRAW_VIEWS];
+	};
+
+	void Init();
+	void DeInit();
+
+	// Radix sorts entities that passed FrustumCulling by 64 bit keys of pass, pipeline, material, mesh, LOD and view depth,
+	// groups them by mesh and material and copies their instance data into contiguous
+	// frame region of instance buffer, one region per view when CullingPass is disabled. Has to be recorded outside of rendering
+	void Build(VkCommandBuffer CmdBuffer, Render::DrawScene* Scene, u32 Frame);
+
+	// Draws batches visible from View with vertex and instance buffers bound once, see CullingPass::GetViewDraws
+	// and CullingPass::GetViewMeshletDraws
+	void Draw(VkCommandBuffer CmdBuffer, u32 View);
+
+	// Batches of entities visible from any view, empty when CullingPass is disabled
+	const InstanceBatch* GetBatches();
+	u32 GetBatchCount();
+}
@@ -0,0 +1,296 @@
+#include "LightClusters.h"
+
+#include "Render.h"
+#include "RenderResources.h"
+#include "VulkanHelper.h"
+#include "DeviceMemoryAllocator.h"
+#include "Engine/Systems/Concurrency/TaskSystem.h"
+
+#include "Util/Math.h"
+#include "Util/Settings.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace LightClusters
+{
+	// Froxel grid of camera view, depth slices grow exponentially from near to far plane.
+	// Has to match CLUSTER_COUNT_* and MAX_LIGHTS_PER_CLUSTER of Entity.frag.glsl
+	static const u32 ClusterCountX = 16;
+	static const u32 ClusterCountY = 9;
+	static const u32 ClusterCountZ = 24;
+	static const u32 SliceClusterCount = ClusterCountX * ClusterCountY;
+	static const u32 ClusterCount = SliceClusterCount * ClusterCountZ;
+	// Lights over the limit are dropped from crowded froxel
+	static const u32 MaxLightsPerCluster = 64;
+	static const u32 MaxLights = 1024;
+	// Light range ends where attenuated color is below one step of 8 bit output
+	static const f32 LightCutoff = 1.0f / 256.0f;
+
+	// Matches ClusterLightsBuffer header of Entity.frag.glsl with std430 layout
+	struct ClusterGrid
+	{
+		u32 TileSize[2];
+		f32 SliceScale;
+		f32 SliceBias;
+		u32 LightCount;
+		u32 Padding[3];
+	};
+
+	static_assert(sizeof(ClusterGrid) % 16 == 0);
+	static_assert(sizeof(Render::PointLight) % 16 == 0);
+
+	struct ClusterFrameBuffers
+	{
+		// Host written grid and lights, light count of every cluster and light indices of every cluster
+		VkBuffer Buffer;
+		VulkanHelper::DeviceMemoryAllocation Allocation;
+		VkDescriptorSet Set;
+	};
+
+	struct AssignJob
+	{
+		// View space center and radius of every light
+		glm::vec4 Spheres[MaxLights];
+		u32 LightCount;
+		// View depth of every slice border, first one is near plane
+		f32 SliceDepths[ClusterCountZ + 1];
+		f32 ProjectionX;
+		f32 ProjectionY;
+		// Written by slice jobs, copied into mapped memory per slice
+		u32 Counts[ClusterCount];
+		u32* MappedCounts;
+		u32* MappedIndices;
+		std::atomic<u32> NextSlice;
+	};
+
+	struct ClustersState
+	{
+		VkDescriptorSetLayout Layout;
+		ClusterFrameBuffers Frames[VulkanHelper::MAX_DRAW_FRAMES];
+
+		u64 CountsOffset;
+		u64 IndicesOffset;
+		u32 TileSize[2];
+	};
+
+	static ClustersState Clusters;
+	static AssignJob Job;
+
+	void Init()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		Clusters.Layout = RenderResources::GetSetLayout("LightClustersLayout");
+
+		// Last tiles of row and column can be partially outside of screen
+		Clusters.TileSize[0] = (MainScreenExtent.width + ClusterCountX - 1) / ClusterCountX;
+		Clusters.TileSize[1] = (MainScreenExtent.height + ClusterCountY - 1) / ClusterCountY;
+
+		const u64 LightsSize = sizeof(ClusterGrid) + MaxLights * sizeof(Render::PointLight);
+		const u64 CountsSize = ClusterCount * sizeof(u32);
+		const u64 IndicesSize = (u64)ClusterCount * MaxLightsPerCluster * sizeof(u32);
+		const u64 StorageOffsetAlignment = RenderResources::GetCoreContext()->MinStorageBufferOffsetAlignment;
+		Clusters.CountsOffset = Math::AlignNumber(LightsSize, StorageOffsetAlignment);
+		Clusters.IndicesOffset = Math::AlignNumber(Clusters.CountsOffset + CountsSize, StorageOffsetAlignment);
+		const u64 BufferSize = Clusters.IndicesOffset + IndicesSize;
+
+		for (u32 i = 0; i < VulkanHelper::MAX_DRAW_FRAMES; ++i)
+		{
+			ClusterFrameBuffers* Frame = Clusters.Frames + i;
+
+			Frame->Buffer = VulkanHelper::CreateBuffer(Device, BufferSize, VulkanHelper::BufferUsageFlag::StorageFlag);
+			Frame->Allocation = DeviceMemoryAllocator::AllocateBufferMemory(Frame->Buffer, VulkanHelper::MemoryPropertyFlag::HostCompatible);
+
+			VkDescriptorSetAllocateInfo AllocInfo = { };
+			AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			AllocInfo.descriptorPool = RenderResources::GetMainPool();
+			AllocInfo.descriptorSetCount = 1;
+			AllocInfo.pSetLayouts = &Clusters.Layout;
+			VULKAN_CHECK_RESULT(vkAllocateDescriptorSets(Device, &AllocInfo, &Frame->Set));
+
+			const VkDescriptorBufferInfo BufferInfos[] =
+			{
+				{ Frame->Buffer, 0, LightsSize },
+				{ Frame->Buffer, Clusters.CountsOffset, CountsSize },
+				{ Frame->Buffer, Clusters.IndicesOffset, IndicesSize },
+			};
+			VulkanHelper::WriteStorageBufferDescriptors(Device, Frame->Set, BufferInfos, sizeof(BufferInfos) / sizeof(BufferInfos[0]));
+		}
+	}
+
+	void DeInit()
+	{
+		VkDevice Device = VulkanInterface::GetDevice();
+
+		for (u32 i = 0; i < VulkanHelper::MAX_DRAW_FRAMES; ++i)
+		{
+			vkDestroyBuffer(Device, Clusters.Frames[i].Buffer, nullptr);
+			DeviceMemoryAllocator::Free(&Clusters.Frames[i].Allocation);
+		}
+	}
+
+	// Distance where attenuated light drops below LightCutoff, 0 when light never reaches it
+	static f32 ComputeLightRadius(const Render::PointLight* Light)
+	{
+		const glm::vec3 Color = glm::max(Light->Ambient, glm::max(Light->Diffuse, Light->Specular));
+		const f32 Intensity = glm::max(Color.x, glm::max(Color.y, Color.z));
+
+		// Intensity / (Constant + Linear * d + Quadratic * d^2) = LightCutoff
+		const f32 C = Light->Constant - Intensity / LightCutoff;
+		if (C >= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		if (Light->Quadratic > 0.0f)
+		{
+			return (-Light->Linear + std::sqrt(Light->Linear * Light->Linear - 4.0f * Light->Quadratic * C)) / (2.0f * Light->Quadratic);
+		}
+
+		if (Light->Linear > 0.0f)
+		{
+			return -C / Light->Linear;
+		}
+
+		return std::numeric_limits<f32>::max();
+	}
+
+	// Conservative tiles covered by sphere extent along one screen axis between view depths,
+	// extent projects widest at the nearest depth on its side away from view axis
+	static void ComputeTileRange(f32 Center, f32 Radius, f32 MinDepth, f32 MaxDepth, f32 Projection, u32 ScreenSize, u32 TileSize,
+		u32 TileCount, u32* OutFirst, u32* OutLast)
+	{
+		const f32 Low = Center - Radius;
+		const f32 High = Center + Radius;
+
+		f32 NdcLow = Projection * Low / (Low < 0.0f ? MinDepth : MaxDepth);
+		f32 NdcHigh = Projection * High / (High > 0.0f ? MinDepth : MaxDepth);
+		if (NdcLow > NdcHigh)
+		{
+			std::swap(NdcLow, NdcHigh);
+		}
+
+		// Same mapping as gl_FragCoord / TileSize in fragment shader
+		const f32 LastTile = (f32)(TileCount - 1);
+		const f32 First = (NdcLow * 0.5f + 0.5f) * ScreenSize / TileSize;
+		const f32 Last = (NdcHigh * 0.5f + 0.5f) * ScreenSize / TileSize;
+
+		*OutFirst = (u32)glm::clamp(First, 0.0f, LastTile);
+		*OutLast = (u32)glm::clamp(Last, 0.0f, LastTile);
+	}
+
+	static void AssignSlices()
+	{
+		for (u32 Slice = Job.NextSlice.fetch_add(1); Slice < ClusterCountZ; Slice = Job.NextSlice.fetch_add(1))
+		{
+			const f32 SliceNear = Job.SliceDepths[Slice];
+			const f32 SliceFar = Job.SliceDepths[Slice + 1];
+			const u32 SliceFirstCluster = Slice * SliceClusterCount;
+
+			u32* Counts = Job.Counts + SliceFirstCluster;
+			memset(Counts, 0, SliceClusterCount * sizeof(u32));
+
+			for (u32 Light = 0; Light < Job.LightCount; ++Light)
+			{
+				const glm::vec4 Sphere = Job.Spheres[Light];
+
+				// Camera looks down negative z
+				const f32 Depth = -Sphere.z;
+				if (Depth + Sphere.w < SliceNear || Depth - Sphere.w > SliceFar)
+				{
+					continue;
+				}
+
+				const f32 MinDepth = glm::max(SliceNear, Depth - Sphere.w);
+				const f32 MaxDepth = glm::min(SliceFar, Depth + Sphere.w);
+
+				u32 FirstX, LastX, FirstY, LastY;
+				ComputeTileRange(Sphere.x, Sphere.w, MinDepth, MaxDepth, Job.ProjectionX, MainScreenExtent.width, Clusters.TileSize[0],
+					ClusterCountX, &FirstX, &LastX);
+				ComputeTileRange(Sphere.y, Sphere.w, MinDepth, MaxDepth, Job.ProjectionY, MainScreenExtent.height, Clusters.TileSize[1],
+					ClusterCountY, &FirstY, &LastY);
+
+				for (u32 Y = FirstY; Y <= LastY; ++Y)
+				{
+					for (u32 X = FirstX; X <= LastX; ++X)
+					{
+						const u32 Cluster = X + Y * ClusterCountX;
+						if (Counts[Cluster] < MaxLightsPerCluster)
+						{
+							Job.MappedIndices[(u64)(SliceFirstCluster + Cluster) * MaxLightsPerCluster + Counts[Cluster]] = Light;
+							++Counts[Cluster];
+						}
+					}
+				}
+			}
+
+			// Mapped memory is only written, counts are built in host memory
+			memcpy(Job.MappedCounts + SliceFirstCluster, Counts, SliceClusterCount * sizeof(u32));
+		}
+	}
+
+	void Build(const Render::DrawScene* Scene, u32 Frame)
+	{
+		u8* MappedData = Clusters.Frames[Frame].Allocation.MappedData;
+
+		auto Grid = (ClusterGrid*)MappedData;
+		auto Lights = (Render::PointLight*)(MappedData + sizeof(ClusterGrid));
+
+		const glm::mat4& View = Scene->ViewProjection.View;
+		const glm::mat4& Projection = Scene->ViewProjection.Projection;
+
+		Job.LightCount = Scene->PointLightCount < MaxLights ? Scene->PointLightCount : MaxLights;
+		for (u32 i = 0; i < Job.LightCount; ++i)
+		{
+			const Render::PointLight* Light = Scene->PointLights + i;
+
+			// Shaders get view space position with light radius in w
+			Job.Spheres[i] = glm::vec4(glm::vec3(View * glm::vec4(glm::vec3(Light->Position), 1.0f)), ComputeLightRadius(Light));
+
+			Lights[i] = *Light;
+			Lights[i].Position = Job.Spheres[i];
+		}
+
+		const f32 DepthRangeLog = std::log(Scene->FarPlane / Scene->NearPlane);
+		for (u32 Slice = 0; Slice <= ClusterCountZ; ++Slice)
+		{
+			Job.SliceDepths[Slice] = Scene->NearPlane * std::exp(DepthRangeLog * Slice / ClusterCountZ);
+		}
+
+		Grid->TileSize[0] = Clusters.TileSize[0];
+		Grid->TileSize[1] = Clusters.TileSize[1];
+		// Slice of view depth is log(Depth) * SliceScale + SliceBias
+		Grid->SliceScale = ClusterCountZ / DepthRangeLog;
+		Grid->SliceBias = -ClusterCountZ * std::log(Scene->NearPlane) / DepthRangeLog;
+		Grid->LightCount = Job.LightCount;
+
+		Job.MappedCounts = (u32*)(MappedData + Clusters.CountsOffset);
+		Job.MappedIndices = (u32*)(MappedData + Clusters.IndicesOffset);
+
+		if (Job.LightCount == 0)
+		{
+			memset(Job.MappedCounts, 0, ClusterCount * sizeof(u32));
+			return;
+		}
+
+		Job.ProjectionX = Projection[0][0];
+		Job.ProjectionY = Projection[1][1];
+		Job.NextSlice.store(0);
+
+		TaskSystem::RunOnWorkers(AssignSlices, ClusterCountZ);
+	}
+
+	VkDescriptorSetLayout GetLayout()
+	{
+		return Clusters.Layout;
+	}
+
+	VkDescriptorSet GetSet(u32 Frame)
+	{
+		return Clusters.Frames[Frame].Set;
+	}
+}
\ No newline at end of file
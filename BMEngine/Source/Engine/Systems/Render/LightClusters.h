@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Render
+{
+	struct DrawScene;
+}
+
+namespace LightClusters
+{
+	void Init();
+	void DeInit();
+
+	// Moves point lights of scene into view space and assigns them to froxels of camera view,
+	// every depth slice is assigned by TaskSystem job. Lights over MaxLights are ignored.
+	// Has to be called after fence of Frame is waited
+	void Build(const Render::DrawScene* Scene, u32 Frame);
+
+	// Grid with view space lights, light count and light indices of every froxel, see LightClustersLayout
+	VkDescriptorSetLayout GetLayout();
+	VkDescriptorSet GetSet(u32 Frame);
+}
\ No newline at end of file
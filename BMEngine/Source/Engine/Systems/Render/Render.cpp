@@ -3,6 +3,13 @@
 #include "Engine/Systems/Render/VulkanHelper.h"
 #include "RenderResources.h"
 #include "TransferSystem.h"
+#include "DeviceMemoryAllocator.h"
+#include "InstanceBatcher.h"
+#include "CullingPass.h"
+#include "FrustumCulling.h"
+#include "CommandRecorder.h"
+#include "LightClusters.h"
+#include "Residency.h"
 
 #include "imgui.h"
 #include "imgui_impl_vulkan.h"
@@ -129,7 +136,8 @@ namespace Render
 			RenderResources::GetBindlesTexturesLayout(),
 			MeshPipeline->StaticMeshLightLayout,
 			RenderResources::GetMaterialLayout(),
-			MeshPipeline->ShadowMapArrayLayout
+			MeshPipeline->ShadowMapArrayLayout,
+			LightClusters::GetLayout(),
 		};
 
 		const u32 StaticMeshDescriptorLayoutCount = sizeof(StaticMeshDescriptorLayouts) / sizeof(StaticMeshDescriptorLayouts[0]);
@@ -143,14 +151,11 @@ namespace Render
 
 		VULKAN_CHECK_RESULT(vkCreatePipelineLayout(Device, &PipelineLayoutCreateInfo, nullptr, &MeshPipeline->Pipeline.PipelineLayout));
 
-		Yaml::Node Root;
-		Yaml::Parse(Root, "./Resources/Settings/StaticMesh.yaml");
-
 		VulkanHelper::PipelineResourceInfo ResourceInfo = {};
 		ResourceInfo.PipelineLayout = MeshPipeline->Pipeline.PipelineLayout;
 		ResourceInfo.PipelineAttachmentData = *MainPass::GetAttachmentData();
 
-		MeshPipeline->Pipeline.Pipeline = RenderResources::CreateGraphicsPipeline(Device, Root, MainScreenExtent, MeshPipeline->Pipeline.PipelineLayout, &ResourceInfo);
+		RenderResources::RequestGraphicsPipeline("./Resources/Settings/StaticMesh.yaml", MainScreenExtent, &ResourceInfo, &MeshPipeline->Pipeline.Pipeline);
 	}
 
 	static void DeInitStaticMeshPipeline(VkDevice Device, StaticMeshPipeline* MeshPipeline)
@@ -166,10 +171,8 @@ namespace Render
 		vkDestroyPipelineLayout(Device, MeshPipeline->Pipeline.PipelineLayout, nullptr);
 	}
 
-	static void DrawStaticMeshes(VkDevice Device, VkCommandBuffer CmdBuffer, StaticMeshPipeline* MeshPipeline, DrawScene* Scene)
+	static void DrawStaticMeshes(VkCommandBuffer CmdBuffer, StaticMeshPipeline* MeshPipeline, u32 Frame)
 	{
-		FrameManager::UpdateUniformMemory(MeshPipeline->EntityLightBufferHandle, Scene->LightEntity, sizeof(LightBuffer));
-
 		vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, MeshPipeline->Pipeline.Pipeline);
 
 		const VkDescriptorSet VpSet = FrameManager::GetViewProjectionSet();
@@ -183,45 +186,22 @@ namespace Render
 
 		const u32 LightDynamicOffset = VulkanInterface::TestGetImageIndex() * sizeof(LightBuffer);
 
-		std::unique_lock Lock(Scene->TempLock);
-		for (u32 i = 0; i < Scene->DrawEntities.Count; ++i)
+		const VkDescriptorSet DescriptorSetGroup[] =
 		{
-			DrawEntity* DrawEntity = Scene->DrawEntities.Data + i;
-			if (!RenderResources::IsDrawEntityLoaded(DrawEntity))
-			{
-				continue;
-			}
-
-			RenderResources::VertexData* Mesh = RenderResources::GetStaticMesh(DrawEntity->StaticMeshIndex);
-			RenderResources::InstanceData* Instance = RenderResources::GetInstanceData(DrawEntity->InstanceDataIndex);
-
-			const VkDescriptorSet DescriptorSetGroup[] =
-			{
-				MeshPipeline->StaticMeshLightSet,
-				RenderResources::GetMaterialSet(),
-				MeshPipeline->ShadowMapArraySet[VulkanInterface::TestGetImageIndex()],
-			};
-			const u32 DescriptorSetGroupCount = sizeof(DescriptorSetGroup) / sizeof(DescriptorSetGroup[0]);
-
-			const VkBuffer Buffers[] =
-			{
-				RenderResources::GetVertexStageBuffer(),
-				RenderResources::GetInstanceBuffer()
-			};
+			MeshPipeline->StaticMeshLightSet,
+			RenderResources::GetMaterialSet(),
+			MeshPipeline->ShadowMapArraySet[VulkanInterface::TestGetImageIndex()],
+		};
+		const u32 DescriptorSetGroupCount = sizeof(DescriptorSetGroup) / sizeof(DescriptorSetGroup[0]);
 
-			const u64 Offsets[] = 
-			{
-				Mesh->VertexOffset,
-				sizeof(RenderResources::InstanceData)* DrawEntity->InstanceDataIndex
-			};
+		vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, MeshPipeline->Pipeline.PipelineLayout,
+			2, DescriptorSetGroupCount, DescriptorSetGroup, 1, &LightDynamicOffset);
 
-			vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, MeshPipeline->Pipeline.PipelineLayout,
-				2, DescriptorSetGroupCount, DescriptorSetGroup, 1, &LightDynamicOffset);
+		const VkDescriptorSet LightClustersSet = LightClusters::GetSet(Frame);
+		vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, MeshPipeline->Pipeline.PipelineLayout,
+			2 + DescriptorSetGroupCount, 1, &LightClustersSet, 0, nullptr);
 
-			vkCmdBindVertexBuffers(CmdBuffer, 0, 2, Buffers, Offsets);
-			vkCmdBindIndexBuffer(CmdBuffer, RenderResources::GetVertexStageBuffer(), Mesh->IndexOffset, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(CmdBuffer, Mesh->IndicesCount, DrawEntity->Instances, 0, 0, 0);
-		}
+		InstanceBatcher::Draw(CmdBuffer, 0);
 	}
 
 	static void InitDrawState(VkDevice Device, u32 GraphicsFamily, u32 MaxDrawFrames, DrawState* State)
@@ -254,6 +234,18 @@ namespace Render
 			VULKAN_CHECK_RESULT(vkCreateSemaphore(Device, &SemaphoreCreateInfo, nullptr, &State->Frames.ImagesAvailable[i]));
 			VULKAN_CHECK_RESULT(vkCreateSemaphore(Device, &SemaphoreCreateInfo, nullptr, &State->Frames.RenderFinished[i]));
 		}
+
+		VkSemaphoreTypeCreateInfo TimelineCreateInfo = { };
+		TimelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		TimelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		TimelineCreateInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo TimelineSemaphoreCreateInfo = { };
+		TimelineSemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		TimelineSemaphoreCreateInfo.pNext = &TimelineCreateInfo;
+
+		VULKAN_CHECK_RESULT(vkCreateSemaphore(Device, &TimelineSemaphoreCreateInfo, nullptr, &State->GraphicsSemaphore));
+		State->SubmittedFrames.store(0, std::memory_order_relaxed);
 	}
 
 	static void DeInitDrawState(VkDevice Device, u32 MaxDrawFrames, DrawState* State)
@@ -266,6 +258,8 @@ namespace Render
 			vkDestroySemaphore(Device, State->Frames.ImagesAvailable[i], nullptr);
 			vkDestroySemaphore(Device, State->Frames.RenderFinished[i], nullptr);
 		}
+
+		vkDestroySemaphore(Device, State->GraphicsSemaphore, nullptr);
 	}
 
 
@@ -273,6 +267,13 @@ namespace Render
 
 	static RenderState State;
 
+	// Argument is frame index
+	static void RecordMainPass(VkCommandBuffer CmdBuffer, u32 Argument)
+	{
+		//TerrainRender::Draw(CmdBuffer);
+		DrawStaticMeshes(CmdBuffer, &State.MeshPipeline, Argument);
+	}
+
 	void TmpInitFrameMemory()
 	{
 		State.FrameMemory = Memory::CreateFrameMemory(1024 * 1024);
@@ -286,6 +287,12 @@ namespace Render
 		InitDrawState(Device, VulkanInterface::GetQueueGraphicsFamilyIndex(), VulkanHelper::MAX_DRAW_FRAMES, &State.RenderDrawState);
 
 		FrameManager::Init();
+		CommandRecorder::Init();
+		Residency::Init();
+		InstanceBatcher::Init();
+		FrustumCulling::Init();
+		CullingPass::Init();
+		LightClusters::Init();
 
 		DeferredPass::Init();
 		MainPass::Init();
@@ -295,6 +302,8 @@ namespace Render
 		//DynamicMapSystem::Init();
 		InitStaticMeshPipeline(Device, &State.MeshPipeline);
 		InitImGuiPipeline(&State.DebugUiPool, RenderResources::GetCoreContext(), WindowHandler);
+
+		RenderResources::CreateRequestedPipelines();
 	}
 
 	void DeInit()
@@ -313,6 +322,12 @@ namespace Render
 		LightningPass::DeInit();
 		DeferredPass::DeInit();
 		FrameManager::DeInit();
+		LightClusters::DeInit();
+		CullingPass::DeInit();
+		FrustumCulling::DeInit();
+		InstanceBatcher::DeInit();
+		Residency::DeInit();
+		CommandRecorder::DeInit();
 
 		Memory::DestroyFrameMemory(&State.FrameMemory);
 	}
@@ -340,15 +355,49 @@ namespace Render
 		VULKAN_CHECK_RESULT(vkAcquireNextImageKHR(Device, VulkanInterface::GetSwapchain(), UINT64_MAX, ImagesAvailable, nullptr, &ImageIndex));
 		State.RenderDrawState.CurrentImageIndex = ImageIndex;
 
+		CommandRecorder::BeginFrame(CurrentFrame);
+
 		FrameManager::UpdateViewProjection(&Scene->ViewProjection);
 
 		VkCommandBuffer DrawCmdBuffer = State.RenderDrawState.Frames.CommandBuffers[ImageIndex];
 		VULKAN_CHECK_RESULT(vkBeginCommandBuffer(DrawCmdBuffer, &CommandBufferBeginInfo));
 
-		LightningPass::Draw(Scene);
+		RenderResources::FlushTextureDescriptors();
+		RenderResources::ApplyStaticMeshRelocations();
+		Residency::Update(Scene);
+		FrustumCulling::Cull(Scene);
+		InstanceBatcher::Build(DrawCmdBuffer, Scene, CurrentFrame);
+		CullingPass::Dispatch(DrawCmdBuffer, Scene, CurrentFrame);
+		LightClusters::Build(Scene, CurrentFrame);
+
+		FrameManager::UpdateUniformMemory(State.MeshPipeline.EntityLightBufferHandle, Scene->LightEntity, sizeof(LightBuffer));
+
+		// Shadow maps and main pass only execute secondary buffers that are recorded in parallel
+		const u32 MainPassTask = MAX_LIGHT_SOURCES;
+		CommandRecorder::RecordTask RecordTasks[MAX_LIGHT_SOURCES + 1];
+
+		for (u32 LightCaster = 0; LightCaster < MAX_LIGHT_SOURCES; ++LightCaster)
+		{
+			RecordTasks[LightCaster].Function = LightningPass::RecordShadowMap;
+			RecordTasks[LightCaster].Argument = LightCaster;
+			RecordTasks[LightCaster].Attachments = LightningPass::GetAttachmentData();
+		}
+
+		RecordTasks[MainPassTask].Function = RecordMainPass;
+		RecordTasks[MainPassTask].Argument = CurrentFrame;
+		RecordTasks[MainPassTask].Attachments = MainPass::GetAttachmentData();
+
+		CommandRecorder::Record(RecordTasks, MAX_LIGHT_SOURCES + 1);
+
+		VkCommandBuffer ShadowMapCmdBuffers[MAX_LIGHT_SOURCES];
+		for (u32 LightCaster = 0; LightCaster < MAX_LIGHT_SOURCES; ++LightCaster)
+		{
+			ShadowMapCmdBuffers[LightCaster] = RecordTasks[LightCaster].CmdBuffer;
+		}
+
+		LightningPass::Draw(Scene, ShadowMapCmdBuffers);
 		MainPass::BeginPass();
-		//TerrainRender::Draw();
-		DrawStaticMeshes(Device, DrawCmdBuffer, &State.MeshPipeline, Scene);
+		vkCmdExecuteCommands(DrawCmdBuffer, 1, &RecordTasks[MainPassTask].CmdBuffer);
 		MainPass::EndPass();
 		DeferredPass::BeginPass();
 		DeferredPass::Draw();
@@ -366,15 +415,25 @@ namespace Render
 		VkSemaphore RenderFinished = State.RenderDrawState.Frames.RenderFinished[CurrentFrame];
 		VkSwapchainKHR Swapchain = VulkanInterface::GetSwapchain();
 
+		VkSemaphore SignalSemaphores[] = { RenderFinished, State.RenderDrawState.GraphicsSemaphore };
+		// Binary semaphore value is ignored
+		const u64 SignalValues[] = { 0, State.RenderDrawState.SubmittedFrames.load(std::memory_order_relaxed) + 1 };
+
+		VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo = { };
+		TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		TimelineSubmitInfo.signalSemaphoreValueCount = 2;
+		TimelineSubmitInfo.pSignalSemaphoreValues = SignalValues;
+
 		VkSubmitInfo SubmitInfo = { };
 		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.pNext = &TimelineSubmitInfo;
 		SubmitInfo.waitSemaphoreCount = 1;
 		SubmitInfo.pWaitSemaphores = &ImagesAvailable;
 		SubmitInfo.pWaitDstStageMask = WaitStages;
 		SubmitInfo.commandBufferCount = 1;
 		SubmitInfo.pCommandBuffers = &DrawCmdBuffer;
-		SubmitInfo.signalSemaphoreCount = 1;
-		SubmitInfo.pSignalSemaphores = &RenderFinished;
+		SubmitInfo.signalSemaphoreCount = 2;
+		SubmitInfo.pSignalSemaphores = SignalSemaphores;
 
 		VkPresentInfoKHR PresentInfo = { };
 		PresentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -389,6 +448,8 @@ namespace Render
 		VULKAN_CHECK_RESULT(vkQueuePresentKHR(VulkanInterface::GetGraphicsQueue(), &PresentInfo));
 		Lock.unlock();
 
+		State.RenderDrawState.SubmittedFrames.fetch_add(1, std::memory_order_release);
+
 		State.RenderDrawState.CurrentFrame = Math::WrapIncrement(CurrentFrame, VulkanHelper::MAX_DRAW_FRAMES);
 
 		Memory::FrameFree(&State.FrameMemory);
@@ -398,6 +459,16 @@ namespace Render
 	{
 		return &State;
 	}
+
+	u64 GetGraphicsTimelineValue()
+	{
+		return State.RenderDrawState.SubmittedFrames.load(std::memory_order_acquire) + 1;
+	}
+
+	VkSemaphore GetGraphicsSemaphore()
+	{
+		return State.RenderDrawState.GraphicsSemaphore;
+	}
 }
 
 
@@ -415,6 +486,8 @@ namespace DeferredPass
 
 	static VulkanInterface::UniformImage DeferredInputDepthImage[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
 	static VulkanInterface::UniformImage DeferredInputColorImage[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
+	static VulkanHelper::DeviceMemoryAllocation DeferredInputDepthMemory[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
+	static VulkanHelper::DeviceMemoryAllocation DeferredInputColorMemory[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
 
 	static VkImageView DeferredInputDepthImageInterface[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
 	static VkImageView DeferredInputColorImageInterface[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
@@ -429,7 +502,6 @@ namespace DeferredPass
 	void Init()
 	{
 		VkDevice Device = VulkanInterface::GetDevice();
-		VkPhysicalDevice PhysicalDevice = VulkanInterface::GetPhysicalDevice();
 
 		AttachmentData.ColorAttachmentCount = 1;
 		AttachmentData.ColorAttachmentFormats[0] = VulkanInterface::GetSurfaceFormat();
@@ -466,15 +538,12 @@ namespace DeferredPass
 			//const VkDeviceSize AlignedVpSize = VulkanMemoryManagementSystem::CalculateBufferAlignedSize(VpBufferSize);
 
 			vkCreateImage(Device, &DeferredInputDepthUniformCreateInfo, nullptr, &DeferredInputDepthImage[i].Image);
-			VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device,
-				DeferredInputDepthImage[i].Image, VulkanHelper::MemoryPropertyFlag::GPULocal);
-			DeferredInputDepthImage[i].Memory = AllocResult.Memory;
-			vkBindImageMemory(Device, DeferredInputDepthImage[i].Image, DeferredInputDepthImage[i].Memory, 0);
+			DeferredInputDepthMemory[i] = DeviceMemoryAllocator::AllocateImageMemory(DeferredInputDepthImage[i].Image,
+				VulkanHelper::MemoryPropertyFlag::GPULocal);
 
 			vkCreateImage(Device, &DeferredInputColorUniformCreateInfo, nullptr, &DeferredInputColorImage[i].Image);
-			AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device, DeferredInputColorImage[i].Image, VulkanHelper::MemoryPropertyFlag::GPULocal);
-			DeferredInputColorImage[i].Memory = AllocResult.Memory;
-			vkBindImageMemory(Device, DeferredInputColorImage[i].Image, DeferredInputColorImage[i].Memory, 0);
+			DeferredInputColorMemory[i] = DeviceMemoryAllocator::AllocateImageMemory(DeferredInputColorImage[i].Image,
+				VulkanHelper::MemoryPropertyFlag::GPULocal);
 
 			VkImageViewCreateInfo DepthViewCreateInfo = { };
 			DepthViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -563,10 +632,7 @@ namespace DeferredPass
 		ResourceInfo.PipelineLayout = Pipeline.PipelineLayout;
 		ResourceInfo.PipelineAttachmentData = AttachmentData;
 
-		Yaml::Node Root;
-		Yaml::Parse(Root, "./Resources/Settings/DeferredPipeline.yaml");
-
-		Pipeline.Pipeline = RenderResources::CreateGraphicsPipeline(Device, Root, MainScreenExtent, Pipeline.PipelineLayout, &ResourceInfo);
+		RenderResources::RequestGraphicsPipeline("./Resources/Settings/DeferredPipeline.yaml", MainScreenExtent, &ResourceInfo, &Pipeline.Pipeline);
 	}
 
 	void DeInit()
@@ -579,10 +645,10 @@ namespace DeferredPass
 			vkDestroyImageView(Device, DeferredInputColorImageInterface[i], nullptr);
 
 			vkDestroyImage(Device, DeferredInputDepthImage[i].Image, nullptr);
-			vkFreeMemory(Device, DeferredInputDepthImage[i].Memory, nullptr);
+			DeviceMemoryAllocator::Free(&DeferredInputDepthMemory[i]);
 
 			vkDestroyImage(Device, DeferredInputColorImage[i].Image, nullptr);
-			vkFreeMemory(Device, DeferredInputColorImage[i].Memory, nullptr);
+			DeviceMemoryAllocator::Free(&DeferredInputColorMemory[i]);
 		}
 
 
@@ -763,10 +829,12 @@ namespace DeferredPass
 namespace LightningPass
 {
 	static VulkanInterface::UniformImage ShadowMapArray[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
+	static VulkanHelper::DeviceMemoryAllocation ShadowMapMemory[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
 
 	static VkDescriptorSetLayout LightSpaceMatrixLayout;
 
 	static VulkanInterface::UniformBuffer LightSpaceMatrixBuffer[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
+	static VulkanHelper::DeviceMemoryAllocation LightSpaceMatrixMemory[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
 
 	static VkDescriptorSet LightSpaceMatrixSet[VulkanCoreContext::MAX_SWAPCHAIN_IMAGES_COUNT];
 
@@ -777,10 +845,15 @@ namespace LightningPass
 
 	static VulkanHelper::RenderPipeline Pipeline;
 
+	static VulkanHelper::AttachmentData AttachmentData;
+
 	void Init()
 	{
 		VkDevice Device = VulkanInterface::GetDevice();
-		VkPhysicalDevice PhysicalDevice = VulkanInterface::GetPhysicalDevice();
+
+		AttachmentData.ColorAttachmentCount = 0;
+		AttachmentData.DepthAttachmentFormat = DepthFormat;
+		AttachmentData.StencilAttachmentFormat = VK_FORMAT_UNDEFINED;
 
 		LightSpaceMatrixLayout = RenderResources::GetSetLayout("LightSpaceMatrixLayout");
 
@@ -805,9 +878,7 @@ namespace LightningPass
 		for (u32 i = 0; i < VulkanInterface::GetImageCount(); i++)
 		{
 			vkCreateImage(Device, &ShadowMapArrayCreateInfo, nullptr, &ShadowMapArray[i].Image);
-			VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device, ShadowMapArray[i].Image, VulkanHelper::MemoryPropertyFlag::GPULocal);
-			ShadowMapArray[i].Memory = AllocResult.Memory;
-			VULKAN_CHECK_RESULT(vkBindImageMemory(Device, ShadowMapArray[i].Image, ShadowMapArray[i].Memory, 0));
+			ShadowMapMemory[i] = DeviceMemoryAllocator::AllocateImageMemory(ShadowMapArray[i].Image, VulkanHelper::MemoryPropertyFlag::GPULocal);
 
 			const VkDeviceSize LightSpaceMatrixSize = sizeof(glm::mat4);
 
@@ -818,10 +889,8 @@ namespace LightningPass
 			BufferInfo.size = LightSpaceMatrixSize;
 
 			LightSpaceMatrixBuffer[i].Buffer = VulkanHelper::CreateBuffer(Device, LightSpaceMatrixSize, VulkanHelper::BufferUsageFlag::UniformFlag);
-			AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device, LightSpaceMatrixBuffer[i].Buffer,
+			LightSpaceMatrixMemory[i] = DeviceMemoryAllocator::AllocateBufferMemory(LightSpaceMatrixBuffer[i].Buffer,
 				VulkanHelper::MemoryPropertyFlag::HostCompatible);
-			LightSpaceMatrixBuffer[i].Memory = AllocResult.Memory;
-			vkBindBufferMemory(Device, LightSpaceMatrixBuffer[i].Buffer, LightSpaceMatrixBuffer[i].Memory, 0);
 
 			VkDescriptorSetAllocateInfo AllocInfo = { };
 			AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -900,14 +969,9 @@ namespace LightningPass
 
 		VulkanHelper::PipelineResourceInfo ResourceInfo;
 		ResourceInfo.PipelineLayout = Pipeline.PipelineLayout;
-		ResourceInfo.PipelineAttachmentData.ColorAttachmentCount = 0;
-		ResourceInfo.PipelineAttachmentData.DepthAttachmentFormat = DepthFormat;
-		ResourceInfo.PipelineAttachmentData.StencilAttachmentFormat = VK_FORMAT_UNDEFINED;
-
-		Yaml::Node Root;
-		Yaml::Parse(Root, "./Resources/Settings/DepthPipeline.yaml");
+		ResourceInfo.PipelineAttachmentData = AttachmentData;
 
-		Pipeline.Pipeline = RenderResources::CreateGraphicsPipeline(Device, Root, DepthViewportExtent, Pipeline.PipelineLayout, &ResourceInfo);
+		RenderResources::RequestGraphicsPipeline("./Resources/Settings/DepthPipeline.yaml", DepthViewportExtent, &ResourceInfo, &Pipeline.Pipeline);
 	}
 
 	void DeInit()
@@ -917,13 +981,13 @@ namespace LightningPass
 		for (u32 i = 0; i < VulkanInterface::GetImageCount(); i++)
 		{
 			vkDestroyBuffer(Device, LightSpaceMatrixBuffer[i].Buffer, nullptr);
-			vkFreeMemory(Device, LightSpaceMatrixBuffer[i].Memory, nullptr);
+			DeviceMemoryAllocator::Free(&LightSpaceMatrixMemory[i]);
 
 			vkDestroyImageView(Device, ShadowMapElement1ImageInterface[i], nullptr);
 			vkDestroyImageView(Device, ShadowMapElement2ImageInterface[i], nullptr);
 
 			vkDestroyImage(Device, ShadowMapArray[i].Image, nullptr);
-			vkFreeMemory(Device, ShadowMapArray[i].Memory, nullptr);
+			DeviceMemoryAllocator::Free(&ShadowMapMemory[i]);
 		}
 
 
@@ -931,7 +995,23 @@ namespace LightningPass
 		vkDestroyPipelineLayout(Device, Pipeline.PipelineLayout, nullptr);
 	}
 
-	void Draw(Render::DrawScene* Scene)
+	void RecordShadowMap(VkCommandBuffer CmdBuffer, u32 LightCaster)
+	{
+		vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline.Pipeline);
+
+		const u32 DescriptorSetGroupCount = 1;
+		const VkDescriptorSet DescriptorSetGroup[DescriptorSetGroupCount] =
+		{
+			LightSpaceMatrixSet[LightCaster],
+		};
+
+		vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline.PipelineLayout,
+			0, DescriptorSetGroupCount, DescriptorSetGroup, 0, nullptr);
+
+		InstanceBatcher::Draw(CmdBuffer, 1 + LightCaster);
+	}
+
+	void Draw(Render::DrawScene* Scene, const VkCommandBuffer* ShadowMapCmdBuffers)
 	{
 		VkDevice Device = VulkanInterface::GetDevice();
 		VkCommandBuffer CmdBuffer = VulkanInterface::GetCommandBuffer();
@@ -949,7 +1029,7 @@ namespace LightningPass
 
 		for (u32 LightCaster = 0; LightCaster < MAX_LIGHT_SOURCES; ++LightCaster)
 		{
-			VulkanHelper::UpdateHostCompatibleBufferMemory(Device, LightSpaceMatrixBuffer[LightCaster].Memory, sizeof(glm::mat4), 0,
+			VulkanHelper::UpdateHostCompatibleBufferMemory(&LightSpaceMatrixMemory[LightCaster], sizeof(glm::mat4), 0,
 				LightViews[LightCaster]);
 
 			VkRect2D RenderArea;
@@ -966,6 +1046,7 @@ namespace LightningPass
 
 			VkRenderingInfo RenderingInfo{ };
 			RenderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+			RenderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
 			RenderingInfo.renderArea = RenderArea;
 			RenderingInfo.layerCount = 1;
 			RenderingInfo.colorAttachmentCount = 0;
@@ -995,48 +1076,7 @@ namespace LightningPass
 			vkCmdPipelineBarrier2(CmdBuffer, &DependencyInfoBefore);
 
 			vkCmdBeginRendering(CmdBuffer, &RenderingInfo);
-
-			vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline.Pipeline);
-
-			std::unique_lock Lock(Scene->TempLock);
-			for (u32 i = 0; i < Scene->DrawEntities.Count; ++i)
-			{
-				Render::DrawEntity* DrawEntity = Scene->DrawEntities.Data + i;
-				if (!RenderResources::IsDrawEntityLoaded(DrawEntity))
-				{
-					continue;
-				}
-
-				RenderResources::VertexData* Mesh = RenderResources::GetStaticMesh(DrawEntity->StaticMeshIndex);
-
-				const VkBuffer Buffers[] =
-				{
-					RenderResources::GetVertexStageBuffer(),
-					RenderResources::GetInstanceBuffer()
-				};
-
-				const u64 Offsets[] =
-				{
-					Mesh->VertexOffset,
-					sizeof(RenderResources::InstanceData) * DrawEntity->InstanceDataIndex
-				};
-
-				const u32 DescriptorSetGroupCount = 1;
-				const VkDescriptorSet DescriptorSetGroup[DescriptorSetGroupCount] =
-				{
-					LightSpaceMatrixSet[LightCaster],
-				};
-
-				const VkPipelineLayout PipelineLayout = Pipeline.PipelineLayout;
-
-				vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineLayout,
-					0, DescriptorSetGroupCount, DescriptorSetGroup, 0, nullptr);
-
-				vkCmdBindVertexBuffers(CmdBuffer, 0, 2, Buffers, Offsets);
-				vkCmdBindIndexBuffer(CmdBuffer, RenderResources::GetVertexStageBuffer(), Mesh->IndexOffset, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(CmdBuffer, Mesh->IndicesCount, DrawEntity->Instances, 0, 0, 0);
-			}
-
+			vkCmdExecuteCommands(CmdBuffer, 1, ShadowMapCmdBuffers + LightCaster);
 			vkCmdEndRendering(CmdBuffer);
 		}
 
@@ -1071,6 +1111,11 @@ namespace LightningPass
 	{
 		return ShadowMapArray;
 	}
+
+	VulkanHelper::AttachmentData* GetAttachmentData()
+	{
+		return &AttachmentData;
+	}
 }
 
 namespace MainPass
@@ -1131,10 +1176,7 @@ namespace MainPass
 		ResourceInfo.PipelineLayout = SkyBoxPipeline.PipelineLayout;
 		ResourceInfo.PipelineAttachmentData = AttachmentData;
 
-		Yaml::Node Root;
-		Yaml::Parse(Root, "./Resources/Settings/SkyBoxPipeline.yaml");
-
-		SkyBoxPipeline.Pipeline = RenderResources::CreateGraphicsPipeline(Device, Root, MainScreenExtent, SkyBoxPipeline.PipelineLayout, &ResourceInfo);
+		RenderResources::RequestGraphicsPipeline("./Resources/Settings/SkyBoxPipeline.yaml", MainScreenExtent, &ResourceInfo, &SkyBoxPipeline.Pipeline);
 	}
 
 	void DeInit()
@@ -1171,7 +1213,8 @@ namespace MainPass
 
 		VkRenderingInfo RenderingInfo = { };
 		RenderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
-		RenderingInfo.flags = 0;
+		// Content is recorded in parallel, see CommandRecorder
+		RenderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
 		RenderingInfo.renderArea = RenderArea;
 		RenderingInfo.layerCount = 1;
 		RenderingInfo.viewMask = 0;
@@ -1348,10 +1391,7 @@ namespace TerrainRender
 		ResourceInfo.PipelineLayout = Pipeline.PipelineLayout;
 		ResourceInfo.PipelineAttachmentData = *MainPass::GetAttachmentData();
 
-		Yaml::Node Root;
-		Yaml::Parse(Root, "./Resources/Settings/TerrainPipeline.yaml");
-
-		Pipeline.Pipeline = RenderResources::CreateGraphicsPipeline(Device, Root, MainScreenExtent, Pipeline.PipelineLayout, &ResourceInfo);
+		RenderResources::RequestGraphicsPipeline("./Resources/Settings/TerrainPipeline.yaml", MainScreenExtent, &ResourceInfo, &Pipeline.Pipeline);
 
 		LoadTerrain();
 	}
@@ -1364,12 +1404,10 @@ namespace TerrainRender
 		vkDestroyPipelineLayout(Device, Pipeline.PipelineLayout, nullptr);
 	}
 
-	void Draw()
+	void Draw(VkCommandBuffer CmdBuffer)
 	{
 		const Render::RenderState* State = Render::GetRenderState();
 
-		VkCommandBuffer CmdBuffer = VulkanInterface::GetCommandBuffer();
-
 		const VkDescriptorSet Sets[] = {
 			FrameManager::GetViewProjectionSet(),
 			RenderResources::GetBindlesTexturesSet(),
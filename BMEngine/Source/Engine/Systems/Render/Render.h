@@ -42,6 +42,10 @@ namespace Render
 		DrawFrames Frames;
 		u32 CurrentFrame;
 		u32 CurrentImageIndex;
+
+		// Signaled with frame number when frame is executed
+		VkSemaphore GraphicsSemaphore;
+		std::atomic<u64> SubmittedFrames;
 	};
 
 	struct StaticMeshPipeline
@@ -105,9 +109,9 @@ namespace Render
 		alignas(16) glm::vec2 Planes;
 	};
 
+	// Shadow casting lights, point lights are drawn through LightClusters
 	struct LightBuffer
 	{
-		PointLight PointLight;
 		DirectionLight DirectionLight;
 		SpotLight SpotLight;
 
@@ -127,6 +131,14 @@ namespace Render
 
 		LightBuffer* LightEntity = nullptr;
 
+		// World space positions, any amount of lights is shaded only where its range reaches
+		const PointLight* PointLights = nullptr;
+		u32 PointLightCount = 0;
+
+		// Camera depth range, light clusters are sliced inside it
+		f32 NearPlane = 0.1f;
+		f32 FarPlane = 1000.0f;
+
 		std::mutex TempLock;
 		Memory::DynamicHeapArray<DrawEntity> DrawEntities;
 	};
@@ -141,6 +153,10 @@ namespace Render
 	void Draw(DrawScene* Data);
 
 	RenderState* GetRenderState();
+
+	// Value that will be signaled by frame that is recorded now or next one
+	u64 GetGraphicsTimelineValue();
+	VkSemaphore GetGraphicsSemaphore();
 }
 
 namespace DeferredPass
@@ -167,9 +183,12 @@ namespace LightningPass
 	void Init();
 	void DeInit();
 
-	void Draw(Render::DrawScene* Scene);
+	// Records shadow map draws of light caster, executed inside rendering started by Draw
+	void RecordShadowMap(VkCommandBuffer CmdBuffer, u32 LightCaster);
+	void Draw(Render::DrawScene* Scene, const VkCommandBuffer* ShadowMapCmdBuffers);
 
 	VulkanInterface::UniformImage* GetShadowMapArray();
+	VulkanHelper::AttachmentData* GetAttachmentData();
 }
 
 namespace MainPass
@@ -188,5 +207,5 @@ namespace TerrainRender
 	void Init();
 	void DeInit();
 
-	void Draw();
+	void Draw(VkCommandBuffer CmdBuffer);
 }
\ No newline at end of file
@@ -5,14 +5,54 @@
 
 #include "VulkanCoreContext.h"
 #include "TransferSystem.h"
+#include "DeletionQueue.h"
+#include "DeviceMemoryAllocator.h"
+#include "Residency.h"
+#include "Engine/Systems/Concurrency/TaskSystem.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
 #include <cstring>
+#include <mutex>
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define NORMAL_MATRIX_SIMD
+#include <immintrin.h>
+#endif
 
 namespace RenderResources
 {
+	// Multiple of vertex and index size, indirect draws address meshes with vertexOffset and firstIndex.
+	// Also keeps meshlets of every mesh aligned
+	static const u64 VertexRangeGranularity = 32;
+	static_assert(VertexRangeGranularity % MeshletAlignment == 0);
+	static_assert(sizeof(Meshlet) % MeshletAlignment == 0);
+	// Vertex data is compacted once free space outside of largest free range or free range count reaches limit
+	static const u64 MaxScatteredVertexBytes = MB8;
+	static const u64 MaxVertexFreeRanges = 32;
+
+	// Upper bound of bindless texture table, device limits and BindlesTexturesLayout can only lower it
+	static const u32 MaxBindlessTextures = 65536;
+	// Samplers of other sets in pipeline layouts that use bindless textures
+	static const u32 ReservedSamplers = 16;
+
+	static const char* PipelineCachePath = "./Resources/PipelineCache.bin";
+	static const u32 PipelineCacheMagic = 0x43504D42; // BMPC
+
+	// Prepended to vkGetPipelineCacheData output, cache of other device or driver is discarded on load
+	struct PipelineCacheFileHeader
+	{
+		u32 Magic;
+		u32 VendorID;
+		u32 DeviceID;
+		u32 DriverVersion;
+		u8 PipelineCacheUUID[VK_UUID_SIZE];
+		u64 DataSize;
+	};
+
 	template<typename T>
 	struct RenderResource
 	{
@@ -20,6 +60,12 @@ namespace RenderResources
 		std::atomic<bool> IsLoaded;
 	};
 
+	struct PendingTextureDescriptor
+	{
+		u32 Index;
+		VkImageView View;
+	};
+
 	struct ResourceContext
 	{
 		VulkanCoreContext::VulkanCoreContext CoreContext;
@@ -27,18 +73,23 @@ namespace RenderResources
 		std::unordered_map<std::string, VkSampler> Samplers;
 		std::unordered_map<std::string, VkDescriptorSetLayout> DescriptorSetLayouts;
 		std::unordered_map<std::string, VkShaderModule> Shaders;
+		std::mutex ShaderLock;
 
 		u32 MaxMaterials;
 		u32 MaterialCount;
 
 		u32 MaxTextures;
+		// Highest used texture index + 1, destroyed indices are reused from FreeTextureIndices
 		u32 TextureCount;
+		Memory::DynamicHeapArray<u32> FreeTextureIndices;
 
 		u32 MaxMeshInstances;
 		u32 MeshInstanceCount;
 
 		u32 MaxStaticMeshes;
+		// Highest used mesh index + 1, destroyed indices are reused from FreeStaticMeshIndices
 		u32 StaticMeshCount;
+		Memory::DynamicHeapArray<u32> FreeStaticMeshIndices;
 
 		RenderResource<Material>* Materials;
 		RenderResource<MeshTexture2D>* Textures;
@@ -49,25 +100,194 @@ namespace RenderResources
 		VulkanHelper::GPUBuffer GPUInstances;
 		VulkanHelper::GPUBuffer MaterialBuffer;
 
+		// Vertex ranges are in bytes, instance ranges are in InstanceData elements and match instance indices
+		std::mutex RangeLock;
+		Memory::RangeAllocator VertexRanges;
+		Memory::RangeAllocator InstanceRanges;
+		// Destination range offset of mesh that is moved by CompactStaticMeshes, UINT64_MAX otherwise
+		u64* StaticMeshRelocations;
+		// Meshes with completed copies, offsets are switched by render thread in ApplyStaticMeshRelocations
+		Memory::DynamicHeapArray<u32> CompletedStaticMeshRelocations;
+		// Old ranges of switched meshes, only render thread touches it
+		Memory::DynamicHeapArray<Memory::FreeRange> RelocatedVertexRanges;
+		// Meshes destroyed while their relocation was in fly, released by ApplyStaticMeshRelocations after offsets switch
+		Memory::DynamicHeapArray<u32> DestroyedRelocatingStaticMeshes;
+		// Destroyed meshes whose relocation is applied, only render thread touches it
+		Memory::DynamicHeapArray<u32> RelocatedStaticMeshReleases;
+		// Set by frees that scatter vertex ranges and by failed mesh reservations, CompactStaticMeshes does nothing otherwise
+		bool IsVertexCompactionNeeded;
+
 		VkDescriptorSetLayout BindlesTexturesLayout;
 		VkDescriptorSetLayout MaterialLayout;
 
 		VkDescriptorSet BindlesTexturesSet;
 		VkDescriptorSet MaterialSet;
 
+		// Texture indices and descriptor writes that wait for FlushTextureDescriptors
+		std::mutex TextureLock;
+		Memory::DynamicHeapArray<PendingTextureDescriptor> PendingTextureDescriptors;
+		Memory::DynamicHeapArray<VkDescriptorImageInfo> TextureImageInfos;
+		Memory::DynamicHeapArray<VkWriteDescriptorSet> TextureWrites;
+
 		VkSampler DiffuseSampler;
 		VkSampler SpecularSampler;
 
 		VkDescriptorPool MainPool;
+
+		VkPipelineCache PipelineCache;
+		bool IsPipelineCacheLoaded;
+		bool IsPipelineCacheBenchmark;
+	};
+
+	struct GraphicsPipelineRequest
+	{
+		const char* SettingsPath;
+		VkExtent2D Extent;
+		VulkanHelper::PipelineResourceInfo ResourceInfo;
+		VkPipeline* OutPipeline;
 	};
 
+	struct PipelineJob
+	{
+		Memory::DynamicHeapArray<GraphicsPipelineRequest> Requests;
+		std::atomic<u32> NextRequest;
+	};
+
+	struct NormalMatrixJob
+	{
+		InstanceData* Instances;
+		u64 Count;
+		std::atomic<u64> NextChunk;
+	};
+
+	// Instances per worker task, smaller batches are computed by caller
+	static const u64 NormalMatrixChunkSize = 256;
+
 	static ResourceContext ResContext;
+	static PipelineJob PipelineBuild;
+	static NormalMatrixJob NormalMatrixBuild;
+
+	static bool IsPipelineCacheCompatible(const std::vector<char>& FileData, const VkPhysicalDeviceProperties* Properties)
+	{
+		if (FileData.size() < sizeof(PipelineCacheFileHeader) + sizeof(VkPipelineCacheHeaderVersionOne))
+		{
+			return false;
+		}
+
+		const PipelineCacheFileHeader* Header = (const PipelineCacheFileHeader*)FileData.data();
+		if (Header->Magic != PipelineCacheMagic || Header->DataSize != FileData.size() - sizeof(PipelineCacheFileHeader))
+		{
+			return false;
+		}
+
+		if (Header->VendorID != Properties->vendorID || Header->DeviceID != Properties->deviceID ||
+			Header->DriverVersion != Properties->driverVersion ||
+			memcmp(Header->PipelineCacheUUID, Properties->pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			return false;
+		}
+
+		// Driver rejects foreign data itself, but header is checked to not pass truncated or corrupted file
+		VkPipelineCacheHeaderVersionOne CacheHeader;
+		memcpy(&CacheHeader, FileData.data() + sizeof(PipelineCacheFileHeader), sizeof(CacheHeader));
+
+		return CacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			CacheHeader.headerSize >= sizeof(CacheHeader) && CacheHeader.headerSize <= Header->DataSize &&
+			CacheHeader.vendorID == Properties->vendorID && CacheHeader.deviceID == Properties->deviceID &&
+			memcmp(CacheHeader.pipelineCacheUUID, Properties->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	static void CreatePipelineCache()
+	{
+		VkPhysicalDeviceProperties Properties;
+		vkGetPhysicalDeviceProperties(ResContext.CoreContext.PhysicalDevice, &Properties);
+
+		std::vector<char> FileData;
+		FILE* File = fopen(PipelineCachePath, "rb");
+		if (File != nullptr)
+		{
+			if (!Util::ReadFileFull(File, FileData))
+			{
+				FileData.clear();
+			}
+
+			fclose(File);
+		}
+
+		VkPipelineCacheCreateInfo CacheCreateInfo = { };
+		CacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		ResContext.IsPipelineCacheLoaded = false;
+		if (!FileData.empty())
+		{
+			if (IsPipelineCacheCompatible(FileData, &Properties))
+			{
+				CacheCreateInfo.initialDataSize = FileData.size() - sizeof(PipelineCacheFileHeader);
+				CacheCreateInfo.pInitialData = FileData.data() + sizeof(PipelineCacheFileHeader);
+				ResContext.IsPipelineCacheLoaded = true;
+			}
+			else
+			{
+				Util::RenderLog(Util::LogType::Warning, "Pipeline cache %s does not match device or driver, pipelines are rebuilt", PipelineCachePath);
+			}
+		}
+
+		VULKAN_CHECK_RESULT(vkCreatePipelineCache(ResContext.CoreContext.LogicalDevice, &CacheCreateInfo, nullptr, &ResContext.PipelineCache));
+	}
+
+	static void SaveAndDestroyPipelineCache()
+	{
+		VkDevice Device = ResContext.CoreContext.LogicalDevice;
+
+		VkPhysicalDeviceProperties Properties;
+		vkGetPhysicalDeviceProperties(ResContext.CoreContext.PhysicalDevice, &Properties);
+
+		size_t DataSize = 0;
+		VULKAN_CHECK_RESULT(vkGetPipelineCacheData(Device, ResContext.PipelineCache, &DataSize, nullptr));
+
+		std::vector<char> FileData(sizeof(PipelineCacheFileHeader) + DataSize);
+		VULKAN_CHECK_RESULT(vkGetPipelineCacheData(Device, ResContext.PipelineCache, &DataSize, FileData.data() + sizeof(PipelineCacheFileHeader)));
+
+		PipelineCacheFileHeader Header = { };
+		Header.Magic = PipelineCacheMagic;
+		Header.VendorID = Properties.vendorID;
+		Header.DeviceID = Properties.deviceID;
+		Header.DriverVersion = Properties.driverVersion;
+		memcpy(Header.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE);
+		Header.DataSize = DataSize;
+		memcpy(FileData.data(), &Header, sizeof(Header));
+
+		FILE* File = fopen(PipelineCachePath, "wb");
+		if (File != nullptr)
+		{
+			const u64 FileSize = sizeof(PipelineCacheFileHeader) + DataSize;
+			if (fwrite(FileData.data(), 1, FileSize, File) != FileSize)
+			{
+				Util::RenderLog(Util::LogType::Warning, "Failed to write pipeline cache %s", PipelineCachePath);
+			}
+
+			fclose(File);
+		}
+		else
+		{
+			Util::RenderLog(Util::LogType::Warning, "Cannot open pipeline cache %s for writing", PipelineCachePath);
+		}
+
+		vkDestroyPipelineCache(Device, ResContext.PipelineCache, nullptr);
+	}
 
 	void Init(GLFWwindow* WindowHandler)
 	{
 		VulkanCoreContext::CreateCoreContext(&ResContext.CoreContext, WindowHandler);
+		DeviceMemoryAllocator::Init(ResContext.CoreContext.PhysicalDevice, ResContext.CoreContext.LogicalDevice);
+		CreatePipelineCache();
+
+		// Diffuse and specular arrays are both indexed by texture index
+		const u32 MaxUpdateAfterBindSamplers = ResContext.CoreContext.MaxUpdateAfterBindSamplers;
+		assert(MaxUpdateAfterBindSamplers > ReservedSamplers);
+		ResContext.MaxTextures = std::min(MaxBindlessTextures, (MaxUpdateAfterBindSamplers - ReservedSamplers) / 2);
 
-		const u32 PoolSizeCount = 11;
+		const u32 PoolSizeCount = 12;
 		auto TotalPassPoolSizes = (VkDescriptorPoolSize*)Render::FrameAlloc(PoolSizeCount * sizeof(VkDescriptorPoolSize));
 		u32 TotalDescriptorLayouts = 21;
 		TotalPassPoolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 };
@@ -79,8 +299,9 @@ namespace RenderResources
 		TotalPassPoolSizes[6] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 };
 		TotalPassPoolSizes[7] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 };
 		TotalPassPoolSizes[8] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 };
-		TotalPassPoolSizes[9] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 256 };
+		TotalPassPoolSizes[9] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 256 + 2 * ResContext.MaxTextures };
 		TotalPassPoolSizes[10] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 };
+		TotalPassPoolSizes[11] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 48 };
 
 		u32 TotalDescriptorCount = TotalDescriptorLayouts * 3;
 		TotalDescriptorCount += 256;
@@ -98,26 +319,23 @@ namespace RenderResources
 		const u64 InstanceCapacity = MB128 * 2;
 
 		ResContext.VertexStageData.Buffer = VulkanHelper::CreateBuffer(ResContext.CoreContext.LogicalDevice, VertexCapacity, VulkanHelper::BufferUsageFlag::CombinedVertexIndexFlag);
-		VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(ResContext.CoreContext.PhysicalDevice, ResContext.CoreContext.LogicalDevice, ResContext.VertexStageData.Buffer,
+		ResContext.VertexStageData.Allocation = DeviceMemoryAllocator::AllocateBufferMemory(ResContext.VertexStageData.Buffer,
 			VulkanHelper::MemoryPropertyFlag::GPULocal);
-		ResContext.VertexStageData.Memory = AllocResult.Memory;
-		ResContext.VertexStageData.Alignment = AllocResult.Alignment;
-		ResContext.VertexStageData.Capacity = AllocResult.Size;
-
-		VULKAN_CHECK_RESULT(vkBindBufferMemory(ResContext.CoreContext.LogicalDevice, ResContext.VertexStageData.Buffer, ResContext.VertexStageData.Memory, 0));
+		ResContext.VertexStageData.Alignment = ResContext.VertexStageData.Allocation.Alignment;
+		ResContext.VertexStageData.Capacity = ResContext.VertexStageData.Allocation.Size;
 
 		ResContext.GPUInstances.Buffer = VulkanHelper::CreateBuffer(ResContext.CoreContext.LogicalDevice, InstanceCapacity, VulkanHelper::BufferUsageFlag::InstanceFlag);
-		AllocResult = VulkanHelper::AllocateDeviceMemory(ResContext.CoreContext.PhysicalDevice, ResContext.CoreContext.LogicalDevice, ResContext.GPUInstances.Buffer,
+		ResContext.GPUInstances.Allocation = DeviceMemoryAllocator::AllocateBufferMemory(ResContext.GPUInstances.Buffer,
 			VulkanHelper::MemoryPropertyFlag::GPULocal);
-		ResContext.GPUInstances.Memory = AllocResult.Memory;
-		ResContext.GPUInstances.Alignment = AllocResult.Alignment;
-		ResContext.GPUInstances.Capacity = AllocResult.Size;
+		ResContext.GPUInstances.Alignment = ResContext.GPUInstances.Allocation.Alignment;
+		ResContext.GPUInstances.Capacity = ResContext.GPUInstances.Allocation.Size;
 
-		VULKAN_CHECK_RESULT(vkBindBufferMemory(ResContext.CoreContext.LogicalDevice, ResContext.GPUInstances.Buffer, ResContext.GPUInstances.Memory, 0));
-
-		ResContext.MaxTextures = 64;
 		ResContext.TextureCount = 0;
 		ResContext.Textures = (RenderResource<MeshTexture2D>*)malloc(ResContext.MaxTextures * sizeof(ResContext.Textures[0]));
+		ResContext.FreeTextureIndices = Memory::AllocateArray<u32>(64);
+		ResContext.PendingTextureDescriptors = Memory::AllocateArray<PendingTextureDescriptor>(64);
+		ResContext.TextureImageInfos = Memory::AllocateArray<VkDescriptorImageInfo>(128);
+		ResContext.TextureWrites = Memory::AllocateArray<VkWriteDescriptorSet>(128);
 
 		ResContext.MaterialCount = 0;
 		ResContext.MaxMaterials = 30000;
@@ -126,10 +344,24 @@ namespace RenderResources
 		ResContext.MaxStaticMeshes = 30000;
 		ResContext.StaticMeshCount = 0;
 		ResContext.StaticMeshes = (RenderResource<VertexData>*)malloc(ResContext.MaxStaticMeshes * sizeof(ResContext.StaticMeshes[0]));
+		ResContext.StaticMeshRelocations = (u64*)malloc(ResContext.MaxStaticMeshes * sizeof(ResContext.StaticMeshRelocations[0]));
+		ResContext.FreeStaticMeshIndices = Memory::AllocateArray<u32>(64);
+		ResContext.CompletedStaticMeshRelocations = Memory::AllocateArray<u32>(64);
+		ResContext.RelocatedVertexRanges = Memory::AllocateArray<Memory::FreeRange>(64);
+		ResContext.DestroyedRelocatingStaticMeshes = Memory::AllocateArray<u32>(16);
+		ResContext.RelocatedStaticMeshReleases = Memory::AllocateArray<u32>(16);
 
 		ResContext.MaxMeshInstances = 30000;
 		ResContext.MeshInstanceCount = 0;
 		ResContext.MeshInstances = (RenderResource<InstanceData>*)malloc(ResContext.MaxMeshInstances * sizeof(ResContext.MeshInstances[0]));
+
+		// Persistent instances, per frame batch regions and per frame culled regions of every view
+		assert((1 + VulkanHelper::MAX_DRAW_FRAMES * (1 + MAX_DRAW_VIEWS)) * ResContext.MaxMeshInstances * sizeof(InstanceData) <= InstanceCapacity);
+		ResContext.VertexRanges = Memory::CreateRangeAllocator(VertexCapacity, VertexRangeGranularity);
+		ResContext.InstanceRanges = Memory::CreateRangeAllocator(ResContext.MaxMeshInstances, 1);
+		ResContext.IsVertexCompactionNeeded = false;
+
+		PipelineBuild.Requests = Memory::AllocateArray<GraphicsPipelineRequest>(16);
 	}
 
 	VkPipeline CreateGraphicsPipeline(VkDevice Device, Yaml::Node& Root,
@@ -240,29 +472,30 @@ namespace RenderResources
 		RenderingInfo.depthAttachmentFormat = ResourceInfo->PipelineAttachmentData.DepthAttachmentFormat;
 		RenderingInfo.stencilAttachmentFormat = ResourceInfo->PipelineAttachmentData.DepthAttachmentFormat;
 
-		auto PipelineCreateInfo = (VkGraphicsPipelineCreateInfo*)Render::FrameAlloc(sizeof(VkGraphicsPipelineCreateInfo));
-		*PipelineCreateInfo = { };
-		PipelineCreateInfo->sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		PipelineCreateInfo->stageCount = Shaders.Count;
-		PipelineCreateInfo->pStages = Shaders.Data;
-		PipelineCreateInfo->pVertexInputState = &VertexInputState;
-		PipelineCreateInfo->pInputAssemblyState = &InputAssemblyState;
-		PipelineCreateInfo->pViewportState = &ViewportState;
-		PipelineCreateInfo->pDynamicState = nullptr;
-		PipelineCreateInfo->pRasterizationState = &RasterizationState;
-		PipelineCreateInfo->pMultisampleState = &MultisampleState;
-		PipelineCreateInfo->pColorBlendState = &ColorBlendState;
-		PipelineCreateInfo->pDepthStencilState = &DepthStencilState;
-		PipelineCreateInfo->layout = PipelineLayout;
-		PipelineCreateInfo->renderPass = nullptr;
-		PipelineCreateInfo->subpass = 0;
-		PipelineCreateInfo->pNext = &RenderingInfo;
-
-		PipelineCreateInfo->basePipelineHandle = VK_NULL_HANDLE;
-		PipelineCreateInfo->basePipelineIndex = -1;
-
+		// Called from pipeline jobs, so create info is not taken from frame memory
+		VkGraphicsPipelineCreateInfo PipelineCreateInfo = { };
+		PipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		PipelineCreateInfo.stageCount = Shaders.Count;
+		PipelineCreateInfo.pStages = Shaders.Data;
+		PipelineCreateInfo.pVertexInputState = &VertexInputState;
+		PipelineCreateInfo.pInputAssemblyState = &InputAssemblyState;
+		PipelineCreateInfo.pViewportState = &ViewportState;
+		PipelineCreateInfo.pDynamicState = nullptr;
+		PipelineCreateInfo.pRasterizationState = &RasterizationState;
+		PipelineCreateInfo.pMultisampleState = &MultisampleState;
+		PipelineCreateInfo.pColorBlendState = &ColorBlendState;
+		PipelineCreateInfo.pDepthStencilState = &DepthStencilState;
+		PipelineCreateInfo.layout = PipelineLayout;
+		PipelineCreateInfo.renderPass = nullptr;
+		PipelineCreateInfo.subpass = 0;
+		PipelineCreateInfo.pNext = &RenderingInfo;
+
+		PipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		PipelineCreateInfo.basePipelineIndex = -1;
+
+		// Pipeline cache is internally synchronized and shared by all jobs
 		VkPipeline Pipeline;
-		VULKAN_CHECK_RESULT(vkCreateGraphicsPipelines(Device, VK_NULL_HANDLE, 1, PipelineCreateInfo, nullptr, &Pipeline));
+		VULKAN_CHECK_RESULT(vkCreateGraphicsPipelines(Device, ResContext.PipelineCache, 1, &PipelineCreateInfo, nullptr, &Pipeline));
 
 		Memory::FreeArray(&Shaders);
 		Memory::FreeArray(&VertexBindings);
@@ -271,6 +504,110 @@ namespace RenderResources
 		return Pipeline;
 	}
 
+	void RequestGraphicsPipeline(const char* SettingsPath, VkExtent2D Extent, const VulkanHelper::PipelineResourceInfo* ResourceInfo,
+		VkPipeline* OutPipeline)
+	{
+		GraphicsPipelineRequest* Request = Memory::ArrayGetNew(&PipelineBuild.Requests);
+		Request->SettingsPath = SettingsPath;
+		Request->Extent = Extent;
+		Request->ResourceInfo = *ResourceInfo;
+		Request->OutPipeline = OutPipeline;
+	}
+
+	static void CreatePipelinesJob()
+	{
+		VkDevice Device = ResContext.CoreContext.LogicalDevice;
+		const u32 RequestCount = (u32)PipelineBuild.Requests.Count;
+
+		for (u32 i = PipelineBuild.NextRequest.fetch_add(1); i < RequestCount; i = PipelineBuild.NextRequest.fetch_add(1))
+		{
+			GraphicsPipelineRequest* Request = &PipelineBuild.Requests.Data[i];
+
+			Yaml::Node Root;
+			Yaml::Parse(Root, Request->SettingsPath);
+
+			*Request->OutPipeline = CreateGraphicsPipeline(Device, Root, Request->Extent, Request->ResourceInfo.PipelineLayout, &Request->ResourceInfo);
+		}
+	}
+
+	// Builds requests with empty cache into scratch pipelines that are destroyed right away, then saves cache and
+	// reads it back from disk like next run does. Driver side shader caches are not affected by it
+	static f64 BuildPipelinesWithEmptyCache()
+	{
+		VkDevice Device = ResContext.CoreContext.LogicalDevice;
+		const u32 RequestCount = (u32)PipelineBuild.Requests.Count;
+
+		vkDestroyPipelineCache(Device, ResContext.PipelineCache, nullptr);
+
+		VkPipelineCacheCreateInfo CacheCreateInfo = { };
+		CacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		VULKAN_CHECK_RESULT(vkCreatePipelineCache(Device, &CacheCreateInfo, nullptr, &ResContext.PipelineCache));
+
+		auto ColdPipelines = Memory::AllocateArray<VkPipeline>(RequestCount);
+		auto Outputs = Memory::AllocateArray<VkPipeline*>(RequestCount);
+		for (u32 i = 0; i < RequestCount; ++i)
+		{
+			Outputs.Data[i] = PipelineBuild.Requests.Data[i].OutPipeline;
+			PipelineBuild.Requests.Data[i].OutPipeline = ColdPipelines.Data + i;
+		}
+
+		const f64 StartTime = glfwGetTime();
+
+		PipelineBuild.NextRequest.store(0);
+		TaskSystem::RunOnWorkers(CreatePipelinesJob, RequestCount);
+
+		const f64 ColdTime = glfwGetTime() - StartTime;
+
+		for (u32 i = 0; i < RequestCount; ++i)
+		{
+			vkDestroyPipeline(Device, ColdPipelines.Data[i], nullptr);
+			PipelineBuild.Requests.Data[i].OutPipeline = Outputs.Data[i];
+		}
+
+		Memory::FreeArray(&ColdPipelines);
+		Memory::FreeArray(&Outputs);
+
+		SaveAndDestroyPipelineCache();
+		CreatePipelineCache();
+
+		return ColdTime;
+	}
+
+	void CreateRequestedPipelines()
+	{
+		const u32 RequestCount = (u32)PipelineBuild.Requests.Count;
+
+		const bool IsBenchmark = ResContext.IsPipelineCacheBenchmark && RequestCount > 0;
+		ResContext.IsPipelineCacheBenchmark = false;
+
+		f64 ColdTime = 0.0;
+		if (IsBenchmark)
+		{
+			ColdTime = BuildPipelinesWithEmptyCache();
+		}
+
+		const f64 StartTime = glfwGetTime();
+
+		PipelineBuild.NextRequest.store(0);
+		TaskSystem::RunOnWorkers(CreatePipelinesJob, RequestCount);
+
+		const f64 Time = glfwGetTime() - StartTime;
+
+		Util::RenderLog(Util::LogType::Info, "Created %u graphics pipelines in %.2f ms", RequestCount, Time * 1000.0);
+		if (IsBenchmark)
+		{
+			Util::RenderLog(Util::LogType::Info, "Pipeline cache benchmark: %u pipelines, cold %.2f ms, warm %.2f ms",
+				RequestCount, ColdTime * 1000.0, Time * 1000.0);
+		}
+
+		Memory::ClearArray(&PipelineBuild.Requests);
+	}
+
+	void EnablePipelineCacheBenchmark()
+	{
+		ResContext.IsPipelineCacheBenchmark = true;
+	}
+
 	void DeInit()
 	{
 		VkDevice Device = ResContext.CoreContext.LogicalDevice;
@@ -279,21 +616,35 @@ namespace RenderResources
 		{
 			vkDestroyImageView(Device, ResContext.Textures[i].Resource.View, nullptr);
 			vkDestroyImage(Device, ResContext.Textures[i].Resource.MeshTexture.Image, nullptr);
-			vkFreeMemory(Device, ResContext.Textures[i].Resource.MeshTexture.Memory, nullptr);
+			DeviceMemoryAllocator::Free(&ResContext.Textures[i].Resource.MeshTexture.Allocation);
 		}
 
 		vkDestroyBuffer(Device, ResContext.MaterialBuffer.Buffer, nullptr);
-		vkFreeMemory(Device, ResContext.MaterialBuffer.Memory, nullptr);
+		DeviceMemoryAllocator::Free(&ResContext.MaterialBuffer.Allocation);
 		vkDestroyBuffer(Device, ResContext.VertexStageData.Buffer, nullptr);
-		vkFreeMemory(Device, ResContext.VertexStageData.Memory, nullptr);
+		DeviceMemoryAllocator::Free(&ResContext.VertexStageData.Allocation);
 		vkDestroyBuffer(Device, ResContext.GPUInstances.Buffer, nullptr);
-		vkFreeMemory(Device, ResContext.GPUInstances.Memory, nullptr);
+		DeviceMemoryAllocator::Free(&ResContext.GPUInstances.Allocation);
 
 		free(ResContext.Textures);
 		free(ResContext.StaticMeshes);
+		free(ResContext.StaticMeshRelocations);
 		free(ResContext.MeshInstances);
 		free(ResContext.Materials);
 
+		Memory::FreeArray(&ResContext.FreeStaticMeshIndices);
+		Memory::FreeArray(&ResContext.CompletedStaticMeshRelocations);
+		Memory::FreeArray(&ResContext.RelocatedVertexRanges);
+		Memory::FreeArray(&ResContext.DestroyedRelocatingStaticMeshes);
+		Memory::FreeArray(&ResContext.RelocatedStaticMeshReleases);
+		Memory::FreeArray(&ResContext.FreeTextureIndices);
+		Memory::FreeArray(&ResContext.PendingTextureDescriptors);
+		Memory::FreeArray(&ResContext.TextureImageInfos);
+		Memory::FreeArray(&ResContext.TextureWrites);
+		Memory::FreeArray(&PipelineBuild.Requests);
+		Memory::DestroyRangeAllocator(&ResContext.VertexRanges);
+		Memory::DestroyRangeAllocator(&ResContext.InstanceRanges);
+
 		for (auto It = ResContext.Shaders.begin(); It != ResContext.Shaders.end(); ++It)
 		{
 			vkDestroyShaderModule(Device, It->second, nullptr);
@@ -315,7 +666,9 @@ namespace RenderResources
 		ResContext.VBindings.clear();
 
 		vkDestroyDescriptorPool(Device, ResContext.MainPool, nullptr);
+		SaveAndDestroyPipelineCache();
 
+		DeviceMemoryAllocator::DeInit();
 		VulkanCoreContext::DestroyCoreContext(&ResContext.CoreContext);
 	}
 
@@ -337,6 +690,9 @@ namespace RenderResources
 
 		VkShaderModule NewShaderModule;
 		VULKAN_CHECK_RESULT(vkCreateShaderModule(Device, &shaderInfo, nullptr, &NewShaderModule));
+
+		// Shaders are created by jobs at startup
+		std::unique_lock Lock(ResContext.ShaderLock);
 		ResContext.Shaders[Name] = NewShaderModule;
 	}
 
@@ -378,25 +734,45 @@ namespace RenderResources
 			Yaml::Node& BindingsNode = Util::ParseDescriptorSetLayoutNode((*LayoutIt).second);
 
 			Memory::DynamicHeapArray<VkDescriptorSetLayoutBinding> Bindings = Memory::AllocateArray<VkDescriptorSetLayoutBinding>(1);
+			Memory::DynamicHeapArray<VkDescriptorBindingFlags> BindingFlags = Memory::AllocateArray<VkDescriptorBindingFlags>(1);
+			bool HasBindingFlags = false;
 
 			for (auto BindingIt = BindingsNode.Begin(); BindingIt != BindingsNode.End(); BindingIt++)
 			{
 				VkDescriptorSetLayoutBinding Binding = Util::ParseDescriptorSetLayoutBindingNode((*BindingIt).second);
+				const VkDescriptorBindingFlags Flags = Util::ParseDescriptorBindingFlagsNode((*BindingIt).second);
+
+				if (Flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+				{
+					// Bindless texture table, yaml count is an upper bound that is clamped to device limits
+					assert(Binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+					Binding.descriptorCount = std::min(Binding.descriptorCount, ResContext.MaxTextures);
+					ResContext.MaxTextures = Binding.descriptorCount;
+				}
+
+				HasBindingFlags |= Flags != 0;
 				Memory::PushBackToArray(&Bindings, &Binding);
+				Memory::PushBackToArray(&BindingFlags, &Flags);
 			}
 
+			VkDescriptorSetLayoutBindingFlagsCreateInfo BindingFlagsInfo = { };
+			BindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			BindingFlagsInfo.bindingCount = BindingFlags.Count;
+			BindingFlagsInfo.pBindingFlags = BindingFlags.Data;
+
 			VkDescriptorSetLayoutCreateInfo LayoutCreateInfo = { };
 			LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 			LayoutCreateInfo.bindingCount = Bindings.Count;
 			LayoutCreateInfo.pBindings = Bindings.Data;
 			LayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
-			LayoutCreateInfo.pNext = nullptr;
+			LayoutCreateInfo.pNext = HasBindingFlags ? &BindingFlagsInfo : nullptr;
 
 			VkDescriptorSetLayout NewLayout;
 			VULKAN_CHECK_RESULT(vkCreateDescriptorSetLayout(Device, &LayoutCreateInfo, nullptr, &NewLayout));
 			ResContext.DescriptorSetLayouts[(*LayoutIt).first] = NewLayout;
 
 			Memory::FreeArray(&Bindings);
+			Memory::FreeArray(&BindingFlags);
 		}
 	}
 
@@ -405,14 +781,11 @@ namespace RenderResources
 		const VkDeviceSize MaterialBufferSize = sizeof(Material) * 512 * 10 * 4;
 		ResContext.MaterialBuffer = { };
 		ResContext.MaterialBuffer.Buffer = VulkanHelper::CreateBuffer(ResContext.CoreContext.LogicalDevice, MaterialBufferSize, VulkanHelper::BufferUsageFlag::StorageFlag);
-		VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(ResContext.CoreContext.PhysicalDevice, ResContext.CoreContext.LogicalDevice,
-			ResContext.MaterialBuffer.Buffer, VulkanHelper::MemoryPropertyFlag::GPULocal);
-		ResContext.MaterialBuffer.Memory = AllocResult.Memory;
-		ResContext.MaterialBuffer.Alignment = AllocResult.Alignment;
+		ResContext.MaterialBuffer.Allocation = DeviceMemoryAllocator::AllocateBufferMemory(ResContext.MaterialBuffer.Buffer,
+			VulkanHelper::MemoryPropertyFlag::GPULocal);
+		ResContext.MaterialBuffer.Alignment = ResContext.MaterialBuffer.Allocation.Alignment;
 		ResContext.MaterialBuffer.Capacity = MaterialBufferSize;
 
-		VULKAN_CHECK_RESULT(vkBindBufferMemory(ResContext.CoreContext.LogicalDevice, ResContext.MaterialBuffer.Buffer, ResContext.MaterialBuffer.Memory, 0));
-
 		VkDescriptorBufferInfo MaterialBufferInfo;
 		MaterialBufferInfo.buffer = ResContext.MaterialBuffer.Buffer;
 		MaterialBufferInfo.offset = 0;
@@ -443,8 +816,15 @@ namespace RenderResources
 		ResContext.SpecularSampler = RenderResources::GetSampler("SpecularTexture");
 		ResContext.BindlesTexturesLayout = RenderResources::GetSetLayout("BindlesTexturesLayout");
 
+		// Last binding of the layout has variable count, set holds the whole texture table
+		VkDescriptorSetVariableDescriptorCountAllocateInfo VariableCountInfo = { };
+		VariableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+		VariableCountInfo.descriptorSetCount = 1;
+		VariableCountInfo.pDescriptorCounts = &ResContext.MaxTextures;
+
 		VkDescriptorSetAllocateInfo AllocInfoTex = { };
 		AllocInfoTex.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		AllocInfoTex.pNext = &VariableCountInfo;
 		AllocInfoTex.descriptorPool = ResContext.MainPool;
 		AllocInfoTex.descriptorSetCount = 1;
 		AllocInfoTex.pSetLayouts = &ResContext.BindlesTexturesLayout;
@@ -506,14 +886,22 @@ namespace RenderResources
 
 	u32 CreateMaterial(Material* Mat)
 	{
-		assert(ResContext.MaterialCount < ResContext.MaxMaterials);
+		if (ResContext.MaterialCount >= ResContext.MaxMaterials)
+		{
+			return InvalidIndex;
+		}
+
+		// TODO: TMP solution
+		void* TransferMemory = TransferSystem::RequestTransferMemory(sizeof(Material));
+		if (TransferMemory == nullptr)
+		{
+			return InvalidIndex;
+		}
 
 		RenderResource<Material>* NewMaterialResource = ResContext.Materials + ResContext.MaterialCount;
 		NewMaterialResource->IsLoaded = false;
 		NewMaterialResource->Resource = *Mat;
 
-		// TODO: TMP solution
-		void* TransferMemory = TransferSystem::RequestTransferMemory(sizeof(Material));
 		memcpy(TransferMemory, &NewMaterialResource->Resource, sizeof(Material));
 
 		TransferSystem::TransferTask Task = { };
@@ -531,55 +919,180 @@ namespace RenderResources
 		return ResContext.MaterialCount++;
 	}
 
+	// Granularity can't be multiple of sizeof(Meshlet), data of meshes with meshlets is moved inside their range
+	// by at most sizeof(Meshlet) - MeshletAlignment bytes instead. MeshletOffset is relative to data start
+	static u64 GetMeshletPadding(u64 RangeOffset, u64 MeshletOffset, u32 MeshletCount)
+	{
+		if (MeshletCount == 0)
+		{
+			return 0;
+		}
+
+		return (sizeof(Meshlet) - (RangeOffset + MeshletOffset) % sizeof(Meshlet)) % sizeof(Meshlet);
+	}
+
 	u32 CreateStaticMesh(MeshDescription* Description, void* Data)
 	{
-		assert(ResContext.StaticMeshCount < ResContext.MaxStaticMeshes);
+		void* TransferMemory;
+		const u32 Index = ReserveStaticMesh(Description, &TransferMemory);
+		if (Index == InvalidIndex)
+		{
+			return InvalidIndex;
+		}
+
+		memcpy(TransferMemory, Data, ResContext.StaticMeshes[Index].Resource.VertexDataSize);
+
+		SubmitStaticMesh(Index, TransferMemory);
+		return Index;
+	}
+
+	u32 ReserveStaticMesh(MeshDescription* Description, void** OutData)
+	{
+		assert(Description->IndexType == VK_INDEX_TYPE_UINT16 || Description->IndexType == VK_INDEX_TYPE_UINT32);
 
+		const u32 IndexSize = Description->IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(u16) : sizeof(u32);
 		const u64 VerticesSize = Description->VertexSize * Description->VerticesCount;
-		const u64 DataSize = sizeof(u32) * Description->IndicesCount + VerticesSize;
+		u64 DataSize = IndexSize * Description->IndicesCount + VerticesSize;
+
+		// Culling reads meshlets straight from vertex buffer
+		const u64 MeshletOffset = Math::AlignNumber(DataSize, MeshletAlignment);
+		u64 RangeSize = DataSize;
+		if (Description->MeshletCount > 0)
+		{
+			DataSize = MeshletOffset + Description->MeshletCount * sizeof(Meshlet);
+			RangeSize = DataSize + sizeof(Meshlet) - MeshletAlignment;
+		}
+
+		std::unique_lock Lock(ResContext.RangeLock);
 
+		u64 RangeOffset;
+		if (!Memory::RangeAlloc(&ResContext.VertexRanges, RangeSize, &RangeOffset))
+		{
+			// Loader keeps mesh pending and retries after CompactStaticMeshes merges free space
+			ResContext.IsVertexCompactionNeeded = true;
+			return InvalidIndex;
+		}
+
+		// Requested after range, reserved transfer memory can't be given back
 		// TODO: TMP solution
-		void* TransferMemory = TransferSystem::RequestTransferMemory(DataSize);
-		memcpy(TransferMemory, Data, DataSize);
+		*OutData = TransferSystem::RequestTransferMemory(DataSize);
+		if (*OutData == nullptr)
+		{
+			Memory::RangeFree(&ResContext.VertexRanges, RangeOffset, RangeSize);
+			return InvalidIndex;
+		}
 
-		RenderResource<VertexData>* Resource = &ResContext.StaticMeshes[ResContext.StaticMeshCount];
+		u32 Index;
+		if (ResContext.FreeStaticMeshIndices.Count > 0)
+		{
+			Index = ResContext.FreeStaticMeshIndices.Data[--ResContext.FreeStaticMeshIndices.Count];
+		}
+		else
+		{
+			assert(ResContext.StaticMeshCount < ResContext.MaxStaticMeshes);
+			Index = ResContext.StaticMeshCount++;
+		}
+
+		ResContext.StaticMeshRelocations[Index] = UINT64_MAX;
+
+		Lock.unlock();
+
+		const u64 VertexOffset = RangeOffset + GetMeshletPadding(RangeOffset, MeshletOffset, Description->MeshletCount);
+		assert(VertexOffset % Description->VertexSize == 0 && VerticesSize % sizeof(u32) == 0);
+
+		RenderResource<VertexData>* Resource = &ResContext.StaticMeshes[Index];
 		Resource->IsLoaded = false;
+		Resource->Resource.RangeOffset = RangeOffset;
+		Resource->Resource.RangeSize = RangeSize;
 		Resource->Resource.IndicesCount = Description->IndicesCount;
-		Resource->Resource.VertexOffset = ResContext.VertexStageData.Offset;
-		Resource->Resource.IndexOffset = ResContext.VertexStageData.Offset + VerticesSize;
+		Resource->Resource.VertexOffset = VertexOffset;
+		Resource->Resource.IndexOffset = VertexOffset + VerticesSize;
 		Resource->Resource.VertexDataSize = DataSize;
+		Resource->Resource.VertexSize = (u32)Description->VertexSize;
+		Resource->Resource.IndexSize = IndexSize;
+		Resource->Resource.IndexType = Description->IndexType;
+
+		assert(Description->LodCount <= MAX_MESH_LODS);
+		if (Description->LodCount > 0)
+		{
+			Resource->Resource.LodCount = Description->LodCount;
+			memcpy(Resource->Resource.Lods, Description->Lods, Description->LodCount * sizeof(MeshLod));
+		}
+		else
+		{
+			Resource->Resource.LodCount = 1;
+			Resource->Resource.Lods[0] = { 0, (u32)Description->IndicesCount, 0.0f };
+		}
+		Resource->Resource.MeshletOffset = VertexOffset + MeshletOffset;
+		Resource->Resource.MeshletCount = Description->MeshletCount;
+		Resource->Resource.BoundingSphere = Description->BoundingSphere;
+
+		return Index;
+	}
+
+	void SubmitStaticMesh(u32 Index, void* Data)
+	{
+		VertexData* Mesh = &ResContext.StaticMeshes[Index].Resource;
 
 		TransferSystem::TransferTask Task = { };
-		Task.DataSize = DataSize;
+		Task.DataSize = Mesh->VertexDataSize;
 		Task.Alignment = 1;
 		Task.DataDescr.DstBuffer = ResContext.VertexStageData.Buffer;
-		Task.DataDescr.DstOffset = ResContext.VertexStageData.Offset;
-		Task.RawData = TransferMemory;
-		Task.ResourceIndex = ResContext.StaticMeshCount;
+		Task.DataDescr.DstOffset = Mesh->VertexOffset;
+		Task.RawData = Data;
+		Task.ResourceIndex = Index;
 		Task.Type = ResourceType::Mesh;
 
 		AddTask(&Task);
-
-		ResContext.VertexStageData.Offset += DataSize;
-		return ResContext.StaticMeshCount++;
 	}
 
 	u32 CreateTexture(TextureDescription* Description, void* Data)
 	{
-		assert(ResContext.TextureCount < ResContext.MaxTextures);
+		assert(Description->MipLevels > 0 && Description->ArrayLayers > 0);
 
 		VkDevice Device = VulkanInterface::GetDevice();
-		VkPhysicalDevice PhysicalDevice = VulkanInterface::GetPhysicalDevice();
 		VkQueue TransferQueue = VulkanInterface::GetTransferQueue();
 
-		const u64 Index = ResContext.TextureCount;
-		RenderResource<MeshTexture2D>* Resource = &ResContext.Textures[ResContext.TextureCount];
+		// Subresource offsets are stored right after the texel data so the transfer system can build copy regions
+		const u32 SubresourceCount = Description->MipLevels * Description->ArrayLayers;
+		const u64 OffsetsSize = SubresourceCount * sizeof(u64);
+
+		std::unique_lock Lock(ResContext.TextureLock);
+
+		u32 Index;
+		if (ResContext.FreeTextureIndices.Count > 0)
+		{
+			Index = ResContext.FreeTextureIndices.Data[--ResContext.FreeTextureIndices.Count];
+		}
+		else if (ResContext.TextureCount < ResContext.MaxTextures)
+		{
+			Index = ResContext.TextureCount++;
+		}
+		else
+		{
+			return InvalidIndex;
+		}
+
+		// Requested after index and before image, reserved transfer memory can't be given back
+		// TODO: TMP solution
+		u8* TransferMemory = (u8*)TransferSystem::RequestTransferMemory(Description->DataSize + OffsetsSize);
+		if (TransferMemory == nullptr)
+		{
+			Memory::PushBackToArray(&ResContext.FreeTextureIndices, &Index);
+			return InvalidIndex;
+		}
+
+		Lock.unlock();
+
+		RenderResource<MeshTexture2D>* Resource = &ResContext.Textures[Index];
 		Resource->IsLoaded = false;
 
 		MeshTexture2D* NextTexture = &Resource->Resource;
 
 		NextTexture->MeshTexture.Width = Description->Width;
 		NextTexture->MeshTexture.Height = Description->Height;
+		NextTexture->MeshTexture.MipLevels = Description->MipLevels;
+		NextTexture->MeshTexture.ArrayLayers = Description->ArrayLayers;
 
 		VkImageCreateInfo ImageCreateInfo = { };
 		ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -587,8 +1100,8 @@ namespace RenderResources
 		ImageCreateInfo.extent.width = Description->Width;
 		ImageCreateInfo.extent.height = Description->Height;
 		ImageCreateInfo.extent.depth = 1;
-		ImageCreateInfo.mipLevels = 1;
-		ImageCreateInfo.arrayLayers = 1;
+		ImageCreateInfo.mipLevels = Description->MipLevels;
+		ImageCreateInfo.arrayLayers = Description->ArrayLayers;
 		ImageCreateInfo.format = Description->Format;
 		ImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 		ImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -599,106 +1112,497 @@ namespace RenderResources
 
 		VULKAN_CHECK_RESULT(vkCreateImage(Device, &ImageCreateInfo, nullptr, &NextTexture->MeshTexture.Image));
 
-		VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device,
-			NextTexture->MeshTexture.Image, VulkanHelper::MemoryPropertyFlag::GPULocal);
-		NextTexture->MeshTexture.Memory = AllocResult.Memory;
-		NextTexture->MeshTexture.Alignment = AllocResult.Alignment;
-		NextTexture->MeshTexture.Size = AllocResult.Size;
-		VULKAN_CHECK_RESULT(vkBindImageMemory(Device, NextTexture->MeshTexture.Image, NextTexture->MeshTexture.Memory, 0));
+		NextTexture->MeshTexture.Allocation = DeviceMemoryAllocator::AllocateImageMemory(NextTexture->MeshTexture.Image,
+			VulkanHelper::MemoryPropertyFlag::GPULocal);
+		NextTexture->MeshTexture.Alignment = NextTexture->MeshTexture.Allocation.Alignment;
+		NextTexture->MeshTexture.Size = NextTexture->MeshTexture.Allocation.Size;
 
 		VkImageViewCreateInfo ViewCreateInfo = { };
 		ViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		ViewCreateInfo.flags = 0;
-		ViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		ViewCreateInfo.format = VK_FORMAT_BC7_SRGB_BLOCK;
+		ViewCreateInfo.viewType = Description->ArrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+		ViewCreateInfo.format = Description->Format;
 		ViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 		ViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
 		ViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
 		ViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
 		ViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		ViewCreateInfo.subresourceRange.baseMipLevel = 0;
-		ViewCreateInfo.subresourceRange.levelCount = 1;
+		ViewCreateInfo.subresourceRange.levelCount = Description->MipLevels;
 		ViewCreateInfo.subresourceRange.baseArrayLayer = 0;
-		ViewCreateInfo.subresourceRange.layerCount = 1;
+		ViewCreateInfo.subresourceRange.layerCount = Description->ArrayLayers;
 		ViewCreateInfo.image = NextTexture->MeshTexture.Image;
 
 		VULKAN_CHECK_RESULT(vkCreateImageView(Device, &ViewCreateInfo, nullptr, &NextTexture->View));
 
-		VkDescriptorImageInfo DiffuseImageInfo = { };
-		DiffuseImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		DiffuseImageInfo.sampler = ResContext.DiffuseSampler;
-		DiffuseImageInfo.imageView = NextTexture->View;
-
-		VkDescriptorImageInfo SpecularImageInfo = { };
-		SpecularImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		SpecularImageInfo.sampler = ResContext.SpecularSampler;
-		SpecularImageInfo.imageView = NextTexture->View;
-
-		VkWriteDescriptorSet WriteDiffuse = { };
-		WriteDiffuse.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		WriteDiffuse.dstSet = ResContext.BindlesTexturesSet;
-		WriteDiffuse.dstBinding = 0;
-		WriteDiffuse.dstArrayElement = Index;
-		WriteDiffuse.descriptorCount = 1;
-		WriteDiffuse.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		WriteDiffuse.pImageInfo = &DiffuseImageInfo;
-
-		VkWriteDescriptorSet WriteSpecular = { };
-		WriteSpecular.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		WriteSpecular.dstSet = ResContext.BindlesTexturesSet;
-		WriteSpecular.dstBinding = 1;
-		WriteSpecular.dstArrayElement = Index;
-		WriteSpecular.descriptorCount = 1;
-		WriteSpecular.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		WriteSpecular.pImageInfo = &SpecularImageInfo;
-
-		VkWriteDescriptorSet Writes[] = { WriteDiffuse, WriteSpecular };
-		vkUpdateDescriptorSets(VulkanInterface::GetDevice(), 2, Writes, 0, nullptr);
+		// Queued before the upload, so descriptor is written before any entity that uses the texture becomes drawable
+		const PendingTextureDescriptor Pending = { Index, NextTexture->View };
+		Lock.lock();
+		Memory::PushBackToArray(&ResContext.PendingTextureDescriptors, &Pending);
+		Lock.unlock();
 
-		// TODO: TMP solution
-		void* TransferMemory = TransferSystem::RequestTransferMemory(NextTexture->MeshTexture.Size);
-		memcpy(TransferMemory, Data, NextTexture->MeshTexture.Size);
+		memcpy(TransferMemory, Data, Description->DataSize);
+		memcpy(TransferMemory + Description->DataSize, Description->SubresourceOffsets, OffsetsSize);
 
 		TransferSystem::TransferTask Task = { };
-		Task.DataSize = NextTexture->MeshTexture.Size;
+		Task.DataSize = Description->DataSize;
 		Task.Alignment = VulkanHelper::GetFormatAlignment(ImageCreateInfo.format);
 		Task.TextureDescr.DstImage = NextTexture->MeshTexture.Image;
 		Task.TextureDescr.Width = Description->Width;
 		Task.TextureDescr.Height = Description->Height;
+		Task.TextureDescr.MipLevels = Description->MipLevels;
+		Task.TextureDescr.ArrayLayers = Description->ArrayLayers;
+		Task.TextureDescr.SubresourceOffsets = (u64*)(TransferMemory + Description->DataSize);
 		Task.RawData = TransferMemory;
 		Task.ResourceIndex = Index;
 		Task.Type = ResourceType::Texture;
 
 		AddTask(&Task);
-		ResContext.TextureCount++;
 		return Index;
 	}
 
+#ifdef NORMAL_MATRIX_SIMD
+	static __m128 Cross(__m128 A, __m128 B)
+	{
+		const __m128 AYZX = _mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 BYZX = _mm_shuffle_ps(B, B, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 Result = _mm_sub_ps(_mm_mul_ps(A, BYZX), _mm_mul_ps(AYZX, B));
+		return _mm_shuffle_ps(Result, Result, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+#endif
+
+	// Inverse transpose of upper 3x3 built from cofactor columns, equals the 3x3 itself for rotations
+	static void ComputeNormalMatrix(const glm::mat4& ModelMatrix, glm::vec3* OutColumns)
+	{
+#ifdef NORMAL_MATRIX_SIMD
+		const __m128 Column0 = _mm_loadu_ps(&ModelMatrix[0][0]);
+		const __m128 Column1 = _mm_loadu_ps(&ModelMatrix[1][0]);
+		const __m128 Column2 = _mm_loadu_ps(&ModelMatrix[2][0]);
+
+		__m128 Cofactors[3];
+		Cofactors[0] = Cross(Column1, Column2);
+		Cofactors[1] = Cross(Column2, Column0);
+		Cofactors[2] = Cross(Column0, Column1);
+
+		// W lanes are zero after cross, horizontal sum of products is determinant
+		__m128 Determinant = _mm_mul_ps(Column0, Cofactors[0]);
+		Determinant = _mm_add_ps(Determinant, _mm_shuffle_ps(Determinant, Determinant, _MM_SHUFFLE(2, 3, 0, 1)));
+		Determinant = _mm_add_ss(Determinant, _mm_movehl_ps(Determinant, Determinant));
+		const __m128 InverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), _mm_shuffle_ps(Determinant, Determinant, 0));
+
+		for (u32 i = 0; i < 3; ++i)
+		{
+			alignas(16) f32 Column[4];
+			_mm_store_ps(Column, _mm_mul_ps(Cofactors[i], InverseDeterminant));
+			OutColumns[i] = glm::vec3(Column[0], Column[1], Column[2]);
+		}
+#else
+		const glm::mat3 NormalMatrix = glm::transpose(glm::inverse(glm::mat3(ModelMatrix)));
+		OutColumns[0] = NormalMatrix[0];
+		OutColumns[1] = NormalMatrix[1];
+		OutColumns[2] = NormalMatrix[2];
+#endif
+	}
+
+	static void ComputeNormalMatricesJob()
+	{
+		NormalMatrixJob* Job = &NormalMatrixBuild;
+		for (u64 Chunk = Job->NextChunk.fetch_add(1); Chunk * NormalMatrixChunkSize < Job->Count; Chunk = Job->NextChunk.fetch_add(1))
+		{
+			const u64 End = std::min(Job->Count, (Chunk + 1) * NormalMatrixChunkSize);
+			for (u64 i = Chunk * NormalMatrixChunkSize; i < End; ++i)
+			{
+				ComputeNormalMatrix(Job->Instances[i].ModelMatrix, Job->Instances[i].NormalMatrix);
+			}
+		}
+	}
+
+	void ComputeNormalMatrices(InstanceData* Instances, u64 Count)
+	{
+		if (Count <= NormalMatrixChunkSize)
+		{
+			for (u64 i = 0; i < Count; ++i)
+			{
+				ComputeNormalMatrix(Instances[i].ModelMatrix, Instances[i].NormalMatrix);
+			}
+
+			return;
+		}
+
+		NormalMatrixBuild.Instances = Instances;
+		NormalMatrixBuild.Count = Count;
+		NormalMatrixBuild.NextChunk.store(0);
+
+		TaskSystem::RunOnWorkers(ComputeNormalMatricesJob, (u32)((Count + NormalMatrixChunkSize - 1) / NormalMatrixChunkSize));
+	}
+
 	u32 CreateStaticMeshInstance(InstanceData* Data)
 	{
-		assert(ResContext.MeshInstanceCount < ResContext.MaxMeshInstances);
+		std::unique_lock Lock(ResContext.RangeLock);
 
-		RenderResource<InstanceData>* Resource = &ResContext.MeshInstances[ResContext.MeshInstanceCount];
-		Resource->IsLoaded = false;
-		Resource->Resource = *Data;
+		u64 Index;
+		if (!Memory::RangeAlloc(&ResContext.InstanceRanges, 1, &Index))
+		{
+			return InvalidIndex;
+		}
 
+		// Requested after range, reserved transfer memory can't be given back
 		// TODO: TMP solution
 		void* TransferMemory = TransferSystem::RequestTransferMemory(sizeof(InstanceData));
+		if (TransferMemory == nullptr)
+		{
+			Memory::RangeFree(&ResContext.InstanceRanges, Index, 1);
+			return InvalidIndex;
+		}
+
+		ResContext.MeshInstanceCount++;
+
+		Lock.unlock();
+
+		RenderResource<InstanceData>* Resource = &ResContext.MeshInstances[Index];
+		Resource->IsLoaded = false;
+		Resource->Resource = *Data;
+
 		memcpy(TransferMemory, &Resource->Resource, sizeof(InstanceData));
 
 		TransferSystem::TransferTask Task = { };
 		Task.DataSize = sizeof(InstanceData);
 		Task.Alignment = 1;
 		Task.DataDescr.DstBuffer = ResContext.GPUInstances.Buffer;
-		Task.DataDescr.DstOffset = ResContext.GPUInstances.Offset;
+		Task.DataDescr.DstOffset = Index * sizeof(InstanceData);
 		Task.RawData = TransferMemory;
-		Task.ResourceIndex = ResContext.MeshInstanceCount;
+		Task.ResourceIndex = (u32)Index;
 		Task.Type = ResourceType::Instance;
 
 		AddTask(&Task);
 
-		ResContext.GPUInstances.Offset += Task.DataSize;
-		return ResContext.MeshInstanceCount++;
+		return (u32)Index;
+	}
+
+	static void ReleaseTexture(u64 Index, u64)
+	{
+		const u32 TextureIndex = (u32)Index;
+
+		std::unique_lock Lock(ResContext.TextureLock);
+		Memory::PushBackToArray(&ResContext.FreeTextureIndices, &TextureIndex);
+	}
+
+	void DestroyTexture(u32 Index)
+	{
+		assert(Index < ResContext.TextureCount);
+
+		RenderResource<MeshTexture2D>* Resource = &ResContext.Textures[Index];
+		// Texture can not be unloaded while its upload is in fly
+		assert(Resource->IsLoaded);
+		Resource->IsLoaded = false;
+		Residency::OnResourceUnloaded(Index, ResourceType::Texture);
+
+		std::unique_lock Lock(ResContext.TextureLock);
+
+		// Descriptor of texture that was destroyed before flush must not reference deleted view
+		Memory::DynamicHeapArray<PendingTextureDescriptor>* PendingDescriptors = &ResContext.PendingTextureDescriptors;
+		for (u64 i = 0; i < PendingDescriptors->Count; ++i)
+		{
+			if (PendingDescriptors->Data[i].Index == Index)
+			{
+				PendingDescriptors->Data[i] = PendingDescriptors->Data[--PendingDescriptors->Count];
+				break;
+			}
+		}
+
+		Lock.unlock();
+
+		DeletionQueue::DestroyImageView(Resource->Resource.View);
+		DeletionQueue::DestroyImage(Resource->Resource.MeshTexture.Image);
+		DeletionQueue::FreeMemory(&Resource->Resource.MeshTexture.Allocation);
+		// Stale descriptor stays in the table, partially bound slot is not accessed until index is reused
+		DeletionQueue::DeferCallback(ReleaseTexture, Index, 0);
+
+		Resource->Resource = { };
+	}
+
+	void FlushTextureDescriptors()
+	{
+		std::unique_lock Lock(ResContext.TextureLock);
+
+		const u64 PendingCount = ResContext.PendingTextureDescriptors.Count;
+		if (PendingCount == 0)
+		{
+			return;
+		}
+
+		Memory::ReserveArray(&ResContext.TextureImageInfos, PendingCount * 2);
+		Memory::ReserveArray(&ResContext.TextureWrites, PendingCount * 2);
+
+		// Image infos of one binding are contiguous, so writes of consecutive indices merge into one write per binding
+		VkDescriptorImageInfo* DiffuseInfos = ResContext.TextureImageInfos.Data;
+		VkDescriptorImageInfo* SpecularInfos = DiffuseInfos + PendingCount;
+		VkWriteDescriptorSet* Writes = ResContext.TextureWrites.Data;
+		u32 WriteCount = 0;
+
+		for (u64 i = 0; i < PendingCount; ++i)
+		{
+			const PendingTextureDescriptor* Pending = &ResContext.PendingTextureDescriptors.Data[i];
+
+			DiffuseInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			DiffuseInfos[i].sampler = ResContext.DiffuseSampler;
+			DiffuseInfos[i].imageView = Pending->View;
+
+			SpecularInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			SpecularInfos[i].sampler = ResContext.SpecularSampler;
+			SpecularInfos[i].imageView = Pending->View;
+
+			if (i > 0 && Pending->Index == ResContext.PendingTextureDescriptors.Data[i - 1].Index + 1)
+			{
+				Writes[WriteCount - 2].descriptorCount++;
+				Writes[WriteCount - 1].descriptorCount++;
+				continue;
+			}
+
+			VkWriteDescriptorSet* WriteDiffuse = &Writes[WriteCount++];
+			*WriteDiffuse = { };
+			WriteDiffuse->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			WriteDiffuse->dstSet = ResContext.BindlesTexturesSet;
+			WriteDiffuse->dstBinding = 0;
+			WriteDiffuse->dstArrayElement = Pending->Index;
+			WriteDiffuse->descriptorCount = 1;
+			WriteDiffuse->descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			WriteDiffuse->pImageInfo = &DiffuseInfos[i];
+
+			VkWriteDescriptorSet* WriteSpecular = &Writes[WriteCount++];
+			*WriteSpecular = *WriteDiffuse;
+			WriteSpecular->dstBinding = 1;
+			WriteSpecular->pImageInfo = &SpecularInfos[i];
+		}
+
+		vkUpdateDescriptorSets(VulkanInterface::GetDevice(), WriteCount, Writes, 0, nullptr);
+		Memory::ClearArray(&ResContext.PendingTextureDescriptors);
+	}
+
+	// Called under RangeLock
+	static void FreeVertexRange(u64 Offset, u64 Size)
+	{
+		Memory::RangeAllocator* Ranges = &ResContext.VertexRanges;
+		Memory::RangeFree(Ranges, Offset, Size);
+
+		const u64 ScatteredBytes = Ranges->Capacity - Ranges->Used - Memory::RangeLargestFree(Ranges);
+		if (ScatteredBytes >= MaxScatteredVertexBytes || Ranges->FreeRanges.Count >= MaxVertexFreeRanges)
+		{
+			ResContext.IsVertexCompactionNeeded = true;
+		}
+	}
+
+	static void ReleaseStaticMesh(u64 Index, u64)
+	{
+		const VertexData* Mesh = &ResContext.StaticMeshes[Index].Resource;
+		const u32 MeshIndex = (u32)Index;
+
+		std::unique_lock Lock(ResContext.RangeLock);
+		FreeVertexRange(Mesh->RangeOffset, Mesh->RangeSize);
+		Memory::PushBackToArray(&ResContext.FreeStaticMeshIndices, &MeshIndex);
+	}
+
+	static void ReleaseVertexRange(u64 Offset, u64 Size)
+	{
+		std::unique_lock Lock(ResContext.RangeLock);
+		FreeVertexRange(Offset, Size);
+	}
+
+	static void ReleaseStaticMeshInstance(u64 Index, u64)
+	{
+		std::unique_lock Lock(ResContext.RangeLock);
+		Memory::RangeFree(&ResContext.InstanceRanges, Index, 1);
+		ResContext.MeshInstanceCount--;
+	}
+
+	void DestroyStaticMesh(u32 Index)
+	{
+		assert(Index < ResContext.StaticMeshCount);
+
+		RenderResource<VertexData>* Resource = &ResContext.StaticMeshes[Index];
+		// Mesh can not be unloaded while its upload is in fly
+		assert(Resource->IsLoaded);
+
+		// Not loaded mesh is not picked by CompactStaticMeshes, so no relocation starts after this
+		std::unique_lock Lock(ResContext.RangeLock);
+		Resource->IsLoaded = false;
+		const bool IsRelocating = ResContext.StaticMeshRelocations[Index] != UINT64_MAX;
+		if (IsRelocating)
+		{
+			// Copy still writes into new range, both ranges are released once offsets are switched
+			Memory::PushBackToArray(&ResContext.DestroyedRelocatingStaticMeshes, &Index);
+		}
+		Lock.unlock();
+
+		Residency::OnResourceUnloaded(Index, ResourceType::Mesh);
+
+		if (!IsRelocating)
+		{
+			DeletionQueue::DeferCallback(ReleaseStaticMesh, Index, 0);
+		}
+	}
+
+	void DestroyStaticMeshInstance(u32 Index)
+	{
+		RenderResource<InstanceData>* Resource = &ResContext.MeshInstances[Index];
+		assert(Resource->IsLoaded);
+		Resource->IsLoaded = false;
+		Residency::OnResourceUnloaded(Index, ResourceType::Instance);
+
+		DeletionQueue::DeferCallback(ReleaseStaticMeshInstance, Index, 0);
+	}
+
+	// Called from transfer thread, offsets are read by render thread without lock and are switched in ApplyStaticMeshRelocations
+	static void CompleteStaticMeshRelocation(u32 Index)
+	{
+		std::unique_lock Lock(ResContext.RangeLock);
+		assert(ResContext.StaticMeshRelocations[Index] != UINT64_MAX);
+		Memory::PushBackToArray(&ResContext.CompletedStaticMeshRelocations, &Index);
+	}
+
+	void ApplyStaticMeshRelocations()
+	{
+		std::unique_lock Lock(ResContext.RangeLock);
+
+		for (u64 i = 0; i < ResContext.CompletedStaticMeshRelocations.Count; ++i)
+		{
+			const u32 Index = ResContext.CompletedStaticMeshRelocations.Data[i];
+			VertexData* Mesh = &ResContext.StaticMeshes[Index].Resource;
+
+			const u64 OldOffset = Mesh->VertexOffset;
+			const u64 NewRangeOffset = ResContext.StaticMeshRelocations[Index];
+			const u64 NewOffset = NewRangeOffset + GetMeshletPadding(NewRangeOffset, Mesh->MeshletOffset - OldOffset, Mesh->MeshletCount);
+
+			// Both ranges hold the same data until old one is released, draws recorded with any of offsets stay valid
+			Mesh->IndexOffset = (u32)(NewOffset + (Mesh->IndexOffset - OldOffset));
+			Mesh->MeshletOffset = NewOffset + (Mesh->MeshletOffset - OldOffset);
+			Mesh->VertexOffset = NewOffset;
+			ResContext.StaticMeshRelocations[Index] = UINT64_MAX;
+
+			const Memory::FreeRange OldRange = { Mesh->RangeOffset, Mesh->RangeSize };
+			Mesh->RangeOffset = NewRangeOffset;
+			Memory::PushBackToArray(&ResContext.RelocatedVertexRanges, &OldRange);
+
+			Memory::DynamicHeapArray<u32>* Destroyed = &ResContext.DestroyedRelocatingStaticMeshes;
+			for (u64 j = 0; j < Destroyed->Count; ++j)
+			{
+				if (Destroyed->Data[j] == Index)
+				{
+					Destroyed->Data[j] = Destroyed->Data[--Destroyed->Count];
+					Memory::PushBackToArray(&ResContext.RelocatedStaticMeshReleases, &Index);
+					break;
+				}
+			}
+		}
+
+		Memory::ClearArray(&ResContext.CompletedStaticMeshRelocations);
+
+		// Release callbacks take RangeLock while deletion queue holds its own lock
+		Lock.unlock();
+
+		// Keyed to frame that is recorded next, so every frame that could read old offsets is covered
+		for (u64 i = 0; i < ResContext.RelocatedVertexRanges.Count; ++i)
+		{
+			const Memory::FreeRange* Range = ResContext.RelocatedVertexRanges.Data + i;
+			DeletionQueue::DeferCallback(ReleaseVertexRange, Range->Offset, Range->Size);
+		}
+
+		Memory::ClearArray(&ResContext.RelocatedVertexRanges);
+
+		// Releases new range and index of meshes that were destroyed during relocation
+		for (u64 i = 0; i < ResContext.RelocatedStaticMeshReleases.Count; ++i)
+		{
+			DeletionQueue::DeferCallback(ReleaseStaticMesh, ResContext.RelocatedStaticMeshReleases.Data[i], 0);
+		}
+
+		Memory::ClearArray(&ResContext.RelocatedStaticMeshReleases);
+	}
+
+	u64 CompactStaticMeshes(u64 MaxBytesToMove)
+	{
+		std::unique_lock Lock(ResContext.RangeLock);
+
+		if (!ResContext.IsVertexCompactionNeeded)
+		{
+			return 0;
+		}
+
+		// Set again when work is left for next call, releases of moved ranges check scattering once copies complete
+		ResContext.IsVertexCompactionNeeded = false;
+
+		// Single free range means vertex data is already packed
+		if (ResContext.VertexRanges.FreeRanges.Count <= 1)
+		{
+			return 0;
+		}
+
+		auto Candidates = Memory::AllocateArray<u32>(64);
+		for (u32 i = 0; i < ResContext.StaticMeshCount; ++i)
+		{
+			if (ResContext.StaticMeshes[i].IsLoaded && ResContext.StaticMeshRelocations[i] == UINT64_MAX)
+			{
+				Memory::PushBackToArray(&Candidates, &i);
+			}
+		}
+
+		// Meshes at the end of buffer are moved first so free space gathers at the end
+		std::sort(Candidates.Data, Candidates.Data + Candidates.Count, [](u32 A, u32 B)
+		{
+			return ResContext.StaticMeshes[A].Resource.VertexOffset > ResContext.StaticMeshes[B].Resource.VertexOffset;
+		});
+
+		u64 BytesScheduled = 0;
+		for (u64 i = 0; i < Candidates.Count; ++i)
+		{
+			const u32 Index = Candidates.Data[i];
+			const VertexData* Mesh = &ResContext.StaticMeshes[Index].Resource;
+
+			if (BytesScheduled + Mesh->VertexDataSize > MaxBytesToMove)
+			{
+				// Mesh larger than whole budget is never moved, others fit into budget of next call
+				if (BytesScheduled > 0)
+				{
+					ResContext.IsVertexCompactionNeeded = true;
+				}
+
+				continue;
+			}
+
+			// New range ends before old one starts, copy never overlaps
+			u64 NewRangeOffset;
+			if (!Memory::RangeAllocBelow(&ResContext.VertexRanges, Mesh->RangeSize, Mesh->RangeOffset, &NewRangeOffset))
+			{
+				continue;
+			}
+
+			void* TransferMemory = TransferSystem::RequestTransferMemory(0);
+			if (TransferMemory == nullptr)
+			{
+				Memory::RangeFree(&ResContext.VertexRanges, NewRangeOffset, Mesh->RangeSize);
+				ResContext.IsVertexCompactionNeeded = true;
+				break;
+			}
+
+			ResContext.StaticMeshRelocations[Index] = NewRangeOffset;
+
+			TransferSystem::TransferTask Task = { };
+			Task.DataSize = Mesh->VertexDataSize;
+			Task.Alignment = 1;
+			Task.CopyDescr.SrcBuffer = ResContext.VertexStageData.Buffer;
+			Task.CopyDescr.SrcOffset = Mesh->VertexOffset;
+			Task.CopyDescr.DstBuffer = ResContext.VertexStageData.Buffer;
+			Task.CopyDescr.DstOffset = NewRangeOffset + GetMeshletPadding(NewRangeOffset, Mesh->MeshletOffset - Mesh->VertexOffset, Mesh->MeshletCount);
+			Task.RawData = TransferMemory;
+			Task.ResourceIndex = Index;
+			Task.Type = ResourceType::MeshRelocation;
+
+			AddTask(&Task);
+
+			BytesScheduled += Mesh->VertexDataSize;
+		}
+
+		Memory::FreeArray(&Candidates);
+		return BytesScheduled;
 	}
 
 	VertexData* GetStaticMesh(u32 Index)
@@ -716,28 +1620,27 @@ namespace RenderResources
 		return &ResContext.Textures[Index].Resource;
 	}
 
-	bool IsDrawEntityLoaded(const Render::DrawEntity* Entity)
+	Material* GetMaterial(u32 Index)
 	{
-		RenderResource<VertexData>* MeshResource = ResContext.StaticMeshes + Entity->StaticMeshIndex;
-		if (!MeshResource->IsLoaded) return false;
+		return &ResContext.Materials[Index].Resource;
+	}
 
-		RenderResource<InstanceData>* InstanceResource = ResContext.MeshInstances + Entity->InstanceDataIndex;
-		for (u32 i = Entity->InstanceDataIndex; i < Entity->Instances; ++i)
+	bool IsResourceLoaded(u32 ResourceIndex, ResourceType Type)
+	{
+		switch (Type)
 		{
-			InstanceResource = ResContext.MeshInstances + i;
-			if (!InstanceResource->IsLoaded) return false;
+			case RenderResources::ResourceType::Texture:
+				return ResContext.Textures[ResourceIndex].IsLoaded;
+			case RenderResources::ResourceType::Mesh:
+				return ResContext.StaticMeshes[ResourceIndex].IsLoaded;
+			case RenderResources::ResourceType::Material:
+				return ResContext.Materials[ResourceIndex].IsLoaded;
+			case RenderResources::ResourceType::Instance:
+				return ResContext.MeshInstances[ResourceIndex].IsLoaded;
+			default:
+				assert(false);
+				return false;
 		}
-
-		RenderResource<Material>* MaterialResource = ResContext.Materials + InstanceResource->Resource.MaterialIndex;
-		if (!MaterialResource->IsLoaded) return false;
-
-		Material* Material = &MaterialResource->Resource;
-		RenderResource<MeshTexture2D>* AlbedoTexture = ResContext.Textures + Material->AlbedoTexIndex;
-		if (!AlbedoTexture->IsLoaded) return false;
-
-		RenderResource<MeshTexture2D>* SpecTexture = ResContext.Textures + Material->SpecularTexIndex;
-		if (!SpecTexture->IsLoaded) return false;
-		return true;
 	}
 
 	void SetResourceReadyToRender(u32 ResourceIndex, ResourceType Type)
@@ -756,10 +1659,16 @@ namespace RenderResources
 			case RenderResources::ResourceType::Instance:
 				ResContext.MeshInstances[ResourceIndex].IsLoaded = true;
 				break;
+			case RenderResources::ResourceType::MeshRelocation:
+				CompleteStaticMeshRelocation(ResourceIndex);
+				return;
 			default:
 				assert(false);
-				break;
+				return;
 		}
+
+		// Loaded state is stored first, entity that reads it as not loaded waits for this event
+		Residency::OnResourceLoaded(ResourceIndex, Type);
 	}
 
 	VkDescriptorSetLayout GetBindlesTexturesLayout()
@@ -782,6 +1691,23 @@ namespace RenderResources
 		return ResContext.MaterialSet;
 	}
 
+	u32 GetInstanceBatchRegion(u32 Frame)
+	{
+		assert(Frame < VulkanHelper::MAX_DRAW_FRAMES);
+		return ResContext.MaxMeshInstances * (Frame + 1);
+	}
+
+	u32 GetInstanceViewRegion(u32 Frame, u32 View)
+	{
+		assert(Frame < VulkanHelper::MAX_DRAW_FRAMES && View < MAX_DRAW_VIEWS);
+		return ResContext.MaxMeshInstances * (1 + VulkanHelper::MAX_DRAW_FRAMES + Frame * MAX_DRAW_VIEWS + View);
+	}
+
+	u32 GetMaxMeshInstances()
+	{
+		return ResContext.MaxMeshInstances;
+	}
+
 	VkBuffer GetVertexStageBuffer()
 	{
 		return ResContext.VertexStageData.Buffer;
@@ -792,6 +1718,16 @@ namespace RenderResources
 		return ResContext.GPUInstances.Buffer;
 	}
 
+	VkPipelineCache GetPipelineCache()
+	{
+		return ResContext.PipelineCache;
+	}
+
+	bool IsPipelineCacheLoaded()
+	{
+		return ResContext.IsPipelineCacheLoaded;
+	}
+
 	VkDescriptorPool GetMainPool()
 	{
 		return ResContext.MainPool;
@@ -28,24 +28,65 @@ namespace RenderResources
 		Mesh,
 		Material,
 		Instance,
+		// Device side move of loaded mesh data, see CompactStaticMeshes
+		MeshRelocation,
+	};
+
+	struct MeshLod
+	{
+		// Relative to first index of mesh
+		u32 FirstIndex;
+		u32 IndicesCount;
+		// Vertex space distance between LOD and full mesh surface
+		f32 Error;
+	};
+
+	// Matches Meshlet of CullMeshlets.comp.glsl, meshlets of mesh follow its indices inside vertex buffer
+	struct Meshlet
+	{
+		// Vertex space center and radius
+		glm::vec4 BoundingSphere;
+		// Axis and cutoff of backface cone, cutoff is 1 when meshlet can't be backface culled
+		glm::vec4 Cone;
+		// Relative to first index of mesh, meshlets cover LOD 0
+		u32 FirstIndex;
+		u32 IndicesCount;
+		u32 Padding[2];
 	};
 
 	struct VertexData
 	{
+		// Allocated vertex range, data of meshes with meshlets starts inside it after GetMeshletPadding bytes
+		u64 RangeOffset;
+		u64 RangeSize;
 		u64 VertexOffset;
 		u32 IndexOffset;
 		u32 IndicesCount;
 		u64 VertexDataSize;
+		u32 VertexSize;
+		// firstIndex of draws is IndexOffset / IndexSize with index buffer bound at 0
+		u32 IndexSize;
+		VkIndexType IndexType;
+		// IndicesCount covers indices of every LOD
+		u32 LodCount;
+		MeshLod Lods[MAX_MESH_LODS];
+		// Byte offset inside vertex buffer, multiple of sizeof(Meshlet) so culling indexes meshlets of whole buffer
+		u64 MeshletOffset;
+		u32 MeshletCount;
+		// Vertex space center and radius
+		glm::vec4 BoundingSphere;
 	};
 
 	struct Texture
 	{
 		VkImage Image;
-		VkDeviceMemory Memory;
+		VulkanHelper::DeviceMemoryAllocation Allocation;
 		u64 Size;
 		u64 Alignment;
 		u32 Width;
 		u32 Height;
+		u32 MipLevels;
+		u32 ArrayLayers;
 	};
 
 	struct MeshTexture2D
@@ -65,6 +106,8 @@ namespace RenderResources
 	{
 		glm::mat4 ModelMatrix;
 		u32 MaterialIndex;
+		// Columns of world space normal matrix, filled by ComputeNormalMatrices
+		glm::vec3 NormalMatrix[3];
 	};
 
 	struct MeshDescription
@@ -72,13 +115,27 @@ namespace RenderResources
 		u64 VertexSize;
 		u64 VerticesCount;
 		u64 IndicesCount;
+		// VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+		VkIndexType IndexType;
+		// Ordered from full mesh to coarsest, mesh is drawn as single LOD when LodCount is 0
+		u32 LodCount;
+		const MeshLod* Lods;
+		// Meshlets are part of mesh data, they follow indices at offset aligned to MeshletAlignment from data start
+		u32 MeshletCount;
+		// Vertex space center and radius, positions are quantized so renderer doesn't read them
+		glm::vec4 BoundingSphere;
 	};
 
 	struct TextureDescription
 	{
 		u32 Width;
 		u32 Height;
+		u32 MipLevels;
+		u32 ArrayLayers;
 		VkFormat Format;
+		u64 DataSize;
+		// Byte offset of every subresource inside Data, indexed [Layer * MipLevels + Level]
+		const u64* SubresourceOffsets;
 	};
 
 	struct SamplerDescription
@@ -100,6 +157,10 @@ namespace RenderResources
 		VkBool32 UnnormalizedCoordinates;
 	};
 
+	static const u64 MeshletAlignment = 16;
+	// Returned by resource creation when transfer system or buffer range is full, nothing is created and caller retries later
+	static const u32 InvalidIndex = UINT32_MAX;
+
 	void Init(GLFWwindow* WindowHandler);
 	void DeInit();
 
@@ -119,16 +180,48 @@ namespace RenderResources
 
 	VkPipeline CreateGraphicsPipeline(VkDevice Device, Yaml::Node& Root,
 		VkExtent2D Extent, VkPipelineLayout PipelineLayout, const VulkanHelper::PipelineResourceInfo* ResourceInfo);
-
+	// Pipeline settings are parsed and compiled by jobs in CreateRequestedPipelines, OutPipeline has to outlive the call
+	void RequestGraphicsPipeline(const char* SettingsPath, VkExtent2D Extent, const VulkanHelper::PipelineResourceInfo* ResourceInfo,
+		VkPipeline* OutPipeline);
+	void CreateRequestedPipelines();
+	// Next CreateRequestedPipelines builds requests with empty cache first, then saves cache, reads it back from disk
+	// and builds them again, both times are logged
+	void EnablePipelineCacheBenchmark();
+
+	// Functions below return InvalidIndex when transfer system is full or buffer has no free range
 	u32 CreateStaticMesh(MeshDescription* Description, void* Data);
+	// Reserves transfer memory for mesh data, upload starts after SubmitStaticMesh is called with filled memory
+	u32 ReserveStaticMesh(MeshDescription* Description, void** OutData);
+	void SubmitStaticMesh(u32 Index, void* Data);
 	u32 CreateMaterial(Material* Mat);
 	u32 CreateTexture(TextureDescription* Description, void* Data);
+	// Data->NormalMatrix has to be filled by ComputeNormalMatrices
 	u32 CreateStaticMeshInstance(InstanceData* Data);
+	// Fills NormalMatrix of every instance, large batches are split between workers. Called by one thread at a time
+	void ComputeNormalMatrices(InstanceData* Instances, u64 Count);
+
+	// Index is reused after GPU stops using the texture
+	void DestroyTexture(u32 Index);
+	// Ranges and indices are reused after GPU stops using them, mesh that is being relocated waits for
+	// ApplyStaticMeshRelocations to switch its offsets first
+	void DestroyStaticMesh(u32 Index);
+	void DestroyStaticMeshInstance(u32 Index);
+
+	// Moves loaded meshes into lower free ranges of vertex buffer to merge free space, does nothing until frees
+	// scatter free space or a mesh finds no vertex range. Returns amount of bytes scheduled for copy
+	u64 CompactStaticMeshes(u64 MaxBytesToMove);
+	// Writes descriptors of created textures into bindless table in one update, called once per frame before recording
+	void FlushTextureDescriptors();
+	// Switches offsets of meshes whose relocation copies completed, called by render thread once per frame before recording
+	void ApplyStaticMeshRelocations();
 
 	VertexData* GetStaticMesh(u32 Index);
 	InstanceData* GetInstanceData(u32 Index);
 	MeshTexture2D* GetTexture(u32 Index);
+	Material* GetMaterial(u32 Index);
 
+	bool IsResourceLoaded(u32 ResourceIndex, ResourceType Type);
+	// Marks resource as loaded and notifies Residency
 	void SetResourceReadyToRender(u32 ResourceIndex, ResourceType Type);
 	VkDescriptorSetLayout GetBindlesTexturesLayout();
 	VkDescriptorSetLayout GetMaterialLayout();
@@ -136,7 +229,15 @@ namespace RenderResources
 	VkDescriptorSet GetMaterialSet();
 	VkBuffer GetVertexStageBuffer();
 	VkBuffer GetInstanceBuffer();
+	// First instance of frame region that follows persistent instances, region holds GetMaxMeshInstances instances
+	u32 GetInstanceBatchRegion(u32 Frame);
+	// First instance of frame region with instances of view that passed culling, follows batch regions
+	u32 GetInstanceViewRegion(u32 Frame, u32 View);
+	u32 GetMaxMeshInstances();
 	VkDescriptorPool GetMainPool();
+	// Loaded from disk on Init and saved on DeInit
+	VkPipelineCache GetPipelineCache();
+	// True when cache of previous run matched device and driver
+	bool IsPipelineCacheLoaded();
 
-	bool IsDrawEntityLoaded(const Render::DrawEntity* Entity);
 }
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "Residency.h"
+
+#include "Render.h"
+#include "Engine/Systems/Memory/MemoryManagmentSystem.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <cstring>
+
+namespace Residency
+{
+	struct ResourceEvent
+	{
+		u64 ResourceKey;
+		bool IsLoaded;
+	};
+
+	struct EntityResidency
+	{
+		// Dependencies of entity that are not loaded
+		u32 PendingCount;
+		bool IsDrawable;
+		bool IsRemoved;
+	};
+
+	struct ResidencyState
+	{
+		// Events are queued by transfer and resource threads, applied by renderer
+		std::mutex EventLock;
+		Memory::DynamicHeapArray<ResourceEvent> Events;
+		Memory::DynamicHeapArray<ResourceEvent> AppliedEvents;
+		Memory::DynamicHeapArray<u32> RemovedEntities;
+		Memory::DynamicHeapArray<u32> AppliedRemovedEntities;
+
+		// Indexed same as Scene->DrawEntities
+		Memory::DynamicHeapArray<EntityResidency> Entities;
+		Memory::DynamicHeapArray<u32> DrawableEntities;
+		// Scratch for dependencies of single entity
+		Memory::DynamicHeapArray<u64> Dependencies;
+		// One entry per not loaded dependency of every entity
+		std::unordered_multimap<u64, u32> WaitingEntities;
+	};
+
+	static ResidencyState Tracker;
+
+	static u64 MakeResourceKey(RenderResources::ResourceType Type, u32 ResourceIndex)
+	{
+		return ((u64)Type << 32) | ResourceIndex;
+	}
+
+	static bool IsResourceKeyLoaded(u64 Key)
+	{
+		return RenderResources::IsResourceLoaded((u32)Key, (RenderResources::ResourceType)(Key >> 32));
+	}
+
+	static void PushDependency(RenderResources::ResourceType Type, u32 ResourceIndex)
+	{
+		const u64 Key = MakeResourceKey(Type, ResourceIndex);
+		Memory::PushBackToArray(&Tracker.Dependencies, &Key);
+	}
+
+	// Mesh, every instance, material of first instance and its textures
+	static void GatherDependencies(const Render::DrawEntity* Entity)
+	{
+		Memory::ClearArray(&Tracker.Dependencies);
+
+		PushDependency(RenderResources::ResourceType::Mesh, (u32)Entity->StaticMeshIndex);
+
+		for (u32 i = 0; i < Entity->Instances; ++i)
+		{
+			PushDependency(RenderResources::ResourceType::Instance, Entity->InstanceDataIndex + i);
+		}
+
+		// Instance and material data is filled on creation, before upload completes
+		const u32 MaterialIndex = RenderResources::GetInstanceData(Entity->InstanceDataIndex)->MaterialIndex;
+		const RenderResources::Material* Mat = RenderResources::GetMaterial(MaterialIndex);
+
+		PushDependency(RenderResources::ResourceType::Material, MaterialIndex);
+		PushDependency(RenderResources::ResourceType::Texture, Mat->AlbedoTexIndex);
+		PushDependency(RenderResources::ResourceType::Texture, Mat->SpecularTexIndex);
+	}
+
+	static void AddDrawable(u32 EntityIndex)
+	{
+		EntityResidency* Residency = Tracker.Entities.Data + EntityIndex;
+		assert(!Residency->IsDrawable);
+
+		Residency->IsDrawable = true;
+		Memory::PushBackToArray(&Tracker.DrawableEntities, &EntityIndex);
+	}
+
+	static void RemoveDrawable(u32 EntityIndex)
+	{
+		Tracker.Entities.Data[EntityIndex].IsDrawable = false;
+
+		u32* Drawable = Tracker.DrawableEntities.Data;
+		const u64 Count = Tracker.DrawableEntities.Count;
+
+		for (u64 i = 0; i < Count; ++i)
+		{
+			if (Drawable[i] == EntityIndex)
+			{
+				memmove(Drawable + i, Drawable + i + 1, (Count - i - 1) * sizeof(u32));
+				--Tracker.DrawableEntities.Count;
+				return;
+			}
+		}
+
+		assert(false);
+	}
+
+	static void TrackEntity(u32 EntityIndex, const Render::DrawEntity* Entity)
+	{
+		assert(EntityIndex == Tracker.Entities.Count);
+
+		EntityResidency* Residency = Memory::ArrayGetNew(&Tracker.Entities);
+		Residency->PendingCount = 0;
+		Residency->IsDrawable = false;
+		Residency->IsRemoved = false;
+
+		GatherDependencies(Entity);
+
+		// Resource that is seen as not loaded here queues its load event later
+		for (u64 i = 0; i < Tracker.Dependencies.Count; ++i)
+		{
+			const u64 Key = Tracker.Dependencies.Data[i];
+			if (!IsResourceKeyLoaded(Key))
+			{
+				Tracker.WaitingEntities.emplace(Key, EntityIndex);
+				++Residency->PendingCount;
+			}
+		}
+
+		if (Residency->PendingCount == 0)
+		{
+			AddDrawable(EntityIndex);
+		}
+	}
+
+	static void ApplyResourceLoaded(u64 Key)
+	{
+		auto Range = Tracker.WaitingEntities.equal_range(Key);
+		for (auto It = Range.first; It != Range.second; ++It)
+		{
+			EntityResidency* Residency = Tracker.Entities.Data + It->second;
+			assert(Residency->PendingCount > 0);
+
+			--Residency->PendingCount;
+			if (Residency->PendingCount == 0)
+			{
+				AddDrawable(It->second);
+			}
+		}
+
+		Tracker.WaitingEntities.erase(Range.first, Range.second);
+	}
+
+	// Unload is rare, every tracked entity is checked against resource
+	static void ApplyResourceUnloaded(const Render::DrawScene* Scene, u64 Key)
+	{
+		auto Range = Tracker.WaitingEntities.equal_range(Key);
+
+		for (u32 EntityIndex = 0; EntityIndex < Tracker.Entities.Count; ++EntityIndex)
+		{
+			// Indices of removed entity may already belong to other resources
+			if (Tracker.Entities.Data[EntityIndex].IsRemoved)
+			{
+				continue;
+			}
+
+			GatherDependencies(Scene->DrawEntities.Data + EntityIndex);
+
+			u32 Uses = 0;
+			for (u64 i = 0; i < Tracker.Dependencies.Count; ++i)
+			{
+				Uses += Tracker.Dependencies.Data[i] == Key;
+			}
+
+			// Entity could already wait for resource if it was tracked after unload
+			u32 Waits = 0;
+			for (auto It = Range.first; It != Range.second; ++It)
+			{
+				Waits += It->second == EntityIndex;
+			}
+
+			if (Uses == Waits)
+			{
+				continue;
+			}
+
+			EntityResidency* Residency = Tracker.Entities.Data + EntityIndex;
+			for (u32 i = Waits; i < Uses; ++i)
+			{
+				Tracker.WaitingEntities.emplace(Key, EntityIndex);
+				++Residency->PendingCount;
+			}
+
+			if (Residency->IsDrawable)
+			{
+				RemoveDrawable(EntityIndex);
+			}
+
+			Range = Tracker.WaitingEntities.equal_range(Key);
+		}
+	}
+
+	// Removal is rare, waiting entries of entity are found by full scan
+	static void ApplyEntityRemoved(u32 EntityIndex)
+	{
+		EntityResidency* Residency = Tracker.Entities.Data + EntityIndex;
+		if (Residency->IsDrawable)
+		{
+			RemoveDrawable(EntityIndex);
+		}
+
+		Residency->IsRemoved = true;
+		Residency->PendingCount = 0;
+
+		for (auto It = Tracker.WaitingEntities.begin(); It != Tracker.WaitingEntities.end(); )
+		{
+			It = It->second == EntityIndex ? Tracker.WaitingEntities.erase(It) : std::next(It);
+		}
+	}
+
+	static void QueueEvent(u32 ResourceIndex, RenderResources::ResourceType Type, bool IsLoaded)
+	{
+		ResourceEvent Event;
+		Event.ResourceKey = MakeResourceKey(Type, ResourceIndex);
+		Event.IsLoaded = IsLoaded;
+
+		std::unique_lock Lock(Tracker.EventLock);
+		Memory::PushBackToArray(&Tracker.Events, &Event);
+	}
+
+	void Init()
+	{
+		Tracker.Events = Memory::AllocateArray<ResourceEvent>(256);
+		Tracker.AppliedEvents = Memory::AllocateArray<ResourceEvent>(256);
+		Tracker.RemovedEntities = Memory::AllocateArray<u32>(64);
+		Tracker.AppliedRemovedEntities = Memory::AllocateArray<u32>(64);
+		Tracker.Entities = Memory::AllocateArray<EntityResidency>(512);
+		Tracker.DrawableEntities = Memory::AllocateArray<u32>(512);
+		Tracker.Dependencies = Memory::AllocateArray<u64>(8);
+	}
+
+	void DeInit()
+	{
+		Memory::FreeArray(&Tracker.Events);
+		Memory::FreeArray(&Tracker.AppliedEvents);
+		Memory::FreeArray(&Tracker.RemovedEntities);
+		Memory::FreeArray(&Tracker.AppliedRemovedEntities);
+		Memory::FreeArray(&Tracker.Entities);
+		Memory::FreeArray(&Tracker.DrawableEntities);
+		Memory::FreeArray(&Tracker.Dependencies);
+		Tracker.WaitingEntities.clear();
+	}
+
+	void OnResourceLoaded(u32 ResourceIndex, RenderResources::ResourceType Type)
+	{
+		QueueEvent(ResourceIndex, Type, true);
+	}
+
+	void OnResourceUnloaded(u32 ResourceIndex, RenderResources::ResourceType Type)
+	{
+		QueueEvent(ResourceIndex, Type, false);
+	}
+
+	void OnEntityRemoved(u32 EntityIndex)
+	{
+		std::unique_lock Lock(Tracker.EventLock);
+		Memory::PushBackToArray(&Tracker.RemovedEntities, &EntityIndex);
+	}
+
+	void Update(Render::DrawScene* Scene)
+	{
+		// Events are taken before new entities read loaded state, event of resource seen as not loaded is applied later
+		std::unique_lock EventLock(Tracker.EventLock);
+		Memory::DynamicHeapArray<ResourceEvent> Events = Tracker.Events;
+		Tracker.Events = Tracker.AppliedEvents;
+		Tracker.AppliedEvents = Events;
+
+		Memory::DynamicHeapArray<u32> RemovedEntities = Tracker.RemovedEntities;
+		Tracker.RemovedEntities = Tracker.AppliedRemovedEntities;
+		Tracker.AppliedRemovedEntities = RemovedEntities;
+		EventLock.unlock();
+
+		std::unique_lock SceneLock(Scene->TempLock);
+
+		for (u64 i = 0; i < Tracker.AppliedEvents.Count; ++i)
+		{
+			const ResourceEvent* Event = Tracker.AppliedEvents.Data + i;
+			if (Event->IsLoaded)
+			{
+				ApplyResourceLoaded(Event->ResourceKey);
+			}
+			else
+			{
+				ApplyResourceUnloaded(Scene, Event->ResourceKey);
+			}
+		}
+
+		Memory::ClearArray(&Tracker.AppliedEvents);
+
+		for (u32 i = (u32)Tracker.Entities.Count; i < Scene->DrawEntities.Count; ++i)
+		{
+			TrackEntity(i, Scene->DrawEntities.Data + i);
+		}
+
+		// Entity is appended before it is removed, so it is tracked by now
+		for (u64 i = 0; i < Tracker.AppliedRemovedEntities.Count; ++i)
+		{
+			ApplyEntityRemoved(Tracker.AppliedRemovedEntities.Data[i]);
+		}
+
+		Memory::ClearArray(&Tracker.AppliedRemovedEntities);
+	}
+
+	const u32* GetDrawableEntities(u32* OutCount)
+	{
+		*OutCount = (u32)Tracker.DrawableEntities.Count;
+		return Tracker.DrawableEntities.Data;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+#include "RenderResources.h"
+
+namespace Render
+{
+	struct DrawScene;
+}
+
+namespace Residency
+{
+	void Init();
+	void DeInit();
+
+	// Queue resource state change, can be called from any thread
+	void OnResourceLoaded(u32 ResourceIndex, RenderResources::ResourceType Type);
+	void OnResourceUnloaded(u32 ResourceIndex, RenderResources::ResourceType Type);
+	// Entity stays in Scene->DrawEntities but is never drawn again, its resource indices can be reused.
+	// Can be called from any thread after entity is appended to Scene
+	void OnEntityRemoved(u32 EntityIndex);
+
+	// Applies queued resource changes to pending counters of entities and starts tracking entities appended to Scene
+	// since previous update. Locks Scene->TempLock, has to be called by renderer before FrustumCulling::Cull
+	void Update(Render::DrawScene* Scene);
+
+	// Indices into Scene->DrawEntities of entities with every resource loaded, in order they became drawable
+	const u32* GetDrawableEntities(u32* OutCount);
+}
\ No newline at end of file
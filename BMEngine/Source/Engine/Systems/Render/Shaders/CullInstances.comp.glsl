@@ -0,0 +1,83 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "CullingCommon.glsli"
+
+layout(local_size_x = 64) in;
+
+// Six inward facing planes for every view
+layout(std430, set = 0, binding = 0) readonly buffer ViewBuffer
+{
+	vec4 Planes[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer BatchBuffer
+{
+	CullBatch Batches[];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer InstanceBatchBuffer
+{
+	uint InstanceBatches[];
+};
+
+// Instances are copied as raw floats, InstanceStride floats each
+layout(std430, set = 0, binding = 3) buffer InstanceBuffer
+{
+	float Instances[];
+};
+
+layout(std430, set = 0, binding = 4) buffer OutputBuffer
+{
+	uint Output[];
+};
+
+void main()
+{
+	const uint Instance = gl_GlobalInvocationID.x;
+	const uint View = gl_WorkGroupID.y;
+
+	if (Instance >= Constants.InstanceCount)
+	{
+		return;
+	}
+
+	const uint BatchIndex = InstanceBatches[Instance];
+	const CullBatch Batch = Batches[BatchIndex];
+
+	if ((Batch.MeshletViews & (1u << View)) != 0)
+	{
+		return;
+	}
+
+	const uint Src = (Constants.BatchRegion + Instance) * Constants.InstanceStride;
+
+	mat4 ModelMatrix;
+	for (uint i = 0; i < 16; ++i)
+	{
+		ModelMatrix[i / 4][i % 4] = Instances[Src + i];
+	}
+
+	const vec3 Center = (ModelMatrix * vec4(Batch.BoundingSphere.xyz, 1.0)).xyz;
+	const float Scale = max(length(ModelMatrix[0].xyz), max(length(ModelMatrix[1].xyz), length(ModelMatrix[2].xyz)));
+	const float Radius = Batch.BoundingSphere.w * Scale;
+
+	for (uint i = 0; i < 6; ++i)
+	{
+		const vec4 Plane = Planes[View * 6 + i];
+		if (dot(Plane.xyz, Center) + Plane.w < -Radius)
+		{
+			return;
+		}
+	}
+
+	const uint OutputBase = View * Constants.OutputViewStride;
+	const uint VisibleCounter = OutputBase + 4 + Constants.MaxDrawCount * 5 + BatchIndex;
+	const uint Slot = atomicAdd(Output[VisibleCounter], 1);
+
+	const uint Dst = (Constants.ViewRegion + View * Constants.ViewRegionStride + Batch.FirstInstance + Slot) * Constants.InstanceStride;
+	for (uint i = 0; i < Constants.InstanceStride; ++i)
+	{
+		Instances[Dst + i] = Instances[Src + i];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "CullingCommon.glsli"
+
+layout(local_size_x = 64) in;
+
+// Matches RenderResources::Meshlet
+struct Meshlet
+{
+	vec4 BoundingSphere;
+	vec4 Cone;
+	uint FirstIndex;
+	uint IndexCount;
+	uint Padding[2];
+};
+
+// Six inward facing planes for every view
+layout(std430, set = 0, binding = 0) readonly buffer ViewBuffer
+{
+	vec4 Planes[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer BatchBuffer
+{
+	CullBatch Batches[];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer InstanceBatchBuffer
+{
+	uint InstanceBatches[];
+};
+
+// Instances are copied as raw floats, InstanceStride floats each
+layout(std430, set = 0, binding = 3) readonly buffer InstanceBuffer
+{
+	float Instances[];
+};
+
+layout(std430, set = 0, binding = 4) buffer OutputBuffer
+{
+	uint Output[];
+};
+
+// Whole vertex buffer, meshlets of every mesh start at multiple of Meshlet size
+layout(std430, set = 0, binding = 5) readonly buffer MeshletBuffer
+{
+	Meshlet Meshlets[];
+};
+
+// Batched instances of batches that draw meshlets
+layout(std430, set = 0, binding = 6) readonly buffer MeshletInstanceBuffer
+{
+	uint MeshletInstances[];
+};
+
+bool IsSphereVisible(uint View, vec3 Center, float Radius)
+{
+	for (uint i = 0; i < 6; ++i)
+	{
+		const vec4 Plane = Planes[View * 6 + i];
+		if (dot(Plane.xyz, Center) + Plane.w < -Radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void main()
+{
+	const uint Instance = MeshletInstances[gl_WorkGroupID.x];
+	const uint View = gl_WorkGroupID.y;
+
+	const CullBatch Batch = Batches[InstanceBatches[Instance]];
+
+	if ((Batch.MeshletViews & (1u << View)) == 0)
+	{
+		return;
+	}
+
+	// Instance stays in batch region, draws address it there
+	const uint Src = (Constants.BatchRegion + Instance) * Constants.InstanceStride;
+
+	mat4 ModelMatrix;
+	for (uint i = 0; i < 16; ++i)
+	{
+		ModelMatrix[i / 4][i % 4] = Instances[Src + i];
+	}
+
+	// Columns follow model matrix and material index
+	const mat3 NormalMatrix = mat3(
+		Instances[Src + 17], Instances[Src + 18], Instances[Src + 19],
+		Instances[Src + 20], Instances[Src + 21], Instances[Src + 22],
+		Instances[Src + 23], Instances[Src + 24], Instances[Src + 25]);
+
+	const float Scale = max(length(ModelMatrix[0].xyz), max(length(ModelMatrix[1].xyz), length(ModelMatrix[2].xyz)));
+
+	// Whole work group leaves together when instance is outside of view
+	if (!IsSphereVisible(View, (ModelMatrix * vec4(Batch.BoundingSphere.xyz, 1.0)).xyz, Batch.BoundingSphere.w * Scale))
+	{
+		return;
+	}
+
+	const uint OutputBase = View * Constants.OutputViewStride;
+
+	for (uint MeshletIndex = gl_LocalInvocationID.x; MeshletIndex < Batch.MeshletCount; MeshletIndex += gl_WorkGroupSize.x)
+	{
+		const Meshlet Current = Meshlets[Batch.FirstMeshlet + MeshletIndex];
+		const vec4 Cone = Current.Cone;
+
+		const vec3 Center = (ModelMatrix * vec4(Current.BoundingSphere.xyz, 1.0)).xyz;
+		const float Radius = Current.BoundingSphere.w * Scale;
+
+		if (!IsSphereVisible(View, Center, Radius))
+		{
+			continue;
+		}
+
+		// Only camera has a single origin, light views keep backfacing meshlets
+		if (View == 0 && Cone.w < 1.0)
+		{
+			const vec3 Axis = normalize(NormalMatrix * Cone.xyz);
+			const vec3 ToCenter = Center - Constants.CameraPosition.xyz;
+			if (dot(ToCenter, Axis) >= Cone.w * length(ToCenter) + Radius)
+			{
+				continue;
+			}
+		}
+
+		// 32 bit index draws follow 16 bit ones so both are drawn with own index buffer binding
+		const uint DrawIndex = Batch.IndexType * Constants.MeshletWideBase + atomicAdd(Output[OutputBase + 2 + Batch.IndexType], 1);
+		const uint Command = OutputBase + Constants.MeshletCommandsOffset + DrawIndex * 5;
+
+		Output[Command + 0] = Current.IndexCount;
+		Output[Command + 1] = 1;
+		Output[Command + 2] = Batch.FirstIndex[View] + Current.FirstIndex;
+		Output[Command + 3] = uint(Batch.VertexOffset);
+		Output[Command + 4] = Constants.BatchRegion + Instance;
+	}
+}
\ No newline at end of file
@@ -1,6 +1,6 @@
 #version 450
 
-layout(location = 0) in vec3 Position;
+layout(location = 0) in vec4 Position;
 layout(location = 1) in mat4 ModelMatrix;  // occupies locations 1,2,3,4
 
 layout(set = 0, binding = 0) uniform LightSpaceMatrix
@@ -10,5 +10,5 @@ layout(set = 0, binding = 0) uniform LightSpaceMatrix
 
 void main()
 {
-	gl_Position = lightSpaceMatrix.Matrix * ModelMatrix * vec4(Position, 1.0);
+	gl_Position = lightSpaceMatrix.Matrix * ModelMatrix * vec4(Position.xyz, 1.0);
 }
\ No newline at end of file
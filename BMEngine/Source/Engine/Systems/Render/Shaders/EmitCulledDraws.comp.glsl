@@ -0,0 +1,49 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "CullingCommon.glsli"
+
+layout(local_size_x = 64) in;
+
+layout(std430, set = 0, binding = 1) readonly buffer BatchBuffer
+{
+	CullBatch Batches[];
+};
+
+// Every view holds draw counts of 16 and 32 bit index batch and meshlet draws, VkDrawIndexedIndirectCommand array,
+// visible instance count of every batch and meshlet VkDrawIndexedIndirectCommand array
+layout(std430, set = 0, binding = 4) buffer OutputBuffer
+{
+	uint Output[];
+};
+
+void main()
+{
+	const uint BatchIndex = gl_GlobalInvocationID.x;
+	const uint View = gl_WorkGroupID.y;
+
+	if (BatchIndex >= Constants.BatchCount)
+	{
+		return;
+	}
+
+	const uint OutputBase = View * Constants.OutputViewStride;
+	const uint Visible = Output[OutputBase + 4 + Constants.MaxDrawCount * 5 + BatchIndex];
+
+	if (Visible == 0)
+	{
+		return;
+	}
+
+	const CullBatch Batch = Batches[BatchIndex];
+
+	// 32 bit index draws follow 16 bit ones so both are drawn with own index buffer binding
+	const uint DrawIndex = Batch.IndexType * Constants.WideIndexBase + atomicAdd(Output[OutputBase + Batch.IndexType], 1);
+	const uint Command = OutputBase + 4 + DrawIndex * 5;
+
+	Output[Command + 0] = Batch.IndexCount[View];
+	Output[Command + 1] = Visible;
+	Output[Command + 2] = Batch.FirstIndex[View];
+	Output[Command + 3] = uint(Batch.VertexOffset);
+	Output[Command + 4] = Constants.ViewRegion + View * Constants.ViewRegionStride + Batch.FirstInstance;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #extension GL_EXT_nonuniform_qualifier : enable
 
+// Position is in view space, w is range of light
 struct PointLight
 {
 	vec4 Position;
@@ -48,6 +49,12 @@ struct Material {
 #define DIRECTIONAL_LIGHT_SHADOW_TEXTURE_INDEX 0
 #define SPOT_LIGHT_SHADOW_TEXTURE_INDEX 1
 
+// Has to match LightClusters.cpp
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+#define MAX_LIGHTS_PER_CLUSTER 64
+
 layout(location = 0) in vec2 FragmentTexture;
 layout(location = 1) in vec3 FragmentNormal;
 layout(location = 2) in vec4 WorldFragPos;
@@ -65,7 +72,6 @@ layout(set = 1, binding = 1) uniform sampler2D SpecularTexture[];
 
 layout(set = 2, binding = 0) uniform LightCasters
 {
-	PointLight pointlight;
 	DirectionLight directionLight;
 	SpotLight spotlight;
 }
@@ -77,6 +83,27 @@ layout(std430, set = 3, binding = 0) readonly buffer MaterialsBuffer {
 
 layout(set = 4, binding = 0) uniform sampler2DArray ShadowMaps;
 
+// Point lights are assigned to froxels of camera view, slice of view depth is log(Depth) * SliceScale + SliceBias
+layout(std430, set = 5, binding = 0) readonly buffer ClusterLightsBuffer
+{
+	uvec2 TileSize;
+	float SliceScale;
+	float SliceBias;
+	uint LightCount;
+	PointLight Lights[];
+} ClusterLights;
+
+layout(std430, set = 5, binding = 1) readonly buffer ClusterLightCountsBuffer
+{
+	uint Counts[];
+} ClusterLightCounts;
+
+// MAX_LIGHTS_PER_CLUSTER light indices for every cluster
+layout(std430, set = 5, binding = 2) readonly buffer ClusterLightIndicesBuffer
+{
+	uint Indices[];
+} ClusterLightIndices;
+
 layout(location = 0) out vec4 OutColor;
 
 vec3 Diffuse(vec3 LightDirection, vec3 Color, vec3 Texture)
@@ -151,17 +178,17 @@ vec3 CastDirectionLight(vec3 FragmentPosition, vec3 DiffuseTexture, vec3 Specula
 	return AmbientColor + (1.0 - Shadow) * (DiffuseColor + SpecularColor);
 }
 
-vec3 CastPointLight(vec3 FragmentPosition, vec3 DiffuseTexture, vec3 SpecularTexture, float Shininess)
+vec3 CastPointLight(PointLight Light, vec3 FragmentPosition, vec3 DiffuseTexture, vec3 SpecularTexture, float Shininess)
 {
-	vec3 LightPosition = vec3(ViewProjection.View * lightCasters.pointlight.Position);
+	vec3 LightPosition = Light.Position.xyz;
 	vec3 LightDirection = normalize(LightPosition - FragmentPosition);
 
-	vec3 AmbientColor = lightCasters.pointlight.Ambient * DiffuseTexture;
-	vec3 DiffuseColor = Diffuse(LightDirection, lightCasters.pointlight.Diffuse, DiffuseTexture);
-	vec3 SpecularColor = Specular(FragmentPosition, LightDirection, lightCasters.pointlight.Specular, SpecularTexture, Shininess);
+	vec3 AmbientColor = Light.Ambient * DiffuseTexture;
+	vec3 DiffuseColor = Diffuse(LightDirection, Light.Diffuse, DiffuseTexture);
+	vec3 SpecularColor = Specular(FragmentPosition, LightDirection, Light.Specular, SpecularTexture, Shininess);
 
-	float Attenuation = LightDistanceAttenuation(FragmentPosition, LightPosition, lightCasters.pointlight.Constant, 
-		lightCasters.pointlight.Linear, lightCasters.pointlight.Quadratic);
+	float Attenuation = LightDistanceAttenuation(FragmentPosition, LightPosition, Light.Constant, 
+		Light.Linear, Light.Quadratic);
 
 	return AmbientColor * Attenuation + DiffuseColor * Attenuation + SpecularColor * Attenuation;
 }
@@ -195,6 +222,14 @@ vec3 CastSpotLigh(vec3 FragmentPosition, vec3 DiffuseTexture, vec3 SpecularTextu
 	return AmbientColor + (DiffuseColor + SpecularColor);
 }
 
+uint GetCluster(vec3 FragmentPosition)
+{
+	const uvec2 Tile = min(uvec2(gl_FragCoord.xy) / ClusterLights.TileSize, uvec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+	const float Slice = log(-FragmentPosition.z) * ClusterLights.SliceScale + ClusterLights.SliceBias;
+	const uint SliceIndex = uint(clamp(Slice, 0.0, float(CLUSTER_COUNT_Z - 1)));
+	return Tile.x + (Tile.y + SliceIndex * CLUSTER_COUNT_Y) * CLUSTER_COUNT_X;
+}
+
 void main()
 {
 	vec3 FragmentPosition = vec3(ViewProjection.View * WorldFragPos);
@@ -205,7 +240,16 @@ void main()
 
 	vec3 ResultLightColor = vec3(0.0);
 	ResultLightColor += CastDirectionLight(FragmentPosition, vec3(DiffuseTexture), SpecularTexture, Mat.Shininess);
-	ResultLightColor += CastPointLight(FragmentPosition, vec3(DiffuseTexture), SpecularTexture, Mat.Shininess);
+
+	// Only lights whose range reaches froxel of fragment
+	const uint Cluster = GetCluster(FragmentPosition);
+	const uint ClusterLightCount = ClusterLightCounts.Counts[Cluster];
+	for (uint i = 0; i < ClusterLightCount; ++i)
+	{
+		const uint LightIndex = ClusterLightIndices.Indices[Cluster * MAX_LIGHTS_PER_CLUSTER + i];
+		ResultLightColor += CastPointLight(ClusterLights.Lights[LightIndex], FragmentPosition, vec3(DiffuseTexture), SpecularTexture, Mat.Shininess);
+	}
+
 	ResultLightColor += CastSpotLigh(FragmentPosition, vec3(DiffuseTexture), SpecularTexture, Mat.Shininess);
 	OutColor = vec4(ResultLightColor, DiffuseTexture.a);
 }
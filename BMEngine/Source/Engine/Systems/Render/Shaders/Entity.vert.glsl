@@ -1,10 +1,13 @@
 #version 450
 
-layout(location = 0) in vec3 Position;
+// Quantized inside mesh bounds, ModelMatrix includes dequantization
+layout(location = 0) in vec4 Position;
 layout(location = 1) in vec2 TextureCoords;
-layout(location = 2) in vec3 Normal;
+layout(location = 2) in vec2 OctahedralNormal;
 layout(location = 3) in mat4 ModelMatrix;  // occupies locations 3,4,5,6
 layout(location = 7) in uint MaterialIndex;
+// World space inverse transpose of ModelMatrix, computed once per instance on CPU
+layout(location = 8) in mat3 NormalMatrix;  // occupies locations 8,9,10
 
 layout(set = 0, binding = 0) uniform UboViewProjection
 {
@@ -17,12 +20,21 @@ layout(location = 1) out vec3 FragmentNormal;
 layout(location = 2) out vec4 WorldFragPos;
 layout(location = 3) out flat uint FragmentMaterialIndex;
 
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+	vec3 Normal = vec3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+	const float Fold = max(-Normal.z, 0.0);
+	Normal.x += Normal.x >= 0.0 ? -Fold : Fold;
+	Normal.y += Normal.y >= 0.0 ? -Fold : Fold;
+	return normalize(Normal);
+}
+
 void main()
 {
 	FragmentTexture = TextureCoords;
-	WorldFragPos = ModelMatrix * vec4(Position, 1.0);
-	FragmentNormal = normalize(mat3(transpose(inverse(ViewProjection.View * ModelMatrix))) * Normal);
+	WorldFragPos = ModelMatrix * vec4(Position.xyz, 1.0);
+	FragmentNormal = normalize(mat3(ViewProjection.View) * NormalMatrix * DecodeOctahedral(OctahedralNormal));
 	FragmentMaterialIndex = MaterialIndex;
 
-	gl_Position = ViewProjection.Projection * ViewProjection.View * ModelMatrix * vec4(Position, 1.0);
+	gl_Position = ViewProjection.Projection * ViewProjection.View * ModelMatrix * vec4(Position.xyz, 1.0);
 }
\ No newline at end of file
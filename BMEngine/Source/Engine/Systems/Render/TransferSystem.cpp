@@ -1,6 +1,7 @@
 #include "TransferSystem.h"
 
 #include <atomic>
+#include <mutex>
 
 #include "Engine/Systems/Memory/MemoryManagmentSystem.h"
 FORGE_MEMORY_DEBUG
@@ -9,24 +10,54 @@ FORGE_MEMORY_DEBUG
 #include "VulkanHelper.h"
 #include "RenderResources.h"
 #include "VulkanCoreContext.h"
+#include "DeviceMemoryAllocator.h"
 #include "Util/Math.h"
 
 namespace TransferSystem
 {
+	// Claimed queue position and transfer memory byte are packed into one word and wrap at this width
+	static const u64 ClaimCounterBits = 32;
+	static const u64 ClaimCounterMask = (1ull << ClaimCounterBits) - 1;
+	// Power of two, so wrapped byte counter still gives offset in memory
+	static const u64 TransferMemoryCapacity = MB128;
+	static_assert((TransferMemoryCapacity & (TransferMemoryCapacity - 1)) == 0 && TransferMemoryCapacity < ClaimCounterMask);
+
 	struct StagingFramePool
 	{
 		VkBuffer Buffer;
-		VkDeviceMemory Memory;
+		VulkanHelper::DeviceMemoryAllocation Allocation;
 		u64 AllocatedForFrame[VulkanHelper::MAX_DRAW_FRAMES];
 	};
 
+	struct TaskSlot
+	{
+		// Equals queue position + 1 when task is published
+		std::atomic<u64> Sequence;
+		TransferTask Task;
+	};
+
 	struct TaskQueue
 	{
-		TransferTask* Memory;
+		TaskSlot* Slots;
 		u64 Capacity;
+		// Positions grow monotonically, slot index is Position % Capacity. Head is claimed in DataTransferState::Claims
 		std::atomic<u64> Tail;
 		std::atomic<u64> Middle;
-		std::atomic<u64> Head;
+	};
+
+	// Stored in front of every block returned by RequestTransferMemory
+	struct TransferMemoryHeader
+	{
+		u64 QueuePosition;
+		// Includes space skipped at the end of transfer memory before block
+		u64 AllocationSize;
+	};
+
+	struct ReadbackPool
+	{
+		VkBuffer Buffer;
+		VulkanHelper::DeviceMemoryAllocation Allocation;
+		Memory::RingBufferControl ControlBlock;
 	};
 
 	struct TransferFrames
@@ -39,7 +70,12 @@ namespace TransferSystem
 	{
 		const u64 MaxTransferSizePerFrame = MB2;
 
-		Memory::HeapRingBuffer<u8> TransferMemory;
+		// Low bits are next queue position, high bits are next transfer memory byte. Both are claimed with one
+		// compare exchange, so memory order equals queue order and blocks are released in the order they were claimed
+		std::atomic<u64> Claims;
+		// Bytes released by transfer thread, only grows
+		std::atomic<u64> TransferMemoryTail;
+		u8* TransferMemory;
 
 		VkCommandPool TransferCommandPool;
 		StagingFramePool TransferStagingPool;
@@ -49,14 +85,26 @@ namespace TransferSystem
 		u64 CompletedTransfer;
 
 		TaskQueue TransferTasksQueue;
+		Memory::DynamicHeapArray<VkBufferImageCopy> TextureCopyRegions;
 
 		TransferFrames Frames;
 		u32 CurrentFrame;
+
+		ReadbackPool Readback;
+		VkSemaphore ReadbackSemaphore;
+		u64 ReadbacksRequested;
+		u64 ReadbacksInFly;
+		u64 CompletedReadbacks;
+
+		std::mutex PendingReadbacksLock;
+		Memory::HeapRingBuffer<ReadbackTask> PendingReadbacks;
+		Memory::HeapRingBuffer<ReadbackTask> ReadbacksInFlyQueue;
 	};
 
 	static bool HasPendingTasks(TaskQueue* Queue)
 	{
-		return Queue->Middle.load(std::memory_order_acquire) != Queue->Head.load(std::memory_order_acquire);
+		const u64 Middle = Queue->Middle.load(std::memory_order_relaxed);
+		return Queue->Slots[Middle % Queue->Capacity].Sequence.load(std::memory_order_acquire) == Middle + 1;
 	}
 
 	static bool HasCompletedTasks(TaskQueue* Queue)
@@ -64,42 +112,267 @@ namespace TransferSystem
 		return Queue->Tail.load(std::memory_order_acquire) != Queue->Middle.load(std::memory_order_acquire);
 	}
 
-	static void AddPendingTask(TaskQueue* Queue, TransferTask* Task)
-	{
-		u64 CurrentHead = Queue->Head.load(std::memory_order_relaxed);
-		Queue->Memory[CurrentHead] = *Task;
-		Queue->Head.store(Math::WrapIncrement(CurrentHead, Queue->Capacity), std::memory_order_release);
-	}
-
 	static void PopPendingTask(TaskQueue* Queue)
 	{
 		u64 CurrentMiddle = Queue->Middle.load(std::memory_order_relaxed);
-		Queue->Middle.store(Math::WrapIncrement(CurrentMiddle, Queue->Capacity), std::memory_order_release);
+		Queue->Middle.store(CurrentMiddle + 1, std::memory_order_release);
 	}
 
 	static TransferTask* GetFirstPendingTask(TaskQueue* Queue)
 	{
-		return Queue->Memory + Queue->Middle.load(std::memory_order_acquire);
+		return &Queue->Slots[Queue->Middle.load(std::memory_order_acquire) % Queue->Capacity].Task;
 	}
 
 	static void PopCompletedTask(TaskQueue* Queue)
 	{
 		u64 CurrentTail = Queue->Tail.load(std::memory_order_relaxed);
-		Queue->Tail.store(Math::WrapIncrement(CurrentTail, Queue->Capacity), std::memory_order_relaxed);
+		Queue->Tail.store(CurrentTail + 1, std::memory_order_release);
 	}
 
 	static TransferTask* GetFirstCompletedTask(TaskQueue* Queue)
 	{
-		return Queue->Memory + Queue->Tail.load(std::memory_order_acquire);
+		return &Queue->Slots[Queue->Tail.load(std::memory_order_acquire) % Queue->Capacity].Task;
+	}
+
+	static TransferMemoryHeader* GetTransferMemoryHeader(void* RawData)
+	{
+		return (TransferMemoryHeader*)((u8*)RawData - sizeof(TransferMemoryHeader));
+	}
+
+	static u64 GetTransferAllocationSize(u64 DataSize)
+	{
+		// Keep every header 8 byte aligned
+		return Math::AlignNumber(sizeof(TransferMemoryHeader) + DataSize, (u64)alignof(TransferMemoryHeader));
+	}
+
+	// Counter of Claims holds low bits of full value, full value is at most one claim range ahead of Tail
+	static u64 UnwrapClaimCounter(u64 Counter, u64 Tail)
+	{
+		return Tail + ((Counter - Tail) & ClaimCounterMask);
 	}
 
 	static DataTransferState TransferState;
 
+	static bool HasPendingReadbacks()
+	{
+		std::unique_lock Lock(TransferState.PendingReadbacksLock);
+		return !Memory::IsRingBufferEmpty(&TransferState.PendingReadbacks);
+	}
+
+	static void RecordReadbackTask(VkCommandBuffer CommandBuffer, const ReadbackTask* Task)
+	{
+		switch (Task->Type)
+		{
+			case ReadbackType::Buffer:
+			{
+				VkBufferMemoryBarrier2 Barrier = { };
+				Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+				Barrier.srcStageMask = Task->SrcStageMask;
+				Barrier.srcAccessMask = Task->SrcAccessMask;
+				Barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+				Barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+				Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				Barrier.buffer = Task->BufferDescr.SrcBuffer;
+				Barrier.offset = Task->BufferDescr.SrcOffset;
+				Barrier.size = Task->DataSize;
+
+				VkDependencyInfo DepInfo = { };
+				DepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+				DepInfo.bufferMemoryBarrierCount = 1;
+				DepInfo.pBufferMemoryBarriers = &Barrier;
+
+				VkBufferCopy CopyRegion = { };
+				CopyRegion.srcOffset = Task->BufferDescr.SrcOffset;
+				CopyRegion.dstOffset = Task->ReadbackOffset;
+				CopyRegion.size = Task->DataSize;
+
+				vkCmdPipelineBarrier2(CommandBuffer, &DepInfo);
+				vkCmdCopyBuffer(CommandBuffer, Task->BufferDescr.SrcBuffer, TransferState.Readback.Buffer, 1, &CopyRegion);
+
+				break;
+			}
+			case ReadbackType::Image:
+			{
+				VkImageMemoryBarrier2 ImageBarriers[2] = { };
+				ImageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+				ImageBarriers[0].srcStageMask = Task->SrcStageMask;
+				ImageBarriers[0].srcAccessMask = Task->SrcAccessMask;
+				ImageBarriers[0].dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+				ImageBarriers[0].dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+				ImageBarriers[0].oldLayout = Task->ImageDescr.SrcLayout;
+				ImageBarriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				ImageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				ImageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				ImageBarriers[0].image = Task->ImageDescr.SrcImage;
+				ImageBarriers[0].subresourceRange.aspectMask = Task->ImageDescr.AspectMask;
+				ImageBarriers[0].subresourceRange.baseMipLevel = Task->ImageDescr.MipLevel;
+				ImageBarriers[0].subresourceRange.levelCount = 1;
+				ImageBarriers[0].subresourceRange.baseArrayLayer = Task->ImageDescr.ArrayLayer;
+				ImageBarriers[0].subresourceRange.layerCount = 1;
+
+				// Return image to the layout owner expects
+				ImageBarriers[1] = ImageBarriers[0];
+				ImageBarriers[1].srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+				ImageBarriers[1].srcAccessMask = 0;
+				ImageBarriers[1].dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				ImageBarriers[1].dstAccessMask = 0;
+				ImageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				ImageBarriers[1].newLayout = Task->ImageDescr.SrcLayout;
+
+				VkDependencyInfo CopyDepInfo = { };
+				CopyDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+				CopyDepInfo.imageMemoryBarrierCount = 1;
+				CopyDepInfo.pImageMemoryBarriers = ImageBarriers;
+
+				VkDependencyInfo RestoreDepInfo = { };
+				RestoreDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+				RestoreDepInfo.imageMemoryBarrierCount = 1;
+				RestoreDepInfo.pImageMemoryBarriers = ImageBarriers + 1;
+
+				VkBufferImageCopy ImageRegion = { };
+				ImageRegion.bufferOffset = Task->ReadbackOffset;
+				ImageRegion.bufferRowLength = 0;
+				ImageRegion.bufferImageHeight = 0;
+				ImageRegion.imageSubresource.aspectMask = Task->ImageDescr.AspectMask;
+				ImageRegion.imageSubresource.mipLevel = Task->ImageDescr.MipLevel;
+				ImageRegion.imageSubresource.baseArrayLayer = Task->ImageDescr.ArrayLayer;
+				ImageRegion.imageSubresource.layerCount = 1;
+				ImageRegion.imageOffset = { 0, 0, 0 };
+				ImageRegion.imageExtent = { Task->ImageDescr.Width, Task->ImageDescr.Height, 1 };
+
+				vkCmdPipelineBarrier2(CommandBuffer, &CopyDepInfo);
+				vkCmdCopyImageToBuffer(CommandBuffer, Task->ImageDescr.SrcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					TransferState.Readback.Buffer, 1, &ImageRegion);
+				vkCmdPipelineBarrier2(CommandBuffer, &RestoreDepInfo);
+
+				break;
+			}
+		}
+	}
+
+	static void RecordBufferCopy(VkCommandBuffer CommandBuffer, const TransferTask* Task)
+	{
+		// Source can be written by upload of the same submit, it has to be available to the copy
+		VkBufferMemoryBarrier2 SrcBarrier = { };
+		SrcBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+		SrcBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		SrcBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		SrcBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		SrcBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+		SrcBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		SrcBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		SrcBarrier.buffer = Task->CopyDescr.SrcBuffer;
+		SrcBarrier.offset = Task->CopyDescr.SrcOffset;
+		SrcBarrier.size = Task->DataSize;
+
+		VkDependencyInfo SrcDepInfo = { };
+		SrcDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		SrcDepInfo.bufferMemoryBarrierCount = 1;
+		SrcDepInfo.pBufferMemoryBarriers = &SrcBarrier;
+
+		// New range has to be made visible for vertex input and for meshlet culling
+		VkBufferMemoryBarrier2 Barrier = { };
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+		Barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		Barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		Barrier.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		Barrier.dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+		Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.buffer = Task->CopyDescr.DstBuffer;
+		Barrier.offset = Task->CopyDescr.DstOffset;
+		Barrier.size = Task->DataSize;
+
+		VkDependencyInfo DepInfo = { };
+		DepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		DepInfo.bufferMemoryBarrierCount = 1;
+		DepInfo.pBufferMemoryBarriers = &Barrier;
+
+		VkBufferCopy CopyRegion = { };
+		CopyRegion.srcOffset = Task->CopyDescr.SrcOffset;
+		CopyRegion.dstOffset = Task->CopyDescr.DstOffset;
+		CopyRegion.size = Task->DataSize;
+
+		vkCmdPipelineBarrier2(CommandBuffer, &SrcDepInfo);
+		vkCmdCopyBuffer(CommandBuffer, Task->CopyDescr.SrcBuffer, Task->CopyDescr.DstBuffer, 1, &CopyRegion);
+		vkCmdPipelineBarrier2(CommandBuffer, &DepInfo);
+	}
+
+	static u64 RecordReadbacks(VkCommandBuffer CommandBuffer)
+	{
+		Memory::RingBufferControl* ReadbackControl = &TransferState.Readback.ControlBlock;
+		u64 ReadbacksAdded = 0;
+
+		std::unique_lock Lock(TransferState.PendingReadbacksLock);
+		while (!Memory::IsRingBufferEmpty(&TransferState.PendingReadbacks) && !Memory::IsRingBufferFull(&TransferState.ReadbacksInFlyQueue))
+		{
+			ReadbackTask* Task = Memory::RingBufferGetFirst(&TransferState.PendingReadbacks);
+
+			// Keep every readback offset valid for image copies
+			const u64 AlignedSize = Math::AlignNumber(Task->DataSize, 16ull);
+			if (!Memory::RingIsFit(ReadbackControl->Capacity, ReadbackControl->Head, ReadbackControl->Tail, ReadbackControl->Wrapped, AlignedSize))
+			{
+				// Wait until previous readbacks are consumed
+				break;
+			}
+
+			Task->ReadbackOffset = Memory::RingAlloc(ReadbackControl, AlignedSize, 1);
+			RecordReadbackTask(CommandBuffer, Task);
+
+			Memory::PushToRingBuffer(&TransferState.ReadbacksInFlyQueue, Task);
+			Memory::RingBufferPopFirst(&TransferState.PendingReadbacks);
+			++ReadbacksAdded;
+		}
+		Lock.unlock();
+
+		if (ReadbacksAdded > 0)
+		{
+			VkMemoryBarrier2 HostBarrier = { };
+			HostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+			HostBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+			HostBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			HostBarrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+			HostBarrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+			VkDependencyInfo DepInfo = { };
+			DepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			DepInfo.memoryBarrierCount = 1;
+			DepInfo.pMemoryBarriers = &HostBarrier;
+
+			vkCmdPipelineBarrier2(CommandBuffer, &DepInfo);
+		}
+
+		return ReadbacksAdded;
+	}
+
+	static void ProcessCompletedReadbacks(VkDevice Device)
+	{
+		u64 CompletedCounter = 0;
+		vkGetSemaphoreCounterValue(Device, TransferState.ReadbackSemaphore, &CompletedCounter);
+
+		while (TransferState.CompletedReadbacks < CompletedCounter)
+		{
+			assert(!Memory::IsRingBufferEmpty(&TransferState.ReadbacksInFlyQueue));
+
+			ReadbackTask* Task = Memory::RingBufferGetFirst(&TransferState.ReadbacksInFlyQueue);
+			if (Task->Callback != nullptr)
+			{
+				Task->Callback(TransferState.Readback.Allocation.MappedData + Task->ReadbackOffset, Task->DataSize, Task->UserData);
+			}
+
+			Memory::RingFree(&TransferState.Readback.ControlBlock, Math::AlignNumber(Task->DataSize, 16ull), 1);
+			Memory::RingBufferPopFirst(&TransferState.ReadbacksInFlyQueue);
+			++TransferState.CompletedReadbacks;
+		}
+	}
+
 	void Transfer()
 	{
 		VkDevice Device = VulkanInterface::GetDevice();
 
-		if (HasPendingTasks(&TransferState.TransferTasksQueue))
+		if (HasPendingTasks(&TransferState.TransferTasksQueue) || HasPendingReadbacks())
 		{
 			const u32 CurrentFrame = TransferState.CurrentFrame;
 
@@ -119,6 +392,15 @@ namespace TransferSystem
 			{
 				TransferTask* Task = GetFirstPendingTask(&TransferState.TransferTasksQueue);
 
+				if (Task->Type == RenderResources::ResourceType::MeshRelocation)
+				{
+					// Does not use staging memory
+					RecordBufferCopy(TransferCommandBuffer, Task);
+					PopPendingTask(&TransferState.TransferTasksQueue);
+					++TasksAdded;
+					continue;
+				}
+
 				const u64 AlignedSize = Math::AlignNumber(Task->DataSize, (u64)Task->Alignment);
 				const u64 Head = CurrentFrame * TransferState.MaxTransferSizePerFrame;
 				const u64 Offset = Head + TransferState.TransferStagingPool.AllocatedForFrame[CurrentFrame];
@@ -135,19 +417,22 @@ namespace TransferSystem
 
 				TransferState.TransferStagingPool.AllocatedForFrame[CurrentFrame] = NewTotal;
 
-				VulkanHelper::UpdateHostCompatibleBufferMemory(Device, TransferState.TransferStagingPool.Memory,
+				VulkanHelper::UpdateHostCompatibleBufferMemory(&TransferState.TransferStagingPool.Allocation,
 					Task->DataSize, AlignedOffset, Task->RawData);
 
 				switch (Task->Type)
 				{
 					case RenderResources::ResourceType::Mesh:
 					{
+						// Mesh data holds vertices, indices and meshlets that culling pass reads as storage buffer
 						VkBufferMemoryBarrier2 Barrier = { };
 						Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
 						Barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
 						Barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
-						Barrier.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
-						Barrier.dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+						Barrier.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT |
+							VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+						Barrier.dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT |
+							VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
 						Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 						Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 						Barrier.buffer = Task->DataDescr.DstBuffer;
@@ -172,12 +457,15 @@ namespace TransferSystem
 					case RenderResources::ResourceType::Material:
 					case RenderResources::ResourceType::Instance:
 					{
+						// Instances are gathered into batch regions by copy and read as instance attributes
 						VkBufferMemoryBarrier2 Barrier = { };
 						Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
 						Barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
 						Barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
-						Barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
-						Barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT;
+						Barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COPY_BIT |
+							VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+						Barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT |
+							VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
 						Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 						Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 						Barrier.buffer = Task->DataDescr.DstBuffer;
@@ -230,16 +518,27 @@ namespace TransferSystem
 						TransferDepInfo.bufferMemoryBarrierCount = 0;
 						TransferDepInfo.pBufferMemoryBarriers = nullptr;
 
-						VkBufferImageCopy ImageRegion = { };
-						ImageRegion.bufferOffset = AlignedOffset;
-						ImageRegion.bufferRowLength = 0;
-						ImageRegion.bufferImageHeight = 0;
-						ImageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						ImageRegion.imageSubresource.mipLevel = 0;
-						ImageRegion.imageSubresource.baseArrayLayer = 0;
-						ImageRegion.imageSubresource.layerCount = 1;
-						ImageRegion.imageOffset = { 0, 0, 0 };
-						ImageRegion.imageExtent = { Task->TextureDescr.Width, Task->TextureDescr.Height, 1 };
+						Memory::ClearArray(&TransferState.TextureCopyRegions);
+
+						for (u32 Layer = 0; Layer < Task->TextureDescr.ArrayLayers; ++Layer)
+						{
+							for (u32 Level = 0; Level < Task->TextureDescr.MipLevels; ++Level)
+							{
+								const u64 SubresourceOffset = Task->TextureDescr.SubresourceOffsets[Layer * Task->TextureDescr.MipLevels + Level];
+
+								VkBufferImageCopy* ImageRegion = Memory::ArrayGetNew(&TransferState.TextureCopyRegions);
+								*ImageRegion = { };
+								ImageRegion->bufferOffset = AlignedOffset + SubresourceOffset;
+								ImageRegion->bufferRowLength = 0;
+								ImageRegion->bufferImageHeight = 0;
+								ImageRegion->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+								ImageRegion->imageSubresource.mipLevel = Level;
+								ImageRegion->imageSubresource.baseArrayLayer = Layer;
+								ImageRegion->imageSubresource.layerCount = 1;
+								ImageRegion->imageOffset = { 0, 0, 0 };
+								ImageRegion->imageExtent = { glm::max(Task->TextureDescr.Width >> Level, 1u), glm::max(Task->TextureDescr.Height >> Level, 1u), 1 };
+							}
+						}
 
 						VkImageMemoryBarrier2 PresentationBarrier = { };
 						PresentationBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
@@ -272,7 +571,8 @@ namespace TransferSystem
 
 						vkCmdPipelineBarrier2(TransferCommandBuffer, &TransferDepInfo);
 						vkCmdCopyBufferToImage(TransferCommandBuffer, TransferState.TransferStagingPool.Buffer,
-							Task->TextureDescr.DstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &ImageRegion);
+							Task->TextureDescr.DstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+							TransferState.TextureCopyRegions.Count, TransferState.TextureCopyRegions.Data);
 						vkCmdPipelineBarrier2(TransferCommandBuffer, &PresentDepInfo);
 
 						break;
@@ -283,22 +583,43 @@ namespace TransferSystem
 				++TasksAdded;
 			}
 
-			TransferState.TasksInFly += TasksAdded;
+			const u64 ReadbacksAdded = RecordReadbacks(TransferCommandBuffer);
 
 			VULKAN_CHECK_RESULT(vkEndCommandBuffer(TransferCommandBuffer));
 
+			// Timeline values must grow, signal only semaphores that got new work
+			VkSemaphore SignalSemaphores[2];
+			u64 SignalValues[2];
+			u32 SignalCount = 0;
+
+			if (TasksAdded > 0)
+			{
+				TransferState.TasksInFly += TasksAdded;
+				SignalSemaphores[SignalCount] = TransferState.TransferSemaphore;
+				SignalValues[SignalCount] = TransferState.TasksInFly;
+				++SignalCount;
+			}
+
+			if (ReadbacksAdded > 0)
+			{
+				TransferState.ReadbacksInFly += ReadbacksAdded;
+				SignalSemaphores[SignalCount] = TransferState.ReadbackSemaphore;
+				SignalValues[SignalCount] = TransferState.ReadbacksInFly;
+				++SignalCount;
+			}
+
 			VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo = { };
 			TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
-			TimelineSubmitInfo.signalSemaphoreValueCount = 1;
-			TimelineSubmitInfo.pSignalSemaphoreValues = &TransferState.TasksInFly;
+			TimelineSubmitInfo.signalSemaphoreValueCount = SignalCount;
+			TimelineSubmitInfo.pSignalSemaphoreValues = SignalValues;
 
 			VkSubmitInfo SubmitInfo = { };
 			SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 			SubmitInfo.commandBufferCount = 1;
 			SubmitInfo.pCommandBuffers = &TransferCommandBuffer;
 			SubmitInfo.pNext = &TimelineSubmitInfo;
-			SubmitInfo.signalSemaphoreCount = 1;
-			SubmitInfo.pSignalSemaphores = &TransferState.TransferSemaphore;
+			SubmitInfo.signalSemaphoreCount = SignalCount;
+			SubmitInfo.pSignalSemaphores = SignalSemaphores;
 
 			VulkanCoreContext::VulkanCoreContext* CoreContext = RenderResources::GetCoreContext();
 
@@ -325,18 +646,21 @@ namespace TransferSystem
 				TransferTask* Task = GetFirstCompletedTask(&TransferState.TransferTasksQueue);
 				RenderResources::SetResourceReadyToRender(Task->ResourceIndex, Task->Type);
 
-				Memory::RingFree(&TransferState.TransferMemory.ControlBlock, Task->DataSize, 1);
+				// Completed in queue order, so released bytes are always the oldest claimed ones
+				const u64 MemoryTail = TransferState.TransferMemoryTail.load(std::memory_order_relaxed);
+				TransferState.TransferMemoryTail.store(MemoryTail + GetTransferMemoryHeader(Task->RawData)->AllocationSize, std::memory_order_release);
 				PopCompletedTask(&TransferState.TransferTasksQueue);
 			}
 
 			TransferState.CompletedTransfer = CompletedCounter;
 		}
+
+		ProcessCompletedReadbacks(Device);
 	}
 
 	void Init()
 	{
 		VulkanCoreContext::VulkanCoreContext* Context = RenderResources::GetCoreContext();
-		VkPhysicalDevice PhysicalDevice = Context->PhysicalDevice;
 		VkDevice Device = Context->LogicalDevice;
 
 		TransferState.CurrentFrame = 0;
@@ -377,27 +701,45 @@ namespace TransferSystem
 		SemaphoreInfo.flags = 0;
 
 		VULKAN_CHECK_RESULT(vkCreateSemaphore(Device, &SemaphoreInfo, nullptr, &TransferState.TransferSemaphore));
+		VULKAN_CHECK_RESULT(vkCreateSemaphore(Device, &SemaphoreInfo, nullptr, &TransferState.ReadbackSemaphore));
 
 		TransferState.CompletedTransfer = 0;
 		TransferState.TasksInFly = 0;
 
 		TransferState.TransferTasksQueue.Capacity = 1024 * 2 * 40;
-		TransferState.TransferTasksQueue.Memory = (TransferTask*)calloc(TransferState.TransferTasksQueue.Capacity, sizeof(TransferTask));
+		TransferState.TransferTasksQueue.Slots = (TaskSlot*)calloc(TransferState.TransferTasksQueue.Capacity, sizeof(TaskSlot));
+		for (u64 i = 0; i < TransferState.TransferTasksQueue.Capacity; ++i)
+		{
+			TransferState.TransferTasksQueue.Slots[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
 		TransferState.TransferTasksQueue.Tail.store(0, std::memory_order_relaxed);
 		TransferState.TransferTasksQueue.Middle.store(0, std::memory_order_relaxed);
-		TransferState.TransferTasksQueue.Head.store(0, std::memory_order_relaxed);
 
 		TransferState.TransferStagingPool = { };
 
 		TransferState.TransferStagingPool.Buffer = VulkanHelper::CreateBuffer(Device, TransferState.MaxTransferSizePerFrame * VulkanHelper::MAX_DRAW_FRAMES,
 			VulkanHelper::BufferUsageFlag::StagingFlag);
-		VulkanHelper::DeviceMemoryAllocResult AllocResult = VulkanHelper::AllocateDeviceMemory(PhysicalDevice, Device,
-			TransferState.TransferStagingPool.Buffer, VulkanHelper::MemoryPropertyFlag::HostCompatible);
-		TransferState.TransferStagingPool.Memory = AllocResult.Memory;
-
-		VULKAN_CHECK_RESULT(vkBindBufferMemory(Device, TransferState.TransferStagingPool.Buffer, TransferState.TransferStagingPool.Memory, 0));
-
-		TransferState.TransferMemory = Memory::AllocateRingBuffer<u8>(MB128);
+		TransferState.TransferStagingPool.Allocation = DeviceMemoryAllocator::AllocateBufferMemory(TransferState.TransferStagingPool.Buffer,
+			VulkanHelper::MemoryPropertyFlag::HostCompatible);
+
+		TransferState.Claims.store(0, std::memory_order_relaxed);
+		TransferState.TransferMemoryTail.store(0, std::memory_order_relaxed);
+		TransferState.TransferMemory = (u8*)malloc(TransferMemoryCapacity);
+		TransferState.TextureCopyRegions = Memory::AllocateArray<VkBufferImageCopy>(16);
+
+		TransferState.ReadbacksRequested = 0;
+		TransferState.ReadbacksInFly = 0;
+		TransferState.CompletedReadbacks = 0;
+
+		TransferState.PendingReadbacks = Memory::AllocateRingBuffer<ReadbackTask>(1024);
+		TransferState.ReadbacksInFlyQueue = Memory::AllocateRingBuffer<ReadbackTask>(1024);
+
+		TransferState.Readback = { };
+		TransferState.Readback.Buffer = VulkanHelper::CreateBuffer(Device, MB16, VulkanHelper::BufferUsageFlag::ReadbackFlag);
+		TransferState.Readback.Allocation = DeviceMemoryAllocator::AllocateBufferMemory(TransferState.Readback.Buffer,
+			VulkanHelper::MemoryPropertyFlag::HostCompatible);
+		TransferState.Readback.ControlBlock.Capacity = MB16;
 	}
 
 	void DeInit()
@@ -406,7 +748,7 @@ namespace TransferSystem
 		VkDevice Device = Context->LogicalDevice;
 
 		vkDestroyBuffer(Device, TransferState.TransferStagingPool.Buffer, nullptr);
-		vkFreeMemory(Device, TransferState.TransferStagingPool.Memory, nullptr);
+		DeviceMemoryAllocator::Free(&TransferState.TransferStagingPool.Allocation);
 
 		vkDestroyCommandPool(Device, TransferState.TransferCommandPool, nullptr);
 
@@ -416,18 +758,98 @@ namespace TransferSystem
 		}
 
 		vkDestroySemaphore(Device, TransferState.TransferSemaphore, nullptr);
+		vkDestroySemaphore(Device, TransferState.ReadbackSemaphore, nullptr);
 
-		free(TransferState.TransferTasksQueue.Memory);
-		Memory::FreeRingBuffer(&TransferState.TransferMemory);
+		vkDestroyBuffer(Device, TransferState.Readback.Buffer, nullptr);
+		DeviceMemoryAllocator::Free(&TransferState.Readback.Allocation);
+
+		Memory::FreeRingBuffer(&TransferState.PendingReadbacks);
+		Memory::FreeRingBuffer(&TransferState.ReadbacksInFlyQueue);
+
+		free(TransferState.TransferTasksQueue.Slots);
+		free(TransferState.TransferMemory);
+		Memory::FreeArray(&TransferState.TextureCopyRegions);
 	}
 
 	TransferMemory RequestTransferMemory(u64 Size)
 	{
-		return TransferState.TransferMemory.DataArray + Memory::RingAlloc(&TransferState.TransferMemory.ControlBlock, Size, 1);
+		TaskQueue* Queue = &TransferState.TransferTasksQueue;
+
+		const u64 AllocationSize = GetTransferAllocationSize(Size);
+
+		// Tails are loaded before claims, stale tails can only make fit checks stricter
+		const u64 QueueTail = Queue->Tail.load(std::memory_order_acquire);
+		const u64 MemoryTail = TransferState.TransferMemoryTail.load(std::memory_order_acquire);
+
+		u64 Claims = TransferState.Claims.load(std::memory_order_relaxed);
+		u64 Position;
+		u64 MemoryHead;
+		u64 Padding;
+		do
+		{
+			Position = UnwrapClaimCounter(Claims, QueueTail);
+			MemoryHead = UnwrapClaimCounter(Claims >> ClaimCounterBits, MemoryTail);
+
+			// Block never wraps, space left before the end is skipped and released together with block
+			const u64 Offset = MemoryHead % TransferMemoryCapacity;
+			Padding = Offset + AllocationSize > TransferMemoryCapacity ? TransferMemoryCapacity - Offset : 0;
+
+			if (Position - QueueTail >= Queue->Capacity || MemoryHead + Padding + AllocationSize - MemoryTail > TransferMemoryCapacity)
+			{
+				return nullptr;
+			}
+		}
+		while (!TransferState.Claims.compare_exchange_weak(Claims,
+			((MemoryHead + Padding + AllocationSize) << ClaimCounterBits) | ((Position + 1) & ClaimCounterMask), std::memory_order_relaxed));
+
+		TransferMemoryHeader* Header = (TransferMemoryHeader*)(TransferState.TransferMemory + (MemoryHead + Padding) % TransferMemoryCapacity);
+		Header->QueuePosition = Position;
+		Header->AllocationSize = Padding + AllocationSize;
+
+		return (u8*)Header + sizeof(TransferMemoryHeader);
 	}
 
 	void AddTask(TransferTask* Task)
 	{
-		AddPendingTask(&TransferState.TransferTasksQueue, Task);
+		TaskQueue* Queue = &TransferState.TransferTasksQueue;
+		const TransferMemoryHeader* Header = GetTransferMemoryHeader(Task->RawData);
+
+		// Slot is owned by caller since RequestTransferMemory so publishing needs no lock
+		TaskSlot* Slot = Queue->Slots + Header->QueuePosition % Queue->Capacity;
+		Slot->Task = *Task;
+		Slot->Sequence.store(Header->QueuePosition + 1, std::memory_order_release);
+	}
+
+	u64 GetTransferTimelineValue()
+	{
+		const u64 QueueTail = TransferState.TransferTasksQueue.Tail.load(std::memory_order_acquire);
+		return UnwrapClaimCounter(TransferState.Claims.load(std::memory_order_acquire), QueueTail);
+	}
+
+	VkSemaphore GetTransferSemaphore()
+	{
+		return TransferState.TransferSemaphore;
+	}
+
+	u64 AddReadbackTask(ReadbackTask* Task)
+	{
+		assert(Task->DataSize != 0);
+		assert(Task->DataSize <= TransferState.Readback.ControlBlock.Capacity);
+
+		std::unique_lock Lock(TransferState.PendingReadbacksLock);
+		if (Memory::IsRingBufferFull(&TransferState.PendingReadbacks))
+		{
+			return 0;
+		}
+
+		Memory::PushToRingBuffer(&TransferState.PendingReadbacks, Task);
+		return ++TransferState.ReadbacksRequested;
+	}
+
+	bool IsReadbackComplete(u64 ReadbackTicket)
+	{
+		u64 CompletedCounter = 0;
+		vkGetSemaphoreCounterValue(VulkanInterface::GetDevice(), TransferState.ReadbackSemaphore, &CompletedCounter);
+		return CompletedCounter >= ReadbackTicket;
 	}
 }
\ No newline at end of file
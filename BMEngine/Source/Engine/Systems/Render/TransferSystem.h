@@ -12,6 +12,10 @@ namespace TransferSystem
 		VkImage DstImage;
 		u32 Width;
 		u32 Height;
+		u32 MipLevels;
+		u32 ArrayLayers;
+		// Lives in transfer memory right after RawData, indexed [Layer * MipLevels + Level]
+		u64* SubresourceOffsets;
 	};
 
 	struct DataTaskDescription
@@ -20,12 +24,22 @@ namespace TransferSystem
 		u64 DstOffset;
 	};
 
+	// Device side copy, source and destination ranges must not overlap
+	struct CopyTaskDescription
+	{
+		VkBuffer SrcBuffer;
+		u64 SrcOffset;
+		VkBuffer DstBuffer;
+		u64 DstOffset;
+	};
+
 	struct TransferTask
 	{
 		union
 		{
 			TextureTaskDescription TextureDescr;
 			DataTaskDescription DataDescr;
+			CopyTaskDescription CopyDescr;
 		};
 
 		void* RawData;
@@ -35,6 +49,52 @@ namespace TransferSystem
 		u32 ResourceIndex;
 	};
 
+	enum class ReadbackType
+	{
+		Buffer,
+		Image,
+	};
+
+	typedef void (*ReadbackCallback)(const void* Data, u64 DataSize, void* UserData);
+
+	struct BufferReadbackDescription
+	{
+		VkBuffer SrcBuffer;
+		u64 SrcOffset;
+	};
+
+	struct ImageReadbackDescription
+	{
+		VkImage SrcImage;
+		VkImageLayout SrcLayout;
+		VkImageAspectFlags AspectMask;
+		u32 Width;
+		u32 Height;
+		u32 MipLevel;
+		u32 ArrayLayer;
+	};
+
+	struct ReadbackTask
+	{
+		union
+		{
+			BufferReadbackDescription BufferDescr;
+			ImageReadbackDescription ImageDescr;
+		};
+
+		// Stage and access of the last GPU write to the source
+		VkPipelineStageFlags2 SrcStageMask;
+		VkAccessFlags2 SrcAccessMask;
+
+		u64 DataSize;
+		ReadbackType Type;
+		ReadbackCallback Callback;
+		void* UserData;
+
+		// Filled by transfer system
+		u64 ReadbackOffset;
+	};
+
 	typedef void* TransferMemory;
 
 	struct ResourceTransferMemory
@@ -48,7 +108,20 @@ namespace TransferSystem
 
 	void Transfer();
 
+	// Reserves memory together with queue slot, returns nullptr when queue or memory is full.
+	// Every reserved block has to be passed to AddTask as Task->RawData
 	TransferMemory RequestTransferMemory(u64 Size);
 
+	// Safe to call from any thread
 	void AddTask(TransferTask* Task);
+
+	// Value transfer semaphore reaches when every task reserved so far is completed
+	u64 GetTransferTimelineValue();
+	VkSemaphore GetTransferSemaphore();
+
+	// Source has to be written by work that is already submitted. Returns ticket for IsReadbackComplete,
+	// callback is called from Transfer once data is on host and memory is reused right after it returns.
+	// Returns 0 when pending readback queue is full, caller retries later, 0 is never a valid ticket
+	u64 AddReadbackTask(ReadbackTask* Task);
+	bool IsReadbackComplete(u64 ReadbackTicket);
 }
\ No newline at end of file
@@ -5,10 +5,12 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+
 namespace VulkanCoreContext
 {
 	static VkDevice CreateLogicalDevice(VkPhysicalDevice PhDevice, VulkanHelper::PhysicalDeviceIndices Indices, const char* DeviceExtensions[],
-		u32 DeviceExtensionsSize)
+		u32 DeviceExtensionsSize, bool EnableDrawIndirectCount)
 	{
 		const f32 Priority = 1.0f;
 
@@ -38,6 +40,8 @@ namespace VulkanCoreContext
 		DeviceFeatures2.features.fillModeNonSolid = VK_TRUE; // Todo: get from configs
 		DeviceFeatures2.features.samplerAnisotropy = VK_TRUE; // Todo: get from configs
 		DeviceFeatures2.features.multiViewport = VK_TRUE; // Todo: get from configs
+		DeviceFeatures2.features.multiDrawIndirect = EnableDrawIndirectCount;
+		DeviceFeatures2.features.drawIndirectFirstInstance = EnableDrawIndirectCount;
 
 		// TODO: Check if supported
 		VkPhysicalDeviceDynamicRenderingFeatures DynamicRenderingFeatures = { };
@@ -50,23 +54,20 @@ namespace VulkanCoreContext
 		Sync2Features.synchronization2 = VK_TRUE;
 
 		// TODO: Check if supported
-		VkPhysicalDeviceDescriptorIndexingFeatures IndexingFeatures = { };
-		IndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-		IndexingFeatures.runtimeDescriptorArray = VK_TRUE;
-		IndexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
-		IndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
-		IndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
-
-		VkPhysicalDeviceTimelineSemaphoreFeatures TimelineSemaphoreFeatures = { };
-		TimelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
-		TimelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
-
-		VkPhysicalDeviceFeatures DeviceFeatures = { };
-		DeviceFeatures.samplerAnisotropy = VK_TRUE;
-
-		DeviceFeatures2.pNext = &TimelineSemaphoreFeatures;
-		TimelineSemaphoreFeatures.pNext = &IndexingFeatures;
-		IndexingFeatures.pNext = &Sync2Features;
+		// drawIndirectCount exists only in Vulkan12Features, so it replaces separate indexing and timeline structures
+		VkPhysicalDeviceVulkan12Features Vulkan12Features = { };
+		Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		Vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+		Vulkan12Features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+		Vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		Vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		Vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		Vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		Vulkan12Features.timelineSemaphore = VK_TRUE;
+		Vulkan12Features.drawIndirectCount = EnableDrawIndirectCount;
+
+		DeviceFeatures2.pNext = &Vulkan12Features;
+		Vulkan12Features.pNext = &Sync2Features;
 		Sync2Features.pNext = &DynamicRenderingFeatures;
 
 
@@ -239,7 +240,37 @@ namespace VulkanCoreContext
 			Util::RenderLog(Util::LogType::Error, "Cannot find suitable device");
 		}
 
-		Context->LogicalDevice = CreateLogicalDevice(Context->PhysicalDevice, Context->Indices, DeviceExtensions, DeviceExtensionsSize);
+		VkPhysicalDeviceVulkan12Features AvailableVulkan12Features = { };
+		AvailableVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceFeatures2 AvailableFeatures2 = { };
+		AvailableFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		AvailableFeatures2.pNext = &AvailableVulkan12Features;
+		vkGetPhysicalDeviceFeatures2(Context->PhysicalDevice, &AvailableFeatures2);
+
+		Context->IsDrawIndirectCountSupported = AvailableVulkan12Features.drawIndirectCount &&
+			AvailableFeatures2.features.multiDrawIndirect && AvailableFeatures2.features.drawIndirectFirstInstance;
+
+		if (!Context->IsDrawIndirectCountSupported)
+		{
+			Util::RenderLog(Util::LogType::Warning, "Indirect draw count is not supported, batches are drawn one by one");
+		}
+
+		VkPhysicalDeviceVulkan12Properties Vulkan12Properties = { };
+		Vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 DeviceProperties2 = { };
+		DeviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		DeviceProperties2.pNext = &Vulkan12Properties;
+		vkGetPhysicalDeviceProperties2(Context->PhysicalDevice, &DeviceProperties2);
+
+		Context->MaxUpdateAfterBindSamplers = std::min({ Vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+			Vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages, Vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+			Vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages });
+		Context->MinStorageBufferOffsetAlignment = DeviceProperties2.properties.limits.minStorageBufferOffsetAlignment;
+
+		Context->LogicalDevice = CreateLogicalDevice(Context->PhysicalDevice, Context->Indices, DeviceExtensions, DeviceExtensionsSize,
+			Context->IsDrawIndirectCountSupported);
 
 		u32 SurfaceFormatCount;
 		VULKAN_CHECK_RESULT(vkGetPhysicalDeviceSurfaceFormatsKHR(Context->PhysicalDevice, Context->Surface, &SurfaceFormatCount, nullptr));
@@ -34,6 +34,13 @@ namespace VulkanCoreContext
 
 		VkQueue GraphicsQueue;
 		std::mutex QueueSubmitMutex;
+
+		// drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance are enabled
+		bool IsDrawIndirectCountSupported;
+		// Smallest of per stage and per set update after bind sampler and sampled image limits
+		u32 MaxUpdateAfterBindSamplers;
+		// Storage buffer descriptors of shared buffers start at multiples of it
+		VkDeviceSize MinStorageBufferOffsetAlignment;
 	};
 
 	void CreateCoreContext(VulkanCoreContext* Context, GLFWwindow* Window);
@@ -95,52 +95,34 @@ namespace VulkanHelper
 		return Buffer;
 	}
 
-	DeviceMemoryAllocResult AllocateDeviceMemory(VkPhysicalDevice PhysicalDevice, VkDevice Device, VkBuffer Buffer, MemoryPropertyFlag Properties)
+	void UpdateHostCompatibleBufferMemory(const DeviceMemoryAllocation* Allocation, VkDeviceSize DataSize, VkDeviceSize Offset, const void* Data)
 	{
-		VkMemoryRequirements MemoryRequirements;
-		vkGetBufferMemoryRequirements(Device, Buffer, &MemoryRequirements);
-
-		const u32 MemoryTypeIndex = VulkanHelper::GetMemoryTypeIndex(PhysicalDevice, MemoryRequirements.memoryTypeBits, (VkFlags)Properties);
-
-		VkMemoryAllocateInfo MemoryAllocInfo = { };
-		MemoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		MemoryAllocInfo.allocationSize = MemoryRequirements.size;
-		MemoryAllocInfo.memoryTypeIndex = MemoryTypeIndex;
-
-		DeviceMemoryAllocResult Result;
-		VULKAN_CHECK_RESULT(vkAllocateMemory(Device, &MemoryAllocInfo, nullptr, &Result.Memory));
-		Result.Alignment = MemoryRequirements.alignment;
-		Result.Size = MemoryRequirements.size;
-
-		return Result;
+		// Host compatible memory is coherent and stays mapped
+		assert(Allocation->MappedData != nullptr);
+		assert(Offset + DataSize <= Allocation->Size);
+		std::memcpy(Allocation->MappedData + Offset, Data, DataSize);
 	}
 
-	DeviceMemoryAllocResult AllocateDeviceMemory(VkPhysicalDevice PhysicalDevice, VkDevice Device, VkImage Image, MemoryPropertyFlag Properties)
+	void WriteStorageBufferDescriptors(VkDevice Device, VkDescriptorSet Set, const VkDescriptorBufferInfo* BufferInfos, u32 Count)
 	{
-		VkMemoryRequirements MemoryRequirements;
-		vkGetImageMemoryRequirements(Device, Image, &MemoryRequirements);
+		assert(Count > 0);
 
-		const u32 MemoryTypeIndex = VulkanHelper::GetMemoryTypeIndex(PhysicalDevice, MemoryRequirements.memoryTypeBits, (VkFlags)Properties);
-
-		VkMemoryAllocateInfo MemoryAllocInfo = { };
-		MemoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		MemoryAllocInfo.allocationSize = MemoryRequirements.size;
-		MemoryAllocInfo.memoryTypeIndex = MemoryTypeIndex;
-
-		DeviceMemoryAllocResult Result;
-		VULKAN_CHECK_RESULT(vkAllocateMemory(Device, &MemoryAllocInfo, nullptr, &Result.Memory));
-		Result.Alignment = MemoryRequirements.alignment;
-		Result.Size = MemoryRequirements.size;
-
-		return Result;
-	}
+		auto Writes = Memory::AllocateArray<VkWriteDescriptorSet>(Count);
+		for (u32 Binding = 0; Binding < Count; ++Binding)
+		{
+			VkWriteDescriptorSet* Write = Memory::ArrayGetNew(&Writes);
+			*Write = { };
+			Write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			Write->dstSet = Set;
+			Write->dstBinding = Binding;
+			Write->dstArrayElement = 0;
+			Write->descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			Write->descriptorCount = 1;
+			Write->pBufferInfo = BufferInfos + Binding;
+		}
 
-	void UpdateHostCompatibleBufferMemory(VkDevice Device, VkDeviceMemory Memory, VkDeviceSize DataSize, VkDeviceSize Offset, const void* Data)
-	{
-		void* MappedMemory;
-		vkMapMemory(Device, Memory, Offset, DataSize, 0, &MappedMemory);
-		std::memcpy(MappedMemory, Data, DataSize);
-		vkUnmapMemory(Device, Memory);
+		vkUpdateDescriptorSets(Device, Count, Writes.Data, 0, nullptr);
+		Memory::FreeArray(&Writes);
 	}
 
 
@@ -31,11 +31,15 @@ namespace VulkanHelper
 	{
 		UniformFlag = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 		StagingFlag = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		ReadbackFlag = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 		StorageFlag = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 		VertexFlag = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 		IndexFlag = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		CombinedVertexIndexFlag = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		InstanceFlag = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		CombinedVertexIndexFlag = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		InstanceFlag = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		IndirectFlag = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		IndirectStorageFlag = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 	};
 
 	enum class MemoryPropertyFlag
@@ -51,17 +55,23 @@ namespace VulkanHelper
 		s32 TransferFamily;
 	};
 
-	struct DeviceMemoryAllocResult
+	// Range inside memory block owned by DeviceMemoryAllocator
+	struct DeviceMemoryAllocation
 	{
 		VkDeviceMemory Memory;
-		u64 Alignment;
+		u64 Offset;
 		u64 Size;
+		u64 Alignment;
+		// Points to Offset inside persistently mapped block, nullptr for memory that is not host visible
+		u8* MappedData;
+		u32 BlockIndex;
+		u32 Order;
 	};
 
 	struct GPUBuffer
 	{
 		VkBuffer Buffer;
-		VkDeviceMemory Memory;
+		DeviceMemoryAllocation Allocation;
 		u64 Capacity;
 		u64 Alignment;
 		u64 Offset;
@@ -135,12 +145,11 @@ namespace VulkanHelper
 	VkDeviceSize CalculateBufferAlignedSize(VkDevice Device, VkBuffer Buffer, u64 BufferSize);
 	VkDeviceSize CalculateImageAlignedSize(VkDevice Device, VkImage Image, u64 ImageSize);
 
-	DeviceMemoryAllocResult AllocateDeviceMemory(VkPhysicalDevice PhysicalDevice, VkDevice Device, VkBuffer Buffer, MemoryPropertyFlag Properties);
-	DeviceMemoryAllocResult AllocateDeviceMemory(VkPhysicalDevice PhysicalDevice, VkDevice Device, VkImage Image, MemoryPropertyFlag Properties);
-
 	VkBuffer CreateBuffer(VkDevice Device, u64 Size, BufferUsageFlag Flag);
 
-	void UpdateHostCompatibleBufferMemory(VkDevice Device, VkDeviceMemory Memory, VkDeviceSize DataSize, VkDeviceSize Offset, const void* Data);
+	void UpdateHostCompatibleBufferMemory(const DeviceMemoryAllocation* Allocation, VkDeviceSize DataSize, VkDeviceSize Offset, const void* Data);
+	// BufferInfos[i] is written to storage buffer binding i of Set
+	void WriteStorageBufferDescriptors(VkDevice Device, VkDescriptorSet Set, const VkDescriptorBufferInfo* BufferInfos, u32 Count);
 
 	u32 GetFormatAlignment(VkFormat Format);
 
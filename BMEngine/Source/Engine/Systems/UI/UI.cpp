@@ -51,6 +51,11 @@ namespace UI
 
 
 
+		if (Data->OnReloadModels != nullptr && ImGui::Button("Reload models"))
+		{
+			Data->OnReloadModels();
+		}
+
 		ImGuiIO& GuiIo = ImGui::GetIO();
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / GuiIo.Framerate, GuiIo.Framerate);
 		ImGui::End();
@@ -6,6 +6,7 @@
 namespace UI
 {
 	typedef void (*TestSetDownload)(bool Download);
+	typedef void (*ReloadModels)();
 
 	struct GuiData
 	{
@@ -15,6 +16,8 @@ namespace UI
 		TestSetDownload OnTestSetDownload = nullptr;
 		glm::vec3* CameraMercatorPosition = nullptr;
 		int* Zoom = nullptr;
+
+		ReloadModels OnReloadModels = nullptr;
 	};
 
 	void Init(GuiData* Data);
@@ -3,9 +3,11 @@
 #include <stdint.h>
 
 typedef uint8_t u8;
+typedef uint16_t u16;
 typedef uint32_t u32;
 typedef uint64_t u64;
 
+typedef int16_t s16;
 typedef int32_t s32;
 
 typedef float f32;
@@ -23,5 +25,8 @@ static const u32 MB128 = MB64 * 2;
 static const u32 MB256 = MB128 * 2;
 static const u32 IMAGE_ALIGNMENT = 4096;
 static const u32 MAX_LIGHT_SOURCES = 2;
+// Camera view followed by view of every light source
+static const u32 MAX_DRAW_VIEWS = 1 + MAX_LIGHT_SOURCES;
+static const u32 MAX_MESH_LODS = 4;
 static const u32 MAX_DESCRIPTOR_SET_LAYOUTS_PER_PIPELINE = 8;
 static const u32 MAX_DESCRIPTOR_BINDING_PER_SET = 16;
\ No newline at end of file
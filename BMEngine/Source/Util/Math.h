@@ -40,4 +40,53 @@ namespace Math
 	{
 		return (Number + Step) % Max;
 	}
+
+	// Six normalized planes facing inside of frustum, expects zero to one clip space depth
+	static void ExtractFrustumPlanes(const glm::mat4& ViewProjection, glm::vec4* OutPlanes)
+	{
+		const glm::mat4 Rows = glm::transpose(ViewProjection);
+
+		OutPlanes[0] = Rows[3] + Rows[0];
+		OutPlanes[1] = Rows[3] - Rows[0];
+		OutPlanes[2] = Rows[3] + Rows[1];
+		OutPlanes[3] = Rows[3] - Rows[1];
+		OutPlanes[4] = Rows[2];
+		OutPlanes[5] = Rows[3] - Rows[2];
+
+		for (u32 i = 0; i < 6; ++i)
+		{
+			OutPlanes[i] /= glm::length(glm::vec3(OutPlanes[i]));
+		}
+	}
+
+	// Sphere around center of bounding box, every point starts with glm::vec3 and points are Stride bytes apart
+	static glm::vec4 ComputeBoundingSphere(const void* Points, u64 Stride, u64 Count)
+	{
+		if (Count == 0)
+		{
+			return glm::vec4(0.0f);
+		}
+
+		const u8* Data = (const u8*)Points;
+
+		glm::vec3 Min = *(const glm::vec3*)Data;
+		glm::vec3 Max = Min;
+		for (u64 i = 1; i < Count; ++i)
+		{
+			const glm::vec3 Point = *(const glm::vec3*)(Data + i * Stride);
+			Min = glm::min(Min, Point);
+			Max = glm::max(Max, Point);
+		}
+
+		const glm::vec3 Center = (Min + Max) * 0.5f;
+
+		f32 RadiusSquared = 0.0f;
+		for (u64 i = 0; i < Count; ++i)
+		{
+			const glm::vec3 Offset = *(const glm::vec3*)(Data + i * Stride) - Center;
+			RadiusSquared = glm::max(RadiusSquared, glm::dot(Offset, Offset));
+		}
+
+		return glm::vec4(Center, std::sqrt(RadiusSquared));
+	}
 }
\ No newline at end of file
@@ -0,0 +1,896 @@
+#include "MeshOptimizer.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <unordered_map>
+
+namespace MeshOptimizer
+{
+	// Cache entries are timestamps, vertex is cached while less than CacheSize misses happened after its own miss
+	struct FifoCache
+	{
+		std::vector<u64> MissTime;
+		u64 Time;
+		u32 Size;
+	};
+
+	static void InitCache(FifoCache* Cache, u64 VertexCount, u32 CacheSize)
+	{
+		Cache->MissTime.assign(VertexCount, 0);
+		Cache->Time = CacheSize + 1;
+		Cache->Size = CacheSize;
+	}
+
+	static void ResetCache(FifoCache* Cache)
+	{
+		Cache->Time += Cache->Size + 1;
+	}
+
+	static bool IsCached(const FifoCache* Cache, u32 Vertex)
+	{
+		return Cache->Time - Cache->MissTime[Vertex] <= Cache->Size;
+	}
+
+	// Returns true on miss
+	static bool TouchCache(FifoCache* Cache, u32 Vertex)
+	{
+		if (IsCached(Cache, Vertex))
+		{
+			return false;
+		}
+
+		Cache->MissTime[Vertex] = Cache->Time++;
+		return true;
+	}
+
+	static u32 TouchTriangle(FifoCache* Cache, const u32* Triangle)
+	{
+		u32 Misses = 0;
+		for (u32 i = 0; i < 3; ++i)
+		{
+			Misses += TouchCache(Cache, Triangle[i]) ? 1 : 0;
+		}
+
+		return Misses;
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const u32* Indices, u64 IndexCount, u64 VertexCount, u32 CacheSize)
+	{
+		assert(IndexCount % 3 == 0);
+
+		VertexCacheStatistics Statistics = { };
+		if (IndexCount == 0)
+		{
+			return Statistics;
+		}
+
+		FifoCache Cache;
+		InitCache(&Cache, VertexCount, CacheSize);
+
+		std::vector<u8> IsUsed(VertexCount, 0);
+		u64 UsedVertices = 0;
+		u64 Misses = 0;
+
+		for (u64 i = 0; i < IndexCount; i += 3)
+		{
+			Misses += TouchTriangle(&Cache, Indices + i);
+
+			for (u32 j = 0; j < 3; ++j)
+			{
+				UsedVertices += IsUsed[Indices[i + j]] ? 0 : 1;
+				IsUsed[Indices[i + j]] = 1;
+			}
+		}
+
+		Statistics.ACMR = (f32)Misses / (f32)(IndexCount / 3);
+		Statistics.ATVR = (f32)Misses / (f32)UsedVertices;
+
+		return Statistics;
+	}
+
+	void OptimizeVertexCache(u32* Destination, const u32* Indices, u64 IndexCount, u64 VertexCount, u32 CacheSize)
+	{
+		assert(IndexCount % 3 == 0 && Destination != Indices);
+
+		if (IndexCount == 0)
+		{
+			return;
+		}
+
+		const u64 TriangleCount = IndexCount / 3;
+
+		// Triangles of every vertex
+		std::vector<u32> AdjacencyOffsets(VertexCount + 1, 0);
+		for (u64 i = 0; i < IndexCount; ++i)
+		{
+			++AdjacencyOffsets[Indices[i] + 1];
+		}
+
+		for (u64 i = 0; i < VertexCount; ++i)
+		{
+			AdjacencyOffsets[i + 1] += AdjacencyOffsets[i];
+		}
+
+		std::vector<u32> Adjacency(IndexCount);
+		std::vector<u32> AdjacencyFill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+		for (u64 i = 0; i < IndexCount; ++i)
+		{
+			Adjacency[AdjacencyFill[Indices[i]]++] = (u32)(i / 3);
+		}
+
+		std::vector<u32> LiveTriangles(VertexCount);
+		for (u64 i = 0; i < VertexCount; ++i)
+		{
+			LiveTriangles[i] = AdjacencyOffsets[i + 1] - AdjacencyOffsets[i];
+		}
+
+		std::vector<u8> IsEmitted(TriangleCount, 0);
+		std::vector<u32> DeadEnds;
+		std::vector<u32> Candidates;
+		DeadEnds.reserve(IndexCount);
+
+		FifoCache Cache;
+		InitCache(&Cache, VertexCount, CacheSize);
+
+		u64 OutputCount = 0;
+		u64 NextVertex = 0;
+		u32 Fanning = Indices[0];
+
+		while (Fanning != UINT32_MAX)
+		{
+			Candidates.clear();
+
+			for (u32 i = AdjacencyOffsets[Fanning]; i < AdjacencyOffsets[Fanning + 1]; ++i)
+			{
+				const u32 Triangle = Adjacency[i];
+				if (IsEmitted[Triangle])
+				{
+					continue;
+				}
+
+				for (u32 j = 0; j < 3; ++j)
+				{
+					const u32 Vertex = Indices[Triangle * 3 + j];
+
+					Destination[OutputCount++] = Vertex;
+					DeadEnds.push_back(Vertex);
+					Candidates.push_back(Vertex);
+					--LiveTriangles[Vertex];
+					TouchCache(&Cache, Vertex);
+				}
+
+				IsEmitted[Triangle] = 1;
+			}
+
+			// Oldest candidate that still stays in cache while its remaining triangles are emitted
+			u32 Best = UINT32_MAX;
+			s32 BestPriority = -1;
+			for (u32 Vertex : Candidates)
+			{
+				if (LiveTriangles[Vertex] == 0)
+				{
+					continue;
+				}
+
+				s32 Priority = 0;
+				const u64 Age = Cache.Time - Cache.MissTime[Vertex];
+				if (Age + 2 * LiveTriangles[Vertex] <= CacheSize)
+				{
+					Priority = (s32)Age;
+				}
+
+				if (Priority > BestPriority)
+				{
+					Best = Vertex;
+					BestPriority = Priority;
+				}
+			}
+
+			// Dead end, continue from recently used vertices and then from first vertex with live triangles
+			while (Best == UINT32_MAX && !DeadEnds.empty())
+			{
+				const u32 Vertex = DeadEnds.back();
+				DeadEnds.pop_back();
+
+				if (LiveTriangles[Vertex] > 0)
+				{
+					Best = Vertex;
+				}
+			}
+
+			while (Best == UINT32_MAX && NextVertex < VertexCount)
+			{
+				if (LiveTriangles[NextVertex] > 0)
+				{
+					Best = (u32)NextVertex;
+				}
+
+				++NextVertex;
+			}
+
+			Fanning = Best;
+		}
+
+		assert(OutputCount == IndexCount);
+	}
+
+	static const f32* GetPosition(const f32* Positions, u64 PositionStride, u32 Vertex)
+	{
+		return (const f32*)((const u8*)Positions + Vertex * PositionStride);
+	}
+
+	void OptimizeOverdraw(u32* Destination, const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride,
+		u64 VertexCount, u32 CacheSize, f32 Threshold)
+	{
+		assert(IndexCount % 3 == 0 && Destination != Indices);
+
+		const u64 TriangleCount = IndexCount / 3;
+		if (TriangleCount == 0)
+		{
+			return;
+		}
+
+		FifoCache Cache;
+		InitCache(&Cache, VertexCount, CacheSize);
+
+		// Triangle that misses every vertex starts new cluster, cache optimizer jumped to another part of mesh there
+		std::vector<u32> HardClusters;
+		u64 Misses = 0;
+		for (u64 i = 0; i < TriangleCount; ++i)
+		{
+			const u32 TriangleMisses = TouchTriangle(&Cache, Indices + i * 3);
+			if (i == 0 || TriangleMisses == 3)
+			{
+				HardClusters.push_back((u32)i);
+			}
+
+			Misses += TriangleMisses;
+		}
+
+		HardClusters.push_back((u32)TriangleCount);
+
+		// Hard clusters are cut further once cut costs less than Threshold of mesh cache efficiency
+		const f32 TargetACMR = (f32)Misses / (f32)TriangleCount * Threshold;
+
+		std::vector<u32> Clusters;
+		for (u64 i = 0; i + 1 < HardClusters.size(); ++i)
+		{
+			ResetCache(&Cache);
+
+			u32 ClusterMisses = 0;
+			u32 ClusterTriangles = 0;
+
+			Clusters.push_back(HardClusters[i]);
+			for (u32 Triangle = HardClusters[i]; Triangle < HardClusters[i + 1]; ++Triangle)
+			{
+				ClusterMisses += TouchTriangle(&Cache, Indices + Triangle * 3);
+				++ClusterTriangles;
+
+				if (Triangle + 1 < HardClusters[i + 1] && (f32)ClusterMisses / (f32)ClusterTriangles <= TargetACMR)
+				{
+					Clusters.push_back(Triangle + 1);
+					ResetCache(&Cache);
+					ClusterMisses = 0;
+					ClusterTriangles = 0;
+				}
+			}
+		}
+
+		Clusters.push_back((u32)TriangleCount);
+
+		const u64 ClusterCount = Clusters.size() - 1;
+
+		// Area weighted centroid and normal of every cluster
+		std::vector<f32> ClusterData(ClusterCount * 6, 0.0f);
+		std::vector<f32> ClusterAreas(ClusterCount, 0.0f);
+		f32 MeshCentroid[3] = { };
+		f32 MeshArea = 0.0f;
+
+		for (u64 Cluster = 0; Cluster < ClusterCount; ++Cluster)
+		{
+			f32* Centroid = ClusterData.data() + Cluster * 6;
+			f32* Normal = Centroid + 3;
+
+			for (u32 Triangle = Clusters[Cluster]; Triangle < Clusters[Cluster + 1]; ++Triangle)
+			{
+				const f32* P0 = GetPosition(Positions, PositionStride, Indices[Triangle * 3 + 0]);
+				const f32* P1 = GetPosition(Positions, PositionStride, Indices[Triangle * 3 + 1]);
+				const f32* P2 = GetPosition(Positions, PositionStride, Indices[Triangle * 3 + 2]);
+
+				const f32 E0[3] = { P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2] };
+				const f32 E1[3] = { P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2] };
+				const f32 Cross[3] =
+				{
+					E0[1] * E1[2] - E0[2] * E1[1],
+					E0[2] * E1[0] - E0[0] * E1[2],
+					E0[0] * E1[1] - E0[1] * E1[0]
+				};
+
+				const f32 Area = std::sqrt(Cross[0] * Cross[0] + Cross[1] * Cross[1] + Cross[2] * Cross[2]);
+
+				for (u32 Axis = 0; Axis < 3; ++Axis)
+				{
+					Centroid[Axis] += (P0[Axis] + P1[Axis] + P2[Axis]) / 3.0f * Area;
+					Normal[Axis] += Cross[Axis];
+				}
+
+				ClusterAreas[Cluster] += Area;
+			}
+
+			for (u32 Axis = 0; Axis < 3; ++Axis)
+			{
+				MeshCentroid[Axis] += Centroid[Axis];
+			}
+
+			MeshArea += ClusterAreas[Cluster];
+		}
+
+		if (MeshArea > 0.0f)
+		{
+			for (u32 Axis = 0; Axis < 3; ++Axis)
+			{
+				MeshCentroid[Axis] /= MeshArea;
+			}
+		}
+
+		// Clusters facing away from mesh center occlude inner ones, so they go first
+		std::vector<f32> SortKeys(ClusterCount, 0.0f);
+		for (u64 Cluster = 0; Cluster < ClusterCount; ++Cluster)
+		{
+			const f32* Centroid = ClusterData.data() + Cluster * 6;
+			const f32* Normal = Centroid + 3;
+			const f32 Area = ClusterAreas[Cluster];
+			const f32 NormalLength = std::sqrt(Normal[0] * Normal[0] + Normal[1] * Normal[1] + Normal[2] * Normal[2]);
+
+			if (Area == 0.0f || NormalLength == 0.0f)
+			{
+				continue;
+			}
+
+			for (u32 Axis = 0; Axis < 3; ++Axis)
+			{
+				SortKeys[Cluster] += (Centroid[Axis] / Area - MeshCentroid[Axis]) * Normal[Axis] / NormalLength;
+			}
+		}
+
+		std::vector<u32> ClusterOrder(ClusterCount);
+		for (u64 i = 0; i < ClusterCount; ++i)
+		{
+			ClusterOrder[i] = (u32)i;
+		}
+
+		std::stable_sort(ClusterOrder.begin(), ClusterOrder.end(), [&SortKeys](u32 Left, u32 Right)
+		{
+			return SortKeys[Left] > SortKeys[Right];
+		});
+
+		u64 OutputCount = 0;
+		for (u32 Cluster : ClusterOrder)
+		{
+			const u64 First = (u64)Clusters[Cluster] * 3;
+			const u64 Count = (u64)Clusters[Cluster + 1] * 3 - First;
+
+			std::copy(Indices + First, Indices + First + Count, Destination + OutputCount);
+			OutputCount += Count;
+		}
+
+		assert(OutputCount == IndexCount);
+	}
+
+	// Sum of squared distances to triangle planes weighted by triangle area, Weight is total area
+	struct Quadric
+	{
+		f64 XX, XY, XZ, XW;
+		f64 YY, YZ, YW;
+		f64 ZZ, ZW;
+		f64 WW;
+		f64 Weight;
+	};
+
+	struct EdgeCollapse
+	{
+		u32 From;
+		u32 To;
+		f32 Error;
+	};
+
+	static void AddQuadric(Quadric* Dst, const Quadric* Src)
+	{
+		f64* DstData = &Dst->XX;
+		const f64* SrcData = &Src->XX;
+		for (u32 i = 0; i < sizeof(Quadric) / sizeof(f64); ++i)
+		{
+			DstData[i] += SrcData[i];
+		}
+	}
+
+	static void AddTriangleQuadric(Quadric* Q, const f32* P0, const f32* P1, const f32* P2)
+	{
+		const f64 E0[3] = { (f64)P1[0] - P0[0], (f64)P1[1] - P0[1], (f64)P1[2] - P0[2] };
+		const f64 E1[3] = { (f64)P2[0] - P0[0], (f64)P2[1] - P0[1], (f64)P2[2] - P0[2] };
+		f64 Normal[3] =
+		{
+			E0[1] * E1[2] - E0[2] * E1[1],
+			E0[2] * E1[0] - E0[0] * E1[2],
+			E0[0] * E1[1] - E0[1] * E1[0]
+		};
+
+		const f64 Length = std::sqrt(Normal[0] * Normal[0] + Normal[1] * Normal[1] + Normal[2] * Normal[2]);
+		if (Length == 0.0)
+		{
+			return;
+		}
+
+		Normal[0] /= Length;
+		Normal[1] /= Length;
+		Normal[2] /= Length;
+
+		const f64 D = -(Normal[0] * P0[0] + Normal[1] * P0[1] + Normal[2] * P0[2]);
+		const f64 Area = Length * 0.5;
+
+		Q->XX += Area * Normal[0] * Normal[0];
+		Q->XY += Area * Normal[0] * Normal[1];
+		Q->XZ += Area * Normal[0] * Normal[2];
+		Q->XW += Area * Normal[0] * D;
+		Q->YY += Area * Normal[1] * Normal[1];
+		Q->YZ += Area * Normal[1] * Normal[2];
+		Q->YW += Area * Normal[1] * D;
+		Q->ZZ += Area * Normal[2] * Normal[2];
+		Q->ZW += Area * Normal[2] * D;
+		Q->WW += Area * D * D;
+		Q->Weight += Area;
+	}
+
+	// Distance to planes of both quadrics when From is moved into P
+	static f32 GetCollapseError(const Quadric* From, const Quadric* To, const f32* P)
+	{
+		Quadric Q = *From;
+		AddQuadric(&Q, To);
+
+		if (Q.Weight == 0.0)
+		{
+			return 0.0f;
+		}
+
+		const f64 X = P[0];
+		const f64 Y = P[1];
+		const f64 Z = P[2];
+
+		const f64 Error = Q.XX * X * X + 2.0 * Q.XY * X * Y + 2.0 * Q.XZ * X * Z + 2.0 * Q.XW * X +
+			Q.YY * Y * Y + 2.0 * Q.YZ * Y * Z + 2.0 * Q.YW * Y +
+			Q.ZZ * Z * Z + 2.0 * Q.ZW * Z + Q.WW;
+
+		return (f32)std::sqrt(std::max(Error, 0.0) / Q.Weight);
+	}
+
+	static void TriangleNormal(const f32* P0, const f32* P1, const f32* P2, f32* OutNormal)
+	{
+		const f32 E0[3] = { P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2] };
+		const f32 E1[3] = { P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2] };
+
+		OutNormal[0] = E0[1] * E1[2] - E0[2] * E1[1];
+		OutNormal[1] = E0[2] * E1[0] - E0[0] * E1[2];
+		OutNormal[2] = E0[0] * E1[1] - E0[1] * E1[0];
+	}
+
+	// Vertices on open edges or with position shared by other vertex
+	static void FindLockedVertices(const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride,
+		u64 VertexCount, std::vector<u8>& OutLocked)
+	{
+		OutLocked.assign(VertexCount, 0);
+
+		std::unordered_map<u64, u32> EdgeUses;
+		EdgeUses.reserve(IndexCount);
+
+		for (u64 i = 0; i < IndexCount; i += 3)
+		{
+			for (u32 j = 0; j < 3; ++j)
+			{
+				const u32 A = Indices[i + j];
+				const u32 B = Indices[i + (j + 1) % 3];
+				++EdgeUses[A < B ? ((u64)A << 32) | B : ((u64)B << 32) | A];
+			}
+		}
+
+		for (const auto& Edge : EdgeUses)
+		{
+			if (Edge.second == 1)
+			{
+				OutLocked[Edge.first >> 32] = 1;
+				OutLocked[Edge.first & UINT32_MAX] = 1;
+			}
+		}
+
+		std::vector<u32> Sorted(VertexCount);
+		for (u64 i = 0; i < VertexCount; ++i)
+		{
+			Sorted[i] = (u32)i;
+		}
+
+		std::sort(Sorted.begin(), Sorted.end(), [Positions, PositionStride](u32 Left, u32 Right)
+		{
+			return memcmp(GetPosition(Positions, PositionStride, Left), GetPosition(Positions, PositionStride, Right), sizeof(f32) * 3) < 0;
+		});
+
+		for (u64 i = 1; i < VertexCount; ++i)
+		{
+			if (memcmp(GetPosition(Positions, PositionStride, Sorted[i - 1]), GetPosition(Positions, PositionStride, Sorted[i]), sizeof(f32) * 3) == 0)
+			{
+				OutLocked[Sorted[i - 1]] = 1;
+				OutLocked[Sorted[i]] = 1;
+			}
+		}
+	}
+
+	// Triangles around From that stay after collapse must keep their facing
+	static bool IsCollapseFlipping(const u32* Indices, const u32* Adjacency, const u32* AdjacencyOffsets,
+		const f32* Positions, u64 PositionStride, u32 From, u32 To)
+	{
+		for (u32 i = AdjacencyOffsets[From]; i < AdjacencyOffsets[From + 1]; ++i)
+		{
+			const u32* Triangle = Indices + Adjacency[i] * 3;
+			if (Triangle[0] == To || Triangle[1] == To || Triangle[2] == To)
+			{
+				continue;
+			}
+
+			const f32* Before[3];
+			const f32* After[3];
+			for (u32 j = 0; j < 3; ++j)
+			{
+				Before[j] = GetPosition(Positions, PositionStride, Triangle[j]);
+				After[j] = GetPosition(Positions, PositionStride, Triangle[j] == From ? To : Triangle[j]);
+			}
+
+			f32 NormalBefore[3];
+			f32 NormalAfter[3];
+			TriangleNormal(Before[0], Before[1], Before[2], NormalBefore);
+			TriangleNormal(After[0], After[1], After[2], NormalAfter);
+
+			if (NormalBefore[0] * NormalAfter[0] + NormalBefore[1] * NormalAfter[1] + NormalBefore[2] * NormalAfter[2] <= 0.0f)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	u64 SimplifyMesh(u32* Destination, const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride,
+		u64 VertexCount, u64 TargetIndexCount, f32 TargetError, f32* OutError)
+	{
+		assert(IndexCount % 3 == 0);
+
+		*OutError = 0.0f;
+
+		std::vector<u32> Result(Indices, Indices + IndexCount);
+
+		std::vector<u8> Locked;
+		FindLockedVertices(Indices, IndexCount, Positions, PositionStride, VertexCount, Locked);
+
+		std::vector<Quadric> Quadrics(VertexCount, Quadric{ });
+		for (u64 i = 0; i < IndexCount; i += 3)
+		{
+			const f32* P0 = GetPosition(Positions, PositionStride, Indices[i + 0]);
+			const f32* P1 = GetPosition(Positions, PositionStride, Indices[i + 1]);
+			const f32* P2 = GetPosition(Positions, PositionStride, Indices[i + 2]);
+
+			for (u32 j = 0; j < 3; ++j)
+			{
+				AddTriangleQuadric(&Quadrics[Indices[i + j]], P0, P1, P2);
+			}
+		}
+
+		std::vector<EdgeCollapse> Collapses;
+		std::vector<u32> AdjacencyOffsets(VertexCount + 1);
+		std::vector<u32> Adjacency;
+		std::vector<u32> CollapseTargets(VertexCount);
+		std::vector<u8> IsTouched(VertexCount);
+
+		for (u64 i = 0; i < VertexCount; ++i)
+		{
+			CollapseTargets[i] = (u32)i;
+		}
+
+		// Every pass collapses independent edges, regions around collapsed edges wait for next pass
+		while (Result.size() > TargetIndexCount)
+		{
+			Collapses.clear();
+			for (u64 i = 0; i < Result.size(); i += 3)
+			{
+				for (u32 j = 0; j < 3; ++j)
+				{
+					const u32 A = Result[i + j];
+					const u32 B = Result[i + (j + 1) % 3];
+
+					if (!Locked[A])
+					{
+						Collapses.push_back({ A, B, GetCollapseError(&Quadrics[A], &Quadrics[B], GetPosition(Positions, PositionStride, B)) });
+					}
+
+					if (!Locked[B])
+					{
+						Collapses.push_back({ B, A, GetCollapseError(&Quadrics[B], &Quadrics[A], GetPosition(Positions, PositionStride, A)) });
+					}
+				}
+			}
+
+			std::sort(Collapses.begin(), Collapses.end(), [](const EdgeCollapse& Left, const EdgeCollapse& Right)
+			{
+				return Left.Error < Right.Error;
+			});
+
+			std::fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end(), 0);
+			for (u32 Vertex : Result)
+			{
+				++AdjacencyOffsets[Vertex + 1];
+			}
+
+			for (u64 i = 0; i < VertexCount; ++i)
+			{
+				AdjacencyOffsets[i + 1] += AdjacencyOffsets[i];
+			}
+
+			Adjacency.resize(Result.size());
+			std::vector<u32> AdjacencyFill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+			for (u64 i = 0; i < Result.size(); ++i)
+			{
+				Adjacency[AdjacencyFill[Result[i]]++] = (u32)(i / 3);
+			}
+
+			std::fill(IsTouched.begin(), IsTouched.end(), 0);
+
+			// Collapse of inner edge removes two triangles
+			const u64 TrianglesToRemove = (Result.size() - TargetIndexCount) / 3;
+			u64 RemovedTriangles = 0;
+			u64 CollapseCount = 0;
+
+			for (const EdgeCollapse& Collapse : Collapses)
+			{
+				if (Collapse.Error > TargetError || RemovedTriangles >= TrianglesToRemove)
+				{
+					break;
+				}
+
+				if (IsTouched[Collapse.From] || IsTouched[Collapse.To] ||
+					IsCollapseFlipping(Result.data(), Adjacency.data(), AdjacencyOffsets.data(), Positions, PositionStride, Collapse.From, Collapse.To))
+				{
+					continue;
+				}
+
+				for (u32 i = AdjacencyOffsets[Collapse.From]; i < AdjacencyOffsets[Collapse.From + 1]; ++i)
+				{
+					const u32* Triangle = Result.data() + Adjacency[i] * 3;
+					IsTouched[Triangle[0]] = 1;
+					IsTouched[Triangle[1]] = 1;
+					IsTouched[Triangle[2]] = 1;
+				}
+
+				CollapseTargets[Collapse.From] = Collapse.To;
+				AddQuadric(&Quadrics[Collapse.To], &Quadrics[Collapse.From]);
+				*OutError = std::max(*OutError, Collapse.Error);
+
+				RemovedTriangles += 2;
+				++CollapseCount;
+			}
+
+			if (CollapseCount == 0)
+			{
+				break;
+			}
+
+			u64 ResultCount = 0;
+			for (u64 i = 0; i < Result.size(); i += 3)
+			{
+				const u32 A = CollapseTargets[Result[i + 0]];
+				const u32 B = CollapseTargets[Result[i + 1]];
+				const u32 C = CollapseTargets[Result[i + 2]];
+
+				if (A != B && B != C && A != C)
+				{
+					Result[ResultCount++] = A;
+					Result[ResultCount++] = B;
+					Result[ResultCount++] = C;
+				}
+			}
+
+			Result.resize(ResultCount);
+
+			for (u64 i = 0; i < VertexCount; ++i)
+			{
+				CollapseTargets[i] = (u32)i;
+			}
+		}
+
+		std::copy(Result.begin(), Result.end(), Destination);
+		return Result.size();
+	}
+
+	// Returns false for degenerate triangles
+	static bool ComputeTriangleNormal(const f32* P0, const f32* P1, const f32* P2, f32* OutNormal)
+	{
+		const f32 E0[3] = { P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2] };
+		const f32 E1[3] = { P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2] };
+
+		OutNormal[0] = E0[1] * E1[2] - E0[2] * E1[1];
+		OutNormal[1] = E0[2] * E1[0] - E0[0] * E1[2];
+		OutNormal[2] = E0[0] * E1[1] - E0[1] * E1[0];
+
+		const f32 Length = std::sqrt(OutNormal[0] * OutNormal[0] + OutNormal[1] * OutNormal[1] + OutNormal[2] * OutNormal[2]);
+		if (Length == 0.0f)
+		{
+			return false;
+		}
+
+		OutNormal[0] /= Length;
+		OutNormal[1] /= Length;
+		OutNormal[2] /= Length;
+		return true;
+	}
+
+	u64 BuildMeshletsBound(u64 IndexCount, u32 MaxVertices, u32 MaxTriangles)
+	{
+		assert(MaxVertices >= 3 && MaxTriangles >= 1);
+
+		// Every meshlet takes at least MaxVertices / 3 triangles before it runs out of vertices
+		const u64 TriangleCount = IndexCount / 3;
+		const u64 MinTriangles = std::min<u64>(MaxVertices / 3, MaxTriangles);
+
+		return (TriangleCount + MinTriangles - 1) / MinTriangles;
+	}
+
+	u64 BuildMeshlets(MeshletRange* Meshlets, const u32* Indices, u64 IndexCount, u64 VertexCount, u32 MaxVertices, u32 MaxTriangles)
+	{
+		assert(IndexCount % 3 == 0 && MaxVertices >= 3 && MaxTriangles >= 1);
+
+		// Meshlet that last used vertex
+		std::vector<u32> UsedBy(VertexCount, UINT32_MAX);
+
+		u32 MeshletCount = 0;
+		u64 FirstIndex = 0;
+		u32 VerticesInMeshlet = 0;
+		u32 TrianglesInMeshlet = 0;
+
+		for (u64 i = 0; i < IndexCount; i += 3)
+		{
+			u32 NewVertices = 0;
+			for (u32 j = 0; j < 3; ++j)
+			{
+				NewVertices += UsedBy[Indices[i + j]] != MeshletCount ? 1 : 0;
+			}
+
+			if (VerticesInMeshlet + NewVertices > MaxVertices || TrianglesInMeshlet == MaxTriangles)
+			{
+				Meshlets[MeshletCount++] = { (u32)FirstIndex, TrianglesInMeshlet * 3 };
+
+				FirstIndex = i;
+				VerticesInMeshlet = 0;
+				TrianglesInMeshlet = 0;
+			}
+
+			for (u32 j = 0; j < 3; ++j)
+			{
+				if (UsedBy[Indices[i + j]] != MeshletCount)
+				{
+					UsedBy[Indices[i + j]] = MeshletCount;
+					++VerticesInMeshlet;
+				}
+			}
+
+			++TrianglesInMeshlet;
+		}
+
+		if (TrianglesInMeshlet > 0)
+		{
+			Meshlets[MeshletCount++] = { (u32)FirstIndex, TrianglesInMeshlet * 3 };
+		}
+
+		return MeshletCount;
+	}
+
+	MeshletBounds ComputeMeshletBounds(const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride)
+	{
+		MeshletBounds Bounds = { };
+		Bounds.ConeCutoff = 1.0f;
+
+		if (IndexCount == 0)
+		{
+			return Bounds;
+		}
+
+		f32 Min[3];
+		f32 Max[3];
+		memcpy(Min, GetPosition(Positions, PositionStride, Indices[0]), sizeof(Min));
+		memcpy(Max, Min, sizeof(Max));
+
+		for (u64 i = 1; i < IndexCount; ++i)
+		{
+			const f32* P = GetPosition(Positions, PositionStride, Indices[i]);
+			for (u32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Min[Axis] = std::min(Min[Axis], P[Axis]);
+				Max[Axis] = std::max(Max[Axis], P[Axis]);
+			}
+		}
+
+		for (u32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Bounds.Center[Axis] = (Min[Axis] + Max[Axis]) * 0.5f;
+		}
+
+		f32 RadiusSquared = 0.0f;
+		for (u64 i = 0; i < IndexCount; ++i)
+		{
+			const f32* P = GetPosition(Positions, PositionStride, Indices[i]);
+			const f32 D[3] = { P[0] - Bounds.Center[0], P[1] - Bounds.Center[1], P[2] - Bounds.Center[2] };
+			RadiusSquared = std::max(RadiusSquared, D[0] * D[0] + D[1] * D[1] + D[2] * D[2]);
+		}
+
+		Bounds.Radius = std::sqrt(RadiusSquared);
+
+		// Axis is average of unit triangle normals, cone opens until it covers the farthest one
+		std::vector<f32> Normals;
+		Normals.reserve(IndexCount);
+
+		f32 Axis[3] = { };
+		for (u64 i = 0; i < IndexCount; i += 3)
+		{
+			f32 Normal[3];
+			if (!ComputeTriangleNormal(GetPosition(Positions, PositionStride, Indices[i + 0]), GetPosition(Positions, PositionStride, Indices[i + 1]),
+				GetPosition(Positions, PositionStride, Indices[i + 2]), Normal))
+			{
+				continue;
+			}
+
+			Normals.insert(Normals.end(), Normal, Normal + 3);
+			Axis[0] += Normal[0];
+			Axis[1] += Normal[1];
+			Axis[2] += Normal[2];
+		}
+
+		const f32 AxisLength = std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+		if (Normals.empty() || AxisLength < 1e-6f)
+		{
+			return Bounds;
+		}
+
+		f32 MinDot = 1.0f;
+		for (u32 i = 0; i < 3; ++i)
+		{
+			Bounds.ConeAxis[i] = Axis[i] / AxisLength;
+		}
+
+		for (u64 i = 0; i < Normals.size(); i += 3)
+		{
+			const f32 Dot = Normals[i + 0] * Bounds.ConeAxis[0] + Normals[i + 1] * Bounds.ConeAxis[1] + Normals[i + 2] * Bounds.ConeAxis[2];
+			MinDot = std::min(MinDot, Dot);
+		}
+
+		// Backfacing cone is normal cone widened by 90 degrees, its cutoff is sin of normal cone angle
+		Bounds.ConeCutoff = MinDot <= 0.0f ? 1.0f : std::sqrt(1.0f - MinDot * MinDot);
+
+		return Bounds;
+	}
+
+	u64 OptimizeVertexFetchRemap(u32* Remap, u32* Indices, u64 IndexCount, u64 VertexCount)
+	{
+		std::fill(Remap, Remap + VertexCount, UINT32_MAX);
+
+		u32 NextVertex = 0;
+		for (u64 i = 0; i < IndexCount; ++i)
+		{
+			u32* Vertex = Remap + Indices[i];
+			if (*Vertex == UINT32_MAX)
+			{
+				*Vertex = NextVertex++;
+			}
+
+			Indices[i] = *Vertex;
+		}
+
+		return NextVertex;
+	}
+}
\ No newline at end of file
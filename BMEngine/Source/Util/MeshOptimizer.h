@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Util/EngineTypes.h"
+
+// Offline index and vertex reordering used by Util::ObjToModel3D, every function works on triangle lists
+namespace MeshOptimizer
+{
+	// Post transform cache size used for reordering and statistics
+	static const u32 DefaultCacheSize = 16;
+
+	struct VertexCacheStatistics
+	{
+		// Transformed vertices per triangle, 3 is the worst case
+		f32 ACMR;
+		// Transformed vertices per vertex, 1 is the best case
+		f32 ATVR;
+	};
+
+	// Simulates FIFO post transform cache with CacheSize entries
+	VertexCacheStatistics AnalyzeVertexCache(const u32* Indices, u64 IndexCount, u64 VertexCount, u32 CacheSize);
+
+	// Tipsify triangle order, Destination can't alias Indices
+	void OptimizeVertexCache(u32* Destination, const u32* Indices, u64 IndexCount, u64 VertexCount, u32 CacheSize);
+
+	// Splits cache optimized triangles into clusters and draws outward facing clusters first,
+	// clusters are cut where their ACMR is within Threshold of mesh ACMR. Destination can't alias Indices
+	void OptimizeOverdraw(u32* Destination, const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride,
+		u64 VertexCount, u32 CacheSize, f32 Threshold);
+
+	// Collapses edges into existing vertices in order of quadric error until TargetIndexCount is reached or next collapse
+	// moves surface further than TargetError. Border vertices and vertices sharing position with another vertex stay,
+	// so attribute seams don't open. OutError receives largest error of performed collapses. Returns index count
+	u64 SimplifyMesh(u32* Destination, const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride,
+		u64 VertexCount, u64 TargetIndexCount, f32 TargetError, f32* OutError);
+
+	// Meshlet limits that fit mesh shader output of common hardware
+	static const u32 MaxMeshletVertices = 64;
+	static const u32 MaxMeshletTriangles = 124;
+
+	struct MeshletRange
+	{
+		u32 FirstIndex;
+		u32 IndexCount;
+	};
+
+	struct MeshletBounds
+	{
+		f32 Center[3];
+		f32 Radius;
+		// Meshlet faces away from camera when dot(Center - Camera, ConeAxis) >= ConeCutoff * |Center - Camera| + Radius,
+		// ConeCutoff is 1 when normals spread too much for the test
+		f32 ConeAxis[3];
+		f32 ConeCutoff;
+	};
+
+	// Upper bound of meshlets BuildMeshlets can write
+	u64 BuildMeshletsBound(u64 IndexCount, u32 MaxVertices, u32 MaxTriangles);
+
+	// Cuts triangles into meshlets in index order, so triangle order of previous passes stays. Returns meshlet count
+	u64 BuildMeshlets(MeshletRange* Meshlets, const u32* Indices, u64 IndexCount, u64 VertexCount, u32 MaxVertices, u32 MaxTriangles);
+
+	// Bounding sphere and normal cone of triangles, degenerate triangles are skipped
+	MeshletBounds ComputeMeshletBounds(const u32* Indices, u64 IndexCount, const f32* Positions, u64 PositionStride);
+
+	// Renumbers vertices in order of first use and rewrites Indices in place. Remap is indexed by old vertex,
+	// unused vertices get UINT32_MAX. Returns count of used vertices
+	u64 OptimizeVertexFetchRemap(u32* Remap, u32* Indices, u64 IndexCount, u64 VertexCount);
+}
\ No newline at end of file
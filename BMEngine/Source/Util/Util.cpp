@@ -3,6 +3,8 @@
 #include <mini-yaml/yaml/Yaml.hpp>
 
 #include "EngineTypes.h"
+#include "Math.h"
+#include "MeshOptimizer.h"
 
 #include "Engine/Systems/Memory/MemoryManagmentSystem.h"
 FORGE_MEMORY_DEBUG
@@ -18,6 +20,7 @@ FORGE_MEMORY_DEBUG
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <unordered_map>
 
@@ -27,17 +30,25 @@ FORGE_MEMORY_DEBUG
 #include <unordered_set>
 #include <iostream>
 
+// Full precision vertex, quantized into EngineResources::StaticMeshVertex after deduplication
+struct ObjVertex
+{
+	glm::vec3 Position;
+	glm::vec2 TextureCoords;
+	glm::vec3 Normal;
+};
+
 struct VertexEqual
 {
-	bool operator()(const EngineResources::StaticMeshVertex& lhs, const EngineResources::StaticMeshVertex& rhs) const
+	bool operator()(const ObjVertex& lhs, const ObjVertex& rhs) const
 	{
 		return lhs.Position == rhs.Position && lhs.TextureCoords == rhs.TextureCoords;
 	}
 };
 
-template<> struct std::hash<EngineResources::StaticMeshVertex>
+template<> struct std::hash<ObjVertex>
 {
-	size_t operator()(EngineResources::StaticMeshVertex const& vertex) const
+	size_t operator()(ObjVertex const& vertex) const
 	{
 		size_t hashPosition = std::hash<glm::vec3>()(vertex.Position);
 		size_t hashTextureCoords = std::hash<glm::vec2>()(vertex.TextureCoords);
@@ -144,7 +155,112 @@ namespace Util
 		}
 	}
 
-	void ObjToModel3D(const char* FilePath, const char* OutputPath)
+	// Maps unit vector on octahedron and unfolds lower half, result is in [-1, 1]
+	static glm::vec2 EncodeOctahedral(glm::vec3 Normal)
+	{
+		const f32 Length = std::abs(Normal.x) + std::abs(Normal.y) + std::abs(Normal.z);
+		if (Length == 0.0f)
+		{
+			return glm::vec2(0.0f);
+		}
+
+		Normal /= Length;
+
+		glm::vec2 Encoded = glm::vec2(Normal.x, Normal.y);
+		if (Normal.z < 0.0f)
+		{
+			Encoded.x = (1.0f - std::abs(Normal.y)) * (Normal.x >= 0.0f ? 1.0f : -1.0f);
+			Encoded.y = (1.0f - std::abs(Normal.x)) * (Normal.y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		return Encoded;
+	}
+
+	// Largest extent of bounding box, 1 for empty and flat meshes
+	static f32 ComputeMeshScale(const std::vector<ObjVertex>& Vertices, glm::vec3* OutMin)
+	{
+		*OutMin = glm::vec3(0.0f);
+		if (Vertices.empty())
+		{
+			return 1.0f;
+		}
+
+		glm::vec3 Min = Vertices[0].Position;
+		glm::vec3 Max = Min;
+		for (const ObjVertex& Vertex : Vertices)
+		{
+			Min = glm::min(Min, Vertex.Position);
+			Max = glm::max(Max, Vertex.Position);
+		}
+
+		*OutMin = Min;
+
+		const glm::vec3 Extent = Max - Min;
+		const f32 Scale = std::max(Extent.x, std::max(Extent.y, Extent.z));
+		return Scale == 0.0f ? 1.0f : Scale;
+	}
+
+	// Positions are stored relative to mesh bounds with one scale for all axes, so dequantization
+	// goes into instance matrix without breaking normals
+	static Model3DMeshBounds QuantizeVertices(const std::vector<ObjVertex>& Vertices,
+		std::vector<EngineResources::StaticMeshVertex>& OutVertices)
+	{
+		Model3DMeshBounds Bounds;
+		Bounds.Dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		Bounds.BoundingSphere = glm::vec4(0.0f);
+
+		OutVertices.resize(Vertices.size());
+		if (Vertices.empty())
+		{
+			return Bounds;
+		}
+
+		glm::vec3 Min;
+		const f32 Scale = ComputeMeshScale(Vertices, &Min);
+
+		Bounds.Dequantization = glm::vec4(Min, Scale);
+
+		std::vector<glm::vec3> QuantizedPositions(Vertices.size());
+
+		for (u64 i = 0; i < Vertices.size(); ++i)
+		{
+			const ObjVertex& Vertex = Vertices[i];
+			EngineResources::StaticMeshVertex* Packed = &OutVertices[i];
+
+			const glm::vec3 Position = (Vertex.Position - Min) / Scale;
+			for (u32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Packed->Position[Axis] = glm::packUnorm1x16(Position[Axis]);
+				QuantizedPositions[i][Axis] = glm::unpackUnorm1x16(Packed->Position[Axis]);
+			}
+			Packed->Position[3] = 0;
+
+			Packed->TextureCoords[0] = glm::packHalf1x16(Vertex.TextureCoords.x);
+			Packed->TextureCoords[1] = glm::packHalf1x16(Vertex.TextureCoords.y);
+
+			const glm::vec2 Normal = EncodeOctahedral(Vertex.Normal);
+			Packed->Normal[0] = (s16)glm::packSnorm1x16(Normal.x);
+			Packed->Normal[1] = (s16)glm::packSnorm1x16(Normal.y);
+		}
+
+		// Taken from quantized values so rounding can't push vertices out of the sphere
+		Bounds.BoundingSphere = Math::ComputeBoundingSphere(QuantizedPositions.data(), sizeof(glm::vec3), QuantizedPositions.size());
+
+		return Bounds;
+	}
+
+	// Allowed ACMR increase for overdraw ordering
+	static const f32 ModelOverdrawThreshold = 1.05f;
+	// Every LOD targets this part of previous LOD indices
+	static const f32 ModelLodReduction = 0.5f;
+	// LOD that keeps more than this part of previous LOD indices isn't stored
+	static const f32 ModelLodMinReduction = 0.8f;
+	// Largest simplification error relative to mesh size
+	static const f32 ModelLodMaxError = 0.05f;
+	// Half step of 16 bit position quantization along the diagonal, keeps quantized vertices inside meshlet spheres
+	static const f32 ModelMeshletQuantizationMargin = 0.5f * 1.7320508f / 65535.0f;
+
+	void ObjToModel3D(const char* FilePath, const char* OutputPath, bool Compress)
 	{
 		namespace fs = std::filesystem;
 
@@ -174,8 +290,7 @@ namespace Util
 		u64* VerticesCounts = (u64*)malloc(Shapes.size() * sizeof(u64));
 		u32* IndicesCounts = (u32*)malloc(Shapes.size() * sizeof(u32));
 
-		std::unordered_map<EngineResources::StaticMeshVertex, u32,
-			std::hash<EngineResources::StaticMeshVertex>, VertexEqual> uniqueVertices{ };
+		std::unordered_map<ObjVertex, u32, std::hash<ObjVertex>, VertexEqual> uniqueVertices{ };
 
 		std::hash<std::string> Hasher;
 
@@ -184,8 +299,21 @@ namespace Util
 		std::vector<u32> meshMaterialIndices;
 		std::vector<u64> uniqueTextureHashes;
 		std::vector<u8> VerticesAndIndices;
-		std::vector<EngineResources::StaticMeshVertex> Vertices;
+		std::vector<ObjVertex> Vertices;
+		std::vector<EngineResources::StaticMeshVertex> PackedVertices;
 		std::vector<u32> Indices;
+		std::vector<u16> ShortIndices;
+		std::vector<u32> OptimizedIndices;
+		std::vector<u32> LodIndices;
+		std::vector<Model3DMeshLods> MeshLods;
+		std::vector<MeshOptimizer::MeshletRange> MeshletRanges;
+		std::vector<Model3DMeshlet> Meshlets;
+		std::vector<u32> MeshletCounts;
+		std::vector<u64> MeshDataSizes;
+		std::vector<u32> VertexRemap;
+		std::vector<ObjVertex> RemappedVertices;
+		std::vector<Model3DMeshBounds> MeshBounds;
+		std::vector<u32> IndexSizes;
 
 		std::unordered_set<u64> textureHashes;
 
@@ -218,11 +346,14 @@ namespace Util
 		}
 
 		meshMaterialIndices.reserve(Shapes.size());
+		MeshBounds.reserve(Shapes.size());
+		IndexSizes.reserve(Shapes.size());
 
 		for (u32 i = 0; i < Shapes.size(); i++)
 		{
 			Vertices.clear();
 			Indices.clear();
+			uniqueVertices.clear();
 
 			const tinyobj::shape_t* Shape = Shapes.data() + i;
 
@@ -230,7 +361,7 @@ namespace Util
 			{
 				tinyobj::index_t Index = Shape->mesh.indices[j];
 
-				EngineResources::StaticMeshVertex vertex = { };
+				ObjVertex vertex = { };
 
 				vertex.Position =
 				{
@@ -264,22 +395,142 @@ namespace Util
 				Indices.push_back(uniqueVertices[vertex]);
 			}
 
+			const MeshOptimizer::VertexCacheStatistics CacheBefore = MeshOptimizer::AnalyzeVertexCache(Indices.data(), Indices.size(),
+				Vertices.size(), MeshOptimizer::DefaultCacheSize);
+
+			// Triangles in cache friendly order with outer clusters first, then vertices in order of first use
+			OptimizedIndices.resize(Indices.size());
+			MeshOptimizer::OptimizeVertexCache(OptimizedIndices.data(), Indices.data(), Indices.size(), Vertices.size(),
+				MeshOptimizer::DefaultCacheSize);
+			MeshOptimizer::OptimizeOverdraw(Indices.data(), OptimizedIndices.data(), Indices.size(), (const f32*)Vertices.data(),
+				sizeof(ObjVertex), Vertices.size(), MeshOptimizer::DefaultCacheSize, ModelOverdrawThreshold);
+
+			Model3DMeshLods* MeshLod = &MeshLods.emplace_back();
+			MeshLod->LodCount = 1;
+			MeshLod->Lods[0] = { 0, (u32)Indices.size(), 0.0f };
+
+			glm::vec3 MeshMin;
+			const f32 MaxLodError = ModelLodMaxError * ComputeMeshScale(Vertices, &MeshMin);
+
+			// Every LOD simplifies previous one, indices of all LODs follow each other and share vertices
+			while (MeshLod->LodCount < MAX_MESH_LODS)
+			{
+				const Model3DMeshLod Previous = MeshLod->Lods[MeshLod->LodCount - 1];
+				const u64 TargetIndexCount = (u64)(Previous.IndexCount * ModelLodReduction) / 3 * 3;
+
+				LodIndices.resize(Previous.IndexCount);
+
+				f32 LodError;
+				const u64 LodIndexCount = MeshOptimizer::SimplifyMesh(LodIndices.data(), Indices.data() + Previous.FirstIndex, Previous.IndexCount,
+					(const f32*)Vertices.data(), sizeof(ObjVertex), Vertices.size(), TargetIndexCount, MaxLodError, &LodError);
+
+				if (LodIndexCount == 0 || LodIndexCount > Previous.IndexCount * ModelLodMinReduction)
+				{
+					break;
+				}
+
+				// Errors add up since every LOD is measured against previous one
+				Model3DMeshLod* Lod = MeshLod->Lods + MeshLod->LodCount++;
+				Lod->FirstIndex = (u32)Indices.size();
+				Lod->IndexCount = (u32)LodIndexCount;
+				Lod->Error = Previous.Error + LodError;
+
+				Indices.resize(Indices.size() + LodIndexCount);
+				MeshOptimizer::OptimizeVertexCache(Indices.data() + Lod->FirstIndex, LodIndices.data(), LodIndexCount, Vertices.size(),
+					MeshOptimizer::DefaultCacheSize);
+			}
+
+			VertexRemap.resize(Vertices.size());
+			RemappedVertices.resize(MeshOptimizer::OptimizeVertexFetchRemap(VertexRemap.data(), Indices.data(), Indices.size(), Vertices.size()));
+			for (u64 Vertex = 0; Vertex < Vertices.size(); ++Vertex)
+			{
+				if (VertexRemap[Vertex] != UINT32_MAX)
+				{
+					RemappedVertices[VertexRemap[Vertex]] = Vertices[Vertex];
+				}
+			}
+
+			Vertices.swap(RemappedVertices);
+
+			const MeshOptimizer::VertexCacheStatistics CacheAfter = MeshOptimizer::AnalyzeVertexCache(Indices.data(), MeshLod->Lods[0].IndexCount,
+				Vertices.size(), MeshOptimizer::DefaultCacheSize);
+
+			printf("  -> Mesh %u: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %u LODs down to %u triangles\n", i, CacheBefore.ACMR, CacheAfter.ACMR,
+				CacheBefore.ATVR, CacheAfter.ATVR, MeshLod->LodCount, MeshLod->Lods[MeshLod->LodCount - 1].IndexCount / 3);
+
 			VerticesCounts[i] = Vertices.size();
 			IndicesCounts[i] = Indices.size();
 
-			u64 VertexBytes = Vertices.size() * sizeof(EngineResources::StaticMeshVertex);
-			u64 IndexBytes = Indices.size() * sizeof(u32);
+			MeshBounds.push_back(QuantizeVertices(Vertices, PackedVertices));
+
+			const glm::vec4 Dequantization = MeshBounds.back().Dequantization;
+			for (u32 Lod = 0; Lod < MeshLod->LodCount; ++Lod)
+			{
+				MeshLod->Lods[Lod].Error /= Dequantization.w;
+			}
+
+			// Meshlets are cut from final LOD 0 order and bounded in quantized vertex space like the whole mesh
+			MeshletRanges.resize(MeshOptimizer::BuildMeshletsBound(MeshLod->Lods[0].IndexCount, MeshOptimizer::MaxMeshletVertices,
+				MeshOptimizer::MaxMeshletTriangles));
+			MeshletRanges.resize(MeshOptimizer::BuildMeshlets(MeshletRanges.data(), Indices.data(), MeshLod->Lods[0].IndexCount, Vertices.size(),
+				MeshOptimizer::MaxMeshletVertices, MeshOptimizer::MaxMeshletTriangles));
+
+			Meshlets.clear();
+			for (const MeshOptimizer::MeshletRange& Range : MeshletRanges)
+			{
+				const MeshOptimizer::MeshletBounds Bounds = MeshOptimizer::ComputeMeshletBounds(Indices.data() + Range.FirstIndex, Range.IndexCount,
+					(const f32*)Vertices.data(), sizeof(ObjVertex));
+
+				const glm::vec3 Center = (glm::vec3(Bounds.Center[0], Bounds.Center[1], Bounds.Center[2]) - glm::vec3(Dequantization)) / Dequantization.w;
+
+				Model3DMeshlet* Meshlet = &Meshlets.emplace_back();
+				Meshlet->BoundingSphere = glm::vec4(Center, Bounds.Radius / Dequantization.w + ModelMeshletQuantizationMargin);
+				Meshlet->Cone = glm::vec4(Bounds.ConeAxis[0], Bounds.ConeAxis[1], Bounds.ConeAxis[2], Bounds.ConeCutoff);
+				Meshlet->FirstIndex = Range.FirstIndex;
+				Meshlet->IndexCount = Range.IndexCount;
+				Meshlet->Padding[0] = 0;
+				Meshlet->Padding[1] = 0;
+			}
+
+			MeshletCounts.push_back((u32)Meshlets.size());
+
+			// 16 bit indices whenever every vertex is addressable with them
+			const void* IndexData = Indices.data();
+			u32 IndexSize = sizeof(u32);
+			if (Vertices.size() <= UINT16_MAX + 1)
+			{
+				ShortIndices.assign(Indices.begin(), Indices.end());
+				IndexData = ShortIndices.data();
+				IndexSize = sizeof(u16);
+			}
+
+			IndexSizes.push_back(IndexSize);
+
+			u64 VertexBytes = PackedVertices.size() * sizeof(EngineResources::StaticMeshVertex);
+			u64 IndexBytes = Indices.size() * IndexSize;
+
+			u64 MeshletOffset = Math::AlignNumber(VertexBytes + IndexBytes, Model3DMeshletAlignment);
+			u64 MeshletBytes = Meshlets.size() * sizeof(Model3DMeshlet);
 
 			u64 CurrentOffset = VerticesAndIndices.size();
-			VerticesAndIndices.resize(CurrentOffset + VertexBytes + IndexBytes);
+			VerticesAndIndices.resize(CurrentOffset + MeshletOffset + MeshletBytes);
+
+			std::memcpy(VerticesAndIndices.data() + CurrentOffset, PackedVertices.data(), VertexBytes);
+			std::memcpy(VerticesAndIndices.data() + CurrentOffset + VertexBytes, IndexData, IndexBytes);
+			std::memset(VerticesAndIndices.data() + CurrentOffset + VertexBytes + IndexBytes, 0, MeshletOffset - VertexBytes - IndexBytes);
+			std::memcpy(VerticesAndIndices.data() + CurrentOffset + MeshletOffset, Meshlets.data(), MeshletBytes);
 
-			std::memcpy(VerticesAndIndices.data() + CurrentOffset, Vertices.data(), VertexBytes);
-			std::memcpy(VerticesAndIndices.data() + CurrentOffset + VertexBytes, Indices.data(), IndexBytes);
+			MeshDataSizes.push_back(MeshletOffset + MeshletBytes);
 
+			// Every mesh has an entry so arrays after it stay in place, MaterialCount means no material
 			if (Shape->mesh.material_ids[0] != -1)
 			{
 				meshMaterialIndices.push_back(Shape->mesh.material_ids[0]);
 			}
+			else
+			{
+				meshMaterialIndices.push_back(uniqueMaterials.size());
+			}
 		}
 
 		std::ofstream outFile(newAssetPathStr, std::ios::binary);
@@ -296,19 +547,73 @@ namespace Util
 		Header.MaterialCount = uniqueMaterials.size();
 		Header.UniqueTextureCount = uniqueTextureHashes.size();
 
-		outFile.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
-		outFile.write(reinterpret_cast<const char*>(VerticesAndIndices.data()), Header.VertexDataSize);
+		if (Compress)
+		{
+			std::vector<Model3DCompressedBlock> Blocks;
+			std::vector<u8> Payload;
+
+			u64 MeshOffset = 0;
+			for (u32 i = 0; i < Shapes.size(); i++)
+			{
+				const u64 MeshSize = MeshDataSizes[i];
+
+				for (u64 BlockOffset = 0; BlockOffset < MeshSize; BlockOffset += Model3DCompressedBlockSize)
+				{
+					Model3DCompressedBlock Block;
+					Block.RawOffset = MeshOffset + BlockOffset;
+					Block.DataOffset = Payload.size();
+					Block.RawSize = (u32)std::min<u64>(Model3DCompressedBlockSize, MeshSize - BlockOffset);
+
+					const u8* RawData = VerticesAndIndices.data() + Block.RawOffset;
+
+					Payload.resize(Block.DataOffset + CompressBlockBound(Block.RawSize));
+					Block.CompressedSize = CompressBlock(RawData, Block.RawSize, Payload.data() + Block.DataOffset);
+
+					if (Block.CompressedSize >= Block.RawSize)
+					{
+						Block.CompressedSize = Block.RawSize;
+						std::memcpy(Payload.data() + Block.DataOffset, RawData, Block.RawSize);
+					}
+
+					Payload.resize(Block.DataOffset + Block.CompressedSize);
+					Blocks.push_back(Block);
+				}
+
+				MeshOffset += MeshSize;
+			}
+
+			Model3DCompressedHeader CompressedHeader;
+			CompressedHeader.Magic = Model3DCompressedMagic;
+			CompressedHeader.BlockCount = Blocks.size();
+
+			outFile.write(reinterpret_cast<const char*>(&CompressedHeader), sizeof(CompressedHeader));
+			outFile.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+			outFile.write(reinterpret_cast<const char*>(Blocks.data()), Blocks.size() * sizeof(Model3DCompressedBlock));
+			outFile.write(reinterpret_cast<const char*>(Payload.data()), Payload.size());
+
+			printf("  -> Vertex data %llu -> %llu bytes in %llu blocks\n", Header.VertexDataSize, (u64)Payload.size(), (u64)Blocks.size());
+		}
+		else
+		{
+			outFile.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+			outFile.write(reinterpret_cast<const char*>(VerticesAndIndices.data()), Header.VertexDataSize);
+		}
+
 		outFile.write(reinterpret_cast<const char*>(VerticesCounts), Header.MeshCount * sizeof(VerticesCounts[0]));
 		outFile.write(reinterpret_cast<const char*>(IndicesCounts), Header.MeshCount * sizeof(IndicesCounts[0]));
+		outFile.write(reinterpret_cast<const char*>(IndexSizes.data()), Header.MeshCount * sizeof(IndexSizes[0]));
 		outFile.write(reinterpret_cast<const char*>(meshMaterialIndices.data()), meshMaterialIndices.size() * sizeof(meshMaterialIndices[0]));
 		outFile.write(reinterpret_cast<const char*>(uniqueMaterials.data()), Header.MaterialCount * sizeof(Model3DMaterial));
 		outFile.write(reinterpret_cast<const char*>(uniqueTextureHashes.data()), Header.UniqueTextureCount * sizeof(u64));
+		outFile.write(reinterpret_cast<const char*>(MeshBounds.data()), Header.MeshCount * sizeof(Model3DMeshBounds));
+		outFile.write(reinterpret_cast<const char*>(MeshLods.data()), Header.MeshCount * sizeof(Model3DMeshLods));
+		outFile.write(reinterpret_cast<const char*>(MeshletCounts.data()), Header.MeshCount * sizeof(MeshletCounts[0]));
 
 		free(VerticesCounts);
 		free(IndicesCounts);
 	}
 
-	Model3DData LoadModel3DData(const char* FilePath)
+	Model3DData LoadModel3DData(const char* FilePath, u64* OutDataSize)
 	{
 		namespace fs = std::filesystem;
 
@@ -317,22 +622,24 @@ namespace Util
 		std::uintmax_t fileSize = fs::file_size(path, ec);
 		if (ec)
 		{
-			assert(false);
+			return nullptr;
 		}
 
 		std::ifstream file(FilePath, std::ios::binary);
 		if (!file)
 		{
-			assert(false);
+			return nullptr;
 		}
 
 		Model3DData Data = (Model3DData)malloc(fileSize * sizeof(u8));
 		file.read(reinterpret_cast<char*>(Data), fileSize);
 		if (!file)
 		{
-			assert(false);
+			free(Data);
+			return nullptr;
 		}
 
+		*OutDataSize = fileSize;
 		return Data;
 	}
 
@@ -341,31 +648,362 @@ namespace Util
 		free(Data);
 	}
 
-	Model3D ParseModel3D(Model3DData Data)
+	// Moves Cursor past Count elements, false when they do not fit before End
+	template<typename T>
+	static bool ReadModel3DArray(u8** Cursor, const u8* End, u64 Count, T** OutArray)
+	{
+		if (Count > (u64)(End - *Cursor) / sizeof(T))
+		{
+			return false;
+		}
+
+		*OutArray = (T*)*Cursor;
+		*Cursor += Count * sizeof(T);
+		return true;
+	}
+
+	bool ParseModel3D(Model3DData Data, u64 DataSize, Model3D* OutModel)
 	{
 		Model3D Model;
 
-		memcpy(&Model.Header, Data, sizeof(Model3DFileHeader));
-		Data += sizeof(Model3DFileHeader);
+		u8* Cursor = Data;
+		const u8* End = Data + DataSize;
+
+		u64 Magic = 0;
+		if (DataSize >= sizeof(u64))
+		{
+			memcpy(&Magic, Data, sizeof(u64));
+		}
+
+		const bool IsCompressed = Magic == Model3DCompressedMagic;
+
+		Model3DCompressedHeader CompressedHeader = { };
+		if (IsCompressed)
+		{
+			Model3DCompressedHeader* HeaderData;
+			if (!ReadModel3DArray(&Cursor, End, 1, &HeaderData))
+			{
+				return false;
+			}
+
+			memcpy(&CompressedHeader, HeaderData, sizeof(Model3DCompressedHeader));
+		}
+
+		Model3DFileHeader* HeaderData;
+		if (!ReadModel3DArray(&Cursor, End, 1, &HeaderData))
+		{
+			return false;
+		}
+
+		memcpy(&Model.Header, HeaderData, sizeof(Model3DFileHeader));
+
+		u64 PayloadSize = 0;
+		if (IsCompressed)
+		{
+			Model.VertexData = nullptr;
+			Model.CompressedBlockCount = CompressedHeader.BlockCount;
+
+			if (!ReadModel3DArray(&Cursor, End, Model.CompressedBlockCount, &Model.CompressedBlocks))
+			{
+				return false;
+			}
+
+			// Vertex data size is not bounded by file size otherwise
+			if (Model.Header.VertexDataSize > Model.CompressedBlockCount * Model3DCompressedBlockSize)
+			{
+				return false;
+			}
+
+			if (Model.CompressedBlockCount > 0)
+			{
+				const Model3DCompressedBlock* LastBlock = Model.CompressedBlocks + Model.CompressedBlockCount - 1;
+				if (LastBlock->DataOffset > (u64)(End - Cursor))
+				{
+					return false;
+				}
+
+				PayloadSize = LastBlock->DataOffset + LastBlock->CompressedSize;
+			}
+
+			if (!ReadModel3DArray(&Cursor, End, PayloadSize, &Model.CompressedData))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			Model.CompressedBlocks = nullptr;
+			Model.CompressedBlockCount = 0;
+			Model.CompressedData = nullptr;
+
+			if (!ReadModel3DArray(&Cursor, End, Model.Header.VertexDataSize, &Model.VertexData))
+			{
+				return false;
+			}
+		}
+
+		const u32 MeshCount = Model.Header.MeshCount;
+		if (!ReadModel3DArray(&Cursor, End, MeshCount, &Model.VerticesCounts) ||
+			!ReadModel3DArray(&Cursor, End, MeshCount, &Model.IndicesCounts) ||
+			!ReadModel3DArray(&Cursor, End, MeshCount, &Model.IndexSizes) ||
+			!ReadModel3DArray(&Cursor, End, MeshCount, &Model.MaterialIndices) ||
+			!ReadModel3DArray(&Cursor, End, Model.Header.MaterialCount, &Model.Materials) ||
+			!ReadModel3DArray(&Cursor, End, Model.Header.UniqueTextureCount, &Model.UniqueTextureHashes) ||
+			!ReadModel3DArray(&Cursor, End, MeshCount, &Model.MeshBounds) ||
+			!ReadModel3DArray(&Cursor, End, MeshCount, &Model.MeshLods) ||
+			!ReadModel3DArray(&Cursor, End, MeshCount, &Model.MeshletCounts))
+		{
+			return false;
+		}
+
+		const u64 VertexDataSize = Model.Header.VertexDataSize;
+
+		u64 MeshOffset = 0;
+		u64 BlockIndex = 0;
+		for (u32 i = 0; i < MeshCount; ++i)
+		{
+			if ((Model.IndexSizes[i] != sizeof(u16) && Model.IndexSizes[i] != sizeof(u32)) ||
+				Model.MaterialIndices[i] > Model.Header.MaterialCount ||
+				Model.MeshLods[i].LodCount > MAX_MESH_LODS ||
+				Model.VerticesCounts[i] > VertexDataSize / sizeof(EngineResources::StaticMeshVertex))
+			{
+				return false;
+			}
+
+			for (u32 Lod = 0; Lod < Model.MeshLods[i].LodCount; ++Lod)
+			{
+				const Model3DMeshLod* MeshLod = Model.MeshLods[i].Lods + Lod;
+				if ((u64)MeshLod->FirstIndex + MeshLod->IndexCount > Model.IndicesCounts[i])
+				{
+					return false;
+				}
+			}
+
+			const u64 MeshSize = GetModel3DMeshDataSize(Model, i);
+			if (MeshSize > VertexDataSize - MeshOffset)
+			{
+				return false;
+			}
+
+			// Blocks of mesh follow each other and end exactly at end of mesh
+			u64 RawOffset = MeshOffset;
+			for (; BlockIndex < Model.CompressedBlockCount && RawOffset < MeshOffset + MeshSize; ++BlockIndex)
+			{
+				const Model3DCompressedBlock* Block = Model.CompressedBlocks + BlockIndex;
+				if (Block->RawOffset != RawOffset || Block->RawSize == 0 || Block->RawSize > Model3DCompressedBlockSize ||
+					Block->RawSize > MeshOffset + MeshSize - RawOffset || Block->CompressedSize > Block->RawSize ||
+					Block->DataOffset > PayloadSize || Block->CompressedSize > PayloadSize - Block->DataOffset)
+				{
+					return false;
+				}
+
+				RawOffset += Block->RawSize;
+			}
+
+			if (IsCompressed && RawOffset != MeshOffset + MeshSize)
+			{
+				return false;
+			}
+
+			MeshOffset += MeshSize;
+		}
+
+		if (MeshOffset != VertexDataSize || BlockIndex != Model.CompressedBlockCount)
+		{
+			return false;
+		}
+
+		*OutModel = Model;
+		return true;
+	}
+
+	u64 GetModel3DMeshDataSize(const Model3D& Model, u32 MeshIndex)
+	{
+		const u64 VertexBytes = Model.VerticesCounts[MeshIndex] * sizeof(EngineResources::StaticMeshVertex);
+		const u64 IndexBytes = (u64)Model.IndicesCounts[MeshIndex] * Model.IndexSizes[MeshIndex];
+
+		// Converter pads indices even when mesh has no meshlets
+		return Math::AlignNumber(VertexBytes + IndexBytes, Model3DMeshletAlignment) + (u64)Model.MeshletCounts[MeshIndex] * sizeof(Model3DMeshlet);
+	}
+
+	static constexpr u32 LZMinMatch = 4;
+	static constexpr u32 LZMaxOffset = 65535;
+	static constexpr u32 LZHashBits = 12;
+
+	static u8* WriteLZLength(u8* Dst, u32 Length)
+	{
+		for (; Length >= 255; Length -= 255)
+		{
+			*Dst++ = 255;
+		}
+
+		*Dst++ = (u8)Length;
+		return Dst;
+	}
+
+	static bool ReadLZLength(const u8** Src, const u8* SrcEnd, u64* Length)
+	{
+		u8 Byte;
+		do
+		{
+			if (*Src >= SrcEnd)
+			{
+				return false;
+			}
+
+			Byte = *(*Src)++;
+			*Length += Byte;
+		} while (Byte == 255);
+
+		return true;
+	}
+
+	static u8* WriteLZSequence(u8* Dst, const u8* Literals, u32 LiteralLength, u32 Offset, u32 MatchLength)
+	{
+		const u32 MatchToken = MatchLength - LZMinMatch;
+
+		u8* Token = Dst++;
+		*Token = (u8)(std::min<u32>(LiteralLength, 15) << 4);
+		if (LiteralLength >= 15)
+		{
+			Dst = WriteLZLength(Dst, LiteralLength - 15);
+		}
+
+		memcpy(Dst, Literals, LiteralLength);
+		Dst += LiteralLength;
+
+		// Last sequence has literals only
+		if (MatchLength == 0)
+		{
+			return Dst;
+		}
+
+		*Dst++ = (u8)(Offset & 0xFF);
+		*Dst++ = (u8)(Offset >> 8);
+
+		*Token |= (u8)std::min<u32>(MatchToken, 15);
+		if (MatchToken >= 15)
+		{
+			Dst = WriteLZLength(Dst, MatchToken - 15);
+		}
+
+		return Dst;
+	}
+
+	u32 CompressBlockBound(u32 SrcSize)
+	{
+		return SrcSize + SrcSize / 255 + 16;
+	}
 
-		Model.VertexData = Data;
-		Data += Model.Header.VertexDataSize;
+	u32 CompressBlock(const u8* Src, u32 SrcSize, u8* Dst)
+	{
+		// Position + 1 of last sequence with the same hash, 0 is empty
+		u32 HashTable[1 << LZHashBits] = { };
 
-		Model.VerticesCounts = (u64*)Data;
-		Data += Model.Header.MeshCount * sizeof(u64);
+		u8* Out = Dst;
+		u32 Anchor = 0;
+		u32 Position = 0;
+
+		while (Position + LZMinMatch <= SrcSize)
+		{
+			u32 Sequence;
+			memcpy(&Sequence, Src + Position, sizeof(u32));
 
-		Model.IndicesCounts = (u32*)Data;
-		Data += Model.Header.MeshCount * sizeof(u32);
+			const u32 Hash = (Sequence * 2654435761u) >> (32 - LZHashBits);
+			const u32 Candidate = HashTable[Hash];
+			HashTable[Hash] = Position + 1;
 
-		Model.MaterialIndices = (u32*)Data;
-		Data += Model.Header.MeshCount * sizeof(u32);
+			if (Candidate == 0 || Position - (Candidate - 1) > LZMaxOffset || memcmp(Src + Candidate - 1, Src + Position, LZMinMatch) != 0)
+			{
+				++Position;
+				continue;
+			}
 
-		Model.Materials = (Model3DMaterial*)Data;
-		Data += Model.Header.MaterialCount * sizeof(Model3DMaterial);
+			const u32 MatchStart = Candidate - 1;
+			u32 MatchLength = LZMinMatch;
+			while (Position + MatchLength < SrcSize && Src[MatchStart + MatchLength] == Src[Position + MatchLength])
+			{
+				++MatchLength;
+			}
 
-		Model.UniqueTextureHashes = (u64*)Data;
+			Out = WriteLZSequence(Out, Src + Anchor, Position - Anchor, Position - MatchStart, MatchLength);
 
-		return Model;
+			Position += MatchLength;
+			Anchor = Position;
+		}
+
+		Out = WriteLZSequence(Out, Src + Anchor, SrcSize - Anchor, 0, 0);
+
+		assert(Out - Dst <= CompressBlockBound(SrcSize));
+		return (u32)(Out - Dst);
+	}
+
+	bool DecompressBlock(const u8* Src, u32 SrcSize, u8* Dst, u32 DstSize)
+	{
+		const u8* SrcEnd = Src + SrcSize;
+		u8* Out = Dst;
+		u8* OutEnd = Dst + DstSize;
+
+		while (Src < SrcEnd)
+		{
+			const u8 Token = *Src++;
+
+			u64 LiteralLength = Token >> 4;
+			if (LiteralLength == 15 && !ReadLZLength(&Src, SrcEnd, &LiteralLength))
+			{
+				return false;
+			}
+
+			if (LiteralLength > (u64)(SrcEnd - Src) || LiteralLength > (u64)(OutEnd - Out))
+			{
+				return false;
+			}
+
+			memcpy(Out, Src, LiteralLength);
+			Out += LiteralLength;
+			Src += LiteralLength;
+
+			if (Src == SrcEnd)
+			{
+				break;
+			}
+
+			if (SrcEnd - Src < 2)
+			{
+				return false;
+			}
+
+			const u32 Offset = Src[0] | (Src[1] << 8);
+			Src += 2;
+
+			if (Offset == 0 || Offset > Out - Dst)
+			{
+				return false;
+			}
+
+			u64 MatchLength = Token & 15;
+			if (MatchLength == 15 && !ReadLZLength(&Src, SrcEnd, &MatchLength))
+			{
+				return false;
+			}
+
+			MatchLength += LZMinMatch;
+			if (MatchLength > (u64)(OutEnd - Out))
+			{
+				return false;
+			}
+
+			// Match can overlap output, copy byte by byte
+			const u8* Match = Out - Offset;
+			for (u64 i = 0; i < MatchLength; ++i)
+			{
+				Out[i] = Match[i];
+			}
+
+			Out += MatchLength;
+		}
+
+		return Out == OutEnd;
 	}
 
 	Yaml::Node& GetSamplers(Yaml::Node& Root)
@@ -538,6 +1176,17 @@ namespace Util
 		return OutBinding;
 	}
 
+	VkDescriptorBindingFlags ParseDescriptorBindingFlagsNode(Yaml::Node& BindingNode)
+	{
+		if (!BindingNode["bindingFlags"].IsNone())
+		{
+			std::string value = BindingNode["bindingFlags"].As<std::string>();
+			return ParseDescriptorBindingFlags(value.c_str(), value.length());
+		}
+
+		return 0;
+	}
+
 	Yaml::Node& GetVertices(Yaml::Node& Root)
 	{
 		if (!Root["vertices"].IsNone())
@@ -1161,6 +1810,33 @@ namespace Util
 		return flags;
 	}
 
+	VkDescriptorBindingFlags ParseDescriptorBindingFlags(const char* Value, u32 Length)
+	{
+		VkDescriptorBindingFlags flags = 0;
+
+		const char* token = Value;
+		const char* end = Value + Length;
+
+		while (token < end)
+		{
+			while (token < end && (*token == ' ' || *token == '|' || *token == '\t')) token++;
+			if (token >= end) break;
+
+			const char* tokenStart = token;
+			while (token < end && *token != ' ' && *token != '|' && *token != '\t') token++;
+
+			u32 tokenLength = static_cast<u32>(token - tokenStart);
+
+			if (StringMatches(tokenStart, tokenLength, ParseStrings::UPDATE_AFTER_BIND_BIT_STRINGS)) flags |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+			else if (StringMatches(tokenStart, tokenLength, ParseStrings::UPDATE_UNUSED_WHILE_PENDING_BIT_STRINGS)) flags |= VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+			else if (StringMatches(tokenStart, tokenLength, ParseStrings::PARTIALLY_BOUND_BIT_STRINGS)) flags |= VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+			else if (StringMatches(tokenStart, tokenLength, ParseStrings::VARIABLE_DESCRIPTOR_COUNT_BIT_STRINGS)) flags |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+			else assert(false);
+		}
+
+		return flags;
+	}
+
 	VkFormat ParseFormat(const char* Value, u32 Length)
 	{
 		if (StringMatches(Value, Length, ParseStrings::R32_SFLOAT_STRINGS)) return VK_FORMAT_R32_SFLOAT;
@@ -1168,6 +1844,9 @@ namespace Util
 		if (StringMatches(Value, Length, ParseStrings::R32G32B32_SFLOAT_STRINGS)) return VK_FORMAT_R32G32B32_SFLOAT;
 		if (StringMatches(Value, Length, ParseStrings::R32G32B32A32_SFLOAT_STRINGS)) return VK_FORMAT_R32G32B32A32_SFLOAT;
 		if (StringMatches(Value, Length, ParseStrings::R32_UINT_STRINGS)) return VK_FORMAT_R32_UINT;
+		if (StringMatches(Value, Length, ParseStrings::R16G16_SFLOAT_STRINGS)) return VK_FORMAT_R16G16_SFLOAT;
+		if (StringMatches(Value, Length, ParseStrings::R16G16_SNORM_STRINGS)) return VK_FORMAT_R16G16_SNORM;
+		if (StringMatches(Value, Length, ParseStrings::R16G16B16A16_UNORM_STRINGS)) return VK_FORMAT_R16G16B16A16_UNORM;
 
 		assert(false);
 		return VK_FORMAT_R32_SFLOAT;
@@ -1191,6 +1870,9 @@ namespace Util
 			case VK_FORMAT_R32G32B32_SFLOAT: return 12;
 			case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
 			case VK_FORMAT_R32_UINT: return 4;
+			case VK_FORMAT_R16G16_SFLOAT: return 4;
+			case VK_FORMAT_R16G16_SNORM: return 4;
+			case VK_FORMAT_R16G16B16A16_UNORM: return 8;
 			default:
 				assert(false);
 				return 4;
@@ -158,12 +158,21 @@ namespace Util
 		inline constexpr const char* INTERSECTION_BIT_STRINGS[] = { "INTERSECTION_BIT" };
 		inline constexpr const char* CALLABLE_BIT_STRINGS[] = { "CALLABLE_BIT" };
 
+		// Descriptor binding flags
+		inline constexpr const char* UPDATE_AFTER_BIND_BIT_STRINGS[] = { "UPDATE_AFTER_BIND_BIT" };
+		inline constexpr const char* UPDATE_UNUSED_WHILE_PENDING_BIT_STRINGS[] = { "UPDATE_UNUSED_WHILE_PENDING_BIT" };
+		inline constexpr const char* PARTIALLY_BOUND_BIT_STRINGS[] = { "PARTIALLY_BOUND_BIT" };
+		inline constexpr const char* VARIABLE_DESCRIPTOR_COUNT_BIT_STRINGS[] = { "VARIABLE_DESCRIPTOR_COUNT_BIT" };
+
 		// Formats
 		inline constexpr const char* R32_SFLOAT_STRINGS[] = { "R32_SFLOAT" };
 		inline constexpr const char* R32G32_SFLOAT_STRINGS[] = { "R32G32_SFLOAT" };
 		inline constexpr const char* R32G32B32_SFLOAT_STRINGS[] = { "R32G32B32_SFLOAT" };
 		inline constexpr const char* R32G32B32A32_SFLOAT_STRINGS[] = { "R32G32B32A32_SFLOAT" };
 		inline constexpr const char* R32_UINT_STRINGS[] = { "R32_UINT" };
+		inline constexpr const char* R16G16_SFLOAT_STRINGS[] = { "R16G16_SFLOAT" };
+		inline constexpr const char* R16G16_SNORM_STRINGS[] = { "R16G16_SNORM" };
+		inline constexpr const char* R16G16B16A16_UNORM_STRINGS[] = { "R16G16B16A16_UNORM" };
 
 		// Vertex input rates
 		inline constexpr const char* VERTEX_STRINGS[] = { "VERTEX" };
@@ -255,6 +264,8 @@ namespace Util
 	std::string ParseShaderNode(Yaml::Node& ShaderNode);
 	RenderResources::SamplerDescription ParseSamplerNode(Yaml::Node& SamplerNode);
 	VkDescriptorSetLayoutBinding ParseDescriptorSetLayoutBindingNode(Yaml::Node& BindingNode);
+	// Optional bindingFlags of binding node, 0 if not set
+	VkDescriptorBindingFlags ParseDescriptorBindingFlagsNode(Yaml::Node& BindingNode);
 	void ParseVertexAttributeNode(Yaml::Node& AttributeNode, VulkanHelper::VertexAttribute* OutAttribute, std::string* OutAttributeName);
 	VulkanHelper::VertexBinding ParseVertexBindingNode(Yaml::Node& BindingNode);
 	VkPipelineRasterizationStateCreateInfo ParsePipelineRasterizationNode(Yaml::Node& RasterizationNode);
@@ -285,6 +296,7 @@ namespace Util
 	VkSamplerMipmapMode ParseMipmapMode(const char* Value, u32 Length);
 	VkDescriptorType ParseDescriptorType(const char* Value, u32 Length);
 	VkShaderStageFlags ParseShaderStageFlags(const char* Value, u32 Length);
+	VkDescriptorBindingFlags ParseDescriptorBindingFlags(const char* Value, u32 Length);
 
 	VkFormat ParseFormat(const char* Value, u32 Length);
 	VkVertexInputRate ParseVertexInputRate(const char* Value, u32 Length);
@@ -308,6 +320,46 @@ namespace Util
 		u64 SpecularTextureHash;
 	};
 
+	struct Model3DMeshBounds
+	{
+		// Object space position is xyz + w * quantized position
+		glm::vec4 Dequantization;
+		// In quantized vertex space
+		glm::vec4 BoundingSphere;
+	};
+
+	struct Model3DMeshLod
+	{
+		// Relative to first index of mesh
+		u32 FirstIndex;
+		u32 IndexCount;
+		// In quantized vertex space, distance between simplified and full surface
+		f32 Error;
+	};
+
+	// LODs share vertices of mesh, LOD 0 is full mesh
+	struct Model3DMeshLods
+	{
+		u32 LodCount;
+		Model3DMeshLod Lods[MAX_MESH_LODS];
+	};
+
+	// Stored after indices inside mesh vertex data and uploaded as is, see RenderResources::Meshlet
+	struct Model3DMeshlet
+	{
+		// In quantized vertex space
+		glm::vec4 BoundingSphere;
+		// Axis and cutoff of backface cone, see MeshOptimizer::MeshletBounds
+		glm::vec4 Cone;
+		// Relative to first index of mesh, meshlets cover LOD 0
+		u32 FirstIndex;
+		u32 IndexCount;
+		u32 Padding[2];
+	};
+
+	// Meshlets start this aligned from beginning of mesh vertex data
+	static constexpr u64 Model3DMeshletAlignment = 16;
+
 	struct Model3DFileHeader
 	{
 		u64 VertexDataSize;
@@ -316,22 +368,66 @@ namespace Util
 		u32 UniqueTextureCount;
 	};
 
+	// "BMZMODEL", compressed files start with it instead of Model3DFileHeader
+	static constexpr u64 Model3DCompressedMagic = 0x4C45444F4D5A4D42;
+	// Blocks never cross mesh boundaries so every mesh is decompressed on its own
+	static constexpr u32 Model3DCompressedBlockSize = 64 * 1024;
+
+	struct Model3DCompressedHeader
+	{
+		u64 Magic;
+		u64 BlockCount;
+	};
+
+	struct Model3DCompressedBlock
+	{
+		// Offset inside uncompressed vertex data
+		u64 RawOffset;
+		// Offset inside compressed payload
+		u64 DataOffset;
+		u32 RawSize;
+		// Equal to RawSize when block is stored uncompressed
+		u32 CompressedSize;
+	};
+
 	struct Model3D
 	{
 		Model3DFileHeader Header;
 
+		// nullptr for compressed models, vertex data is in CompressedBlocks then
 		u8* VertexData;
 		u64* VerticesCounts;
+		// Indices of all LODs
 		u32* IndicesCounts;
+		// Bytes per index of every mesh, 2 when mesh has at most 65536 vertices
+		u32* IndexSizes;
 		u32* MaterialIndices;
 		Model3DMaterial* Materials;
 		u64* UniqueTextureHashes;
+		Model3DMeshBounds* MeshBounds;
+		Model3DMeshLods* MeshLods;
+		u32* MeshletCounts;
+
+		Model3DCompressedBlock* CompressedBlocks;
+		u64 CompressedBlockCount;
+		u8* CompressedData;
 	};
 
-	void ObjToModel3D(const char* FilePath, const char* OutputPath);
+	void ObjToModel3D(const char* FilePath, const char* OutputPath, bool Compress);
 
-	Model3DData LoadModel3DData(const char* FilePath);
+	// Returns nullptr when file can not be read
+	Model3DData LoadModel3DData(const char* FilePath, u64* OutDataSize);
 	void ClearModel3DData(Model3DData Data);
 
-	Model3D ParseModel3D(Model3DData Data);
+	// Returns false when layout does not fit in DataSize or compressed blocks do not cover meshes exactly,
+	// so loader can slice vertex data and blocks without checks
+	bool ParseModel3D(Model3DData Data, u64 DataSize, Model3D* OutModel);
+	// Vertices, indices of all LODs and meshlets of mesh as laid out in vertex data
+	u64 GetModel3DMeshDataSize(const Model3D& Model, u32 MeshIndex);
+
+	// LZ77 block codec in LZ4 sequence layout, Dst for CompressBlock has to hold CompressBlockBound bytes
+	u32 CompressBlockBound(u32 SrcSize);
+	u32 CompressBlock(const u8* Src, u32 SrcSize, u8* Dst);
+	// Returns false on corrupted input or when output size does not match DstSize
+	bool DecompressBlock(const u8* Src, u32 SrcSize, u8* Dst, u32 DstSize);
 }
\ No newline at end of file
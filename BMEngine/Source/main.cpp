@@ -1,6 +1,6 @@
 #include "Engine/Engine.h"
 
-int main()
+int main(int argc, char** argv)
 {
-	Engine::Main();	
+	Engine::Main(argc, argv);
 }
\ No newline at end of file
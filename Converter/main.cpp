@@ -41,7 +41,9 @@ int main(u32 argc, const char* argv[])
 	for (u32 i = 0; i < argc; i++)
 	{
 		const char* Command = argv[i];
-		if (strcmp(Command, "-m") == 0)
+		// -mc writes compressed models
+		const bool Compress = strcmp(Command, "-mc") == 0;
+		if (strcmp(Command, "-m") == 0 || Compress)
 		{
 			const char* OutputPath = argv[1];
 			CreateDirectoryRecursively(OutputPath);
@@ -55,7 +57,7 @@ int main(u32 argc, const char* argv[])
 
 				if (GetFileAttributesA(File) != INVALID_FILE_ATTRIBUTES)
 				{
-					Util::ObjToModel3D(File, OutputPath);
+					Util::ObjToModel3D(File, OutputPath, Compress);
 				}
 				else
 				{
@@ -0,0 +1,643 @@
+// Dispatches CullInstances and EmitCulledDraws on known spheres and planes and checks compacted draws and instances.
+// Runs headless without window and engine systems. CPU device is preferred, so with lavapipe installed:
+// VK_DRIVER_FILES=<path>/lvp_icd.json Tests.exe [ShaderDirectory]
+// ShaderDirectory holds compiled CullInstances_comp.spv and EmitCulledDraws_comp.spv, ./Resources/Shaders/ by default
+
+#include "Engine/Systems/Render/CullingPass.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TEST_CHECK(Condition) \
+	{ \
+		if (!(Condition)) { \
+			printf("Check failed: %s at %s:%d\n", #Condition, __FILE__, __LINE__); \
+			return false; \
+		} \
+	}
+
+#define TEST_VK_CHECK(Call) \
+	{ \
+		const VkResult Result = (Call); \
+		if (Result != VK_SUCCESS) { \
+			printf("%s returned %d at %s:%d\n", #Call, Result, __FILE__, __LINE__); \
+			return false; \
+		} \
+	}
+
+namespace CullingTests
+{
+	using CullingPass::CullBatch;
+	using CullingPass::CullConstants;
+
+	// Output view layout shared by culling shaders: draw counts of 16 and 32 bit index batches and meshlets,
+	// command of every batch and then visible instance counter of every batch
+	static const u32 OutputCommandsWordOffset = 4;
+	static const u32 CommandWords = 5;
+	static const u32 WorkGroupSize = 64;
+	static const u32 PlanesPerView = 6;
+
+	static const u32 ViewCount = 2;
+	static const u32 BatchCount = 4;
+	static const u32 InstanceCount = 7;
+	static const u32 MaxDrawCount = 8;
+	static const u32 OutputViewStride = OutputCommandsWordOffset + MaxDrawCount * (CommandWords + 1);
+	// Culling shaders copy instances as raw floats, model matrix is enough here
+	static const u32 InstanceStride = 16;
+	// Batched instances first, then region of every view
+	static const u32 ViewRegion = InstanceCount;
+	static const u32 ViewRegionStride = InstanceCount;
+	static const u32 InstanceSlots = ViewRegion + ViewCount * ViewRegionStride;
+
+	static const u32 BindingCount = 5;
+
+	struct TestBuffer
+	{
+		VkBuffer Buffer;
+		VkDeviceMemory Memory;
+		void* MappedData;
+		u64 Size;
+	};
+
+	struct TestContext
+	{
+		VkInstance Instance;
+		VkPhysicalDevice PhysicalDevice;
+		VkDevice Device;
+		VkQueue Queue;
+		u32 QueueFamily;
+
+		TestBuffer Buffers[BindingCount];
+
+		VkDescriptorSetLayout SetLayout;
+		VkPipelineLayout PipelineLayout;
+		VkDescriptorPool Pool;
+		VkDescriptorSet Set;
+		VkShaderModule CullShader;
+		VkShaderModule EmitShader;
+		VkPipeline CullPipeline;
+		VkPipeline EmitPipeline;
+		VkCommandPool CommandPool;
+		VkFence Fence;
+	};
+
+	static TestContext Context;
+
+	static bool ReadShader(const std::string& Path, std::vector<u32>& OutCode)
+	{
+		FILE* File = fopen(Path.c_str(), "rb");
+		if (File == nullptr)
+		{
+			printf("Cannot open shader %s\n", Path.c_str());
+			return false;
+		}
+
+		fseek(File, 0, SEEK_END);
+		const long Size = ftell(File);
+		fseek(File, 0, SEEK_SET);
+
+		OutCode.resize((Size + sizeof(u32) - 1) / sizeof(u32));
+		const bool IsRead = Size > 0 && fread(OutCode.data(), 1, Size, File) == (size_t)Size;
+		fclose(File);
+
+		if (!IsRead)
+		{
+			printf("Cannot read shader %s\n", Path.c_str());
+		}
+
+		return IsRead;
+	}
+
+	static bool CreateDevice()
+	{
+		VkApplicationInfo AppInfo = { };
+		AppInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		AppInfo.pApplicationName = "BMEngine Tests";
+		AppInfo.apiVersion = VK_API_VERSION_1_3;
+
+		VkInstanceCreateInfo InstanceInfo = { };
+		InstanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		InstanceInfo.pApplicationInfo = &AppInfo;
+
+		TEST_VK_CHECK(vkCreateInstance(&InstanceInfo, nullptr, &Context.Instance));
+
+		u32 DeviceCount = 0;
+		TEST_VK_CHECK(vkEnumeratePhysicalDevices(Context.Instance, &DeviceCount, nullptr));
+		TEST_CHECK(DeviceCount > 0);
+
+		std::vector<VkPhysicalDevice> Devices(DeviceCount);
+		TEST_VK_CHECK(vkEnumeratePhysicalDevices(Context.Instance, &DeviceCount, Devices.data()));
+
+		// Software device gives same results on every machine
+		Context.PhysicalDevice = Devices[0];
+		for (VkPhysicalDevice Device : Devices)
+		{
+			VkPhysicalDeviceProperties Properties;
+			vkGetPhysicalDeviceProperties(Device, &Properties);
+			if (Properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU)
+			{
+				Context.PhysicalDevice = Device;
+				break;
+			}
+		}
+
+		VkPhysicalDeviceProperties Properties;
+		vkGetPhysicalDeviceProperties(Context.PhysicalDevice, &Properties);
+		printf("Device: %s\n", Properties.deviceName);
+
+		u32 FamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(Context.PhysicalDevice, &FamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> Families(FamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(Context.PhysicalDevice, &FamilyCount, Families.data());
+
+		Context.QueueFamily = UINT32_MAX;
+		for (u32 i = 0; i < FamilyCount; ++i)
+		{
+			if (Families[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+			{
+				Context.QueueFamily = i;
+				break;
+			}
+		}
+
+		TEST_CHECK(Context.QueueFamily != UINT32_MAX);
+
+		const f32 Priority = 1.0f;
+		VkDeviceQueueCreateInfo QueueInfo = { };
+		QueueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		QueueInfo.queueFamilyIndex = Context.QueueFamily;
+		QueueInfo.queueCount = 1;
+		QueueInfo.pQueuePriorities = &Priority;
+
+		VkPhysicalDeviceVulkan13Features Features13 = { };
+		Features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		Features13.synchronization2 = VK_TRUE;
+
+		VkDeviceCreateInfo DeviceInfo = { };
+		DeviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		DeviceInfo.pNext = &Features13;
+		DeviceInfo.queueCreateInfoCount = 1;
+		DeviceInfo.pQueueCreateInfos = &QueueInfo;
+
+		TEST_VK_CHECK(vkCreateDevice(Context.PhysicalDevice, &DeviceInfo, nullptr, &Context.Device));
+		vkGetDeviceQueue(Context.Device, Context.QueueFamily, 0, &Context.Queue);
+
+		return true;
+	}
+
+	static bool CreateHostBuffer(u64 Size, TestBuffer* OutBuffer)
+	{
+		VkBufferCreateInfo BufferInfo = { };
+		BufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		BufferInfo.size = Size;
+		BufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		BufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		TEST_VK_CHECK(vkCreateBuffer(Context.Device, &BufferInfo, nullptr, &OutBuffer->Buffer));
+
+		VkMemoryRequirements Requirements;
+		vkGetBufferMemoryRequirements(Context.Device, OutBuffer->Buffer, &Requirements);
+
+		VkPhysicalDeviceMemoryProperties MemoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(Context.PhysicalDevice, &MemoryProperties);
+
+		const VkMemoryPropertyFlags Flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		u32 MemoryType = UINT32_MAX;
+		for (u32 i = 0; i < MemoryProperties.memoryTypeCount; ++i)
+		{
+			if ((Requirements.memoryTypeBits & (1u << i)) && (MemoryProperties.memoryTypes[i].propertyFlags & Flags) == Flags)
+			{
+				MemoryType = i;
+				break;
+			}
+		}
+
+		TEST_CHECK(MemoryType != UINT32_MAX);
+
+		VkMemoryAllocateInfo AllocInfo = { };
+		AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		AllocInfo.allocationSize = Requirements.size;
+		AllocInfo.memoryTypeIndex = MemoryType;
+
+		TEST_VK_CHECK(vkAllocateMemory(Context.Device, &AllocInfo, nullptr, &OutBuffer->Memory));
+		TEST_VK_CHECK(vkBindBufferMemory(Context.Device, OutBuffer->Buffer, OutBuffer->Memory, 0));
+		TEST_VK_CHECK(vkMapMemory(Context.Device, OutBuffer->Memory, 0, VK_WHOLE_SIZE, 0, &OutBuffer->MappedData));
+
+		memset(OutBuffer->MappedData, 0, Size);
+		OutBuffer->Size = Size;
+		return true;
+	}
+
+	static bool CreateComputePipeline(const std::string& Path, VkShaderModule* OutModule, VkPipeline* OutPipeline)
+	{
+		std::vector<u32> Code;
+		if (!ReadShader(Path, Code))
+		{
+			return false;
+		}
+
+		VkShaderModuleCreateInfo ModuleInfo = { };
+		ModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		ModuleInfo.codeSize = Code.size() * sizeof(u32);
+		ModuleInfo.pCode = Code.data();
+
+		TEST_VK_CHECK(vkCreateShaderModule(Context.Device, &ModuleInfo, nullptr, OutModule));
+
+		VkComputePipelineCreateInfo PipelineInfo = { };
+		PipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		PipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		PipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		PipelineInfo.stage.module = *OutModule;
+		PipelineInfo.stage.pName = "main";
+		PipelineInfo.layout = Context.PipelineLayout;
+
+		TEST_VK_CHECK(vkCreateComputePipelines(Context.Device, VK_NULL_HANDLE, 1, &PipelineInfo, nullptr, OutPipeline));
+		return true;
+	}
+
+	// Same bindings as CullingLayout, meshlet bindings are not used by tested shaders
+	static bool CreatePipelines(const std::string& ShaderDirectory)
+	{
+		VkDescriptorSetLayoutBinding Bindings[BindingCount] = { };
+		for (u32 i = 0; i < BindingCount; ++i)
+		{
+			Bindings[i].binding = i;
+			Bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			Bindings[i].descriptorCount = 1;
+			Bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo SetLayoutInfo = { };
+		SetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		SetLayoutInfo.bindingCount = BindingCount;
+		SetLayoutInfo.pBindings = Bindings;
+
+		TEST_VK_CHECK(vkCreateDescriptorSetLayout(Context.Device, &SetLayoutInfo, nullptr, &Context.SetLayout));
+
+		VkPushConstantRange PushConstants = { };
+		PushConstants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		PushConstants.offset = 0;
+		PushConstants.size = sizeof(CullConstants);
+
+		VkPipelineLayoutCreateInfo PipelineLayoutInfo = { };
+		PipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		PipelineLayoutInfo.setLayoutCount = 1;
+		PipelineLayoutInfo.pSetLayouts = &Context.SetLayout;
+		PipelineLayoutInfo.pushConstantRangeCount = 1;
+		PipelineLayoutInfo.pPushConstantRanges = &PushConstants;
+
+		TEST_VK_CHECK(vkCreatePipelineLayout(Context.Device, &PipelineLayoutInfo, nullptr, &Context.PipelineLayout));
+
+		if (!CreateComputePipeline(ShaderDirectory + "CullInstances_comp.spv", &Context.CullShader, &Context.CullPipeline) ||
+			!CreateComputePipeline(ShaderDirectory + "EmitCulledDraws_comp.spv", &Context.EmitShader, &Context.EmitPipeline))
+		{
+			return false;
+		}
+
+		VkDescriptorPoolSize PoolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BindingCount };
+
+		VkDescriptorPoolCreateInfo PoolInfo = { };
+		PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolInfo.maxSets = 1;
+		PoolInfo.poolSizeCount = 1;
+		PoolInfo.pPoolSizes = &PoolSize;
+
+		TEST_VK_CHECK(vkCreateDescriptorPool(Context.Device, &PoolInfo, nullptr, &Context.Pool));
+
+		VkDescriptorSetAllocateInfo SetInfo = { };
+		SetInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		SetInfo.descriptorPool = Context.Pool;
+		SetInfo.descriptorSetCount = 1;
+		SetInfo.pSetLayouts = &Context.SetLayout;
+
+		TEST_VK_CHECK(vkAllocateDescriptorSets(Context.Device, &SetInfo, &Context.Set));
+
+		VkDescriptorBufferInfo BufferInfos[BindingCount];
+		VkWriteDescriptorSet Writes[BindingCount] = { };
+		for (u32 i = 0; i < BindingCount; ++i)
+		{
+			BufferInfos[i] = { Context.Buffers[i].Buffer, 0, Context.Buffers[i].Size };
+
+			Writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			Writes[i].dstSet = Context.Set;
+			Writes[i].dstBinding = i;
+			Writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			Writes[i].descriptorCount = 1;
+			Writes[i].pBufferInfo = BufferInfos + i;
+		}
+
+		vkUpdateDescriptorSets(Context.Device, BindingCount, Writes, 0, nullptr);
+		return true;
+	}
+
+	// View 0 is box -10..10 on every axis, view 1 is same box moved to 40..60 on x. Planes face inside
+	static void WritePlanes(glm::vec4* Planes)
+	{
+		const f32 MinX[ViewCount] = { -10.0f, 40.0f };
+		const f32 MaxX[ViewCount] = { 10.0f, 60.0f };
+
+		for (u32 View = 0; View < ViewCount; ++View)
+		{
+			glm::vec4* ViewPlanes = Planes + View * PlanesPerView;
+			ViewPlanes[0] = glm::vec4(1.0f, 0.0f, 0.0f, -MinX[View]);
+			ViewPlanes[1] = glm::vec4(-1.0f, 0.0f, 0.0f, MaxX[View]);
+			ViewPlanes[2] = glm::vec4(0.0f, 1.0f, 0.0f, 10.0f);
+			ViewPlanes[3] = glm::vec4(0.0f, -1.0f, 0.0f, 10.0f);
+			ViewPlanes[4] = glm::vec4(0.0f, 0.0f, 1.0f, 10.0f);
+			ViewPlanes[5] = glm::vec4(0.0f, 0.0f, -1.0f, 10.0f);
+		}
+	}
+
+	static void WriteBatch(CullBatch* Batch, glm::vec4 Sphere, u32 IndexCount0, u32 IndexCount1, u32 FirstIndex0, u32 FirstIndex1,
+		s32 VertexOffset, u32 FirstInstance, u32 InstanceCount, u32 IndexType, u32 MeshletViews)
+	{
+		memset(Batch, 0, sizeof(*Batch));
+		Batch->BoundingSphere = Sphere;
+		Batch->IndexCount[0] = IndexCount0;
+		Batch->IndexCount[1] = IndexCount1;
+		Batch->FirstIndex[0] = FirstIndex0;
+		Batch->FirstIndex[1] = FirstIndex1;
+		Batch->VertexOffset = VertexOffset;
+		Batch->FirstInstance = FirstInstance;
+		Batch->InstanceCount = InstanceCount;
+		Batch->IndexType = IndexType;
+		Batch->MeshletViews = MeshletViews;
+	}
+
+	// Instance 0 is inside view 0, 1 inside view 1, 2 intersects view 0 border, 3 is outside of every view,
+	// 4 is scaled so its sphere reaches view 0, 5 has sphere center moved into view 0, 6 is drawn by meshlets in view 0
+	static void GetInstanceMatrices(glm::mat4* OutMatrices)
+	{
+		const glm::mat4 Identity = glm::mat4(1.0f);
+		OutMatrices[0] = Identity;
+		OutMatrices[1] = glm::translate(Identity, glm::vec3(50.0f, 0.0f, 0.0f));
+		OutMatrices[2] = glm::translate(Identity, glm::vec3(10.5f, 0.0f, 0.0f));
+		OutMatrices[3] = glm::translate(Identity, glm::vec3(0.0f, -30.0f, 0.0f));
+		OutMatrices[4] = glm::scale(glm::translate(Identity, glm::vec3(0.0f, 25.0f, 0.0f)), glm::vec3(20.0f));
+		OutMatrices[5] = glm::translate(Identity, glm::vec3(0.0f, 0.0f, -20.0f));
+		OutMatrices[6] = Identity;
+	}
+
+	static bool Dispatch()
+	{
+		VkCommandPoolCreateInfo PoolInfo = { };
+		PoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		PoolInfo.queueFamilyIndex = Context.QueueFamily;
+
+		TEST_VK_CHECK(vkCreateCommandPool(Context.Device, &PoolInfo, nullptr, &Context.CommandPool));
+
+		VkCommandBufferAllocateInfo CmdInfo = { };
+		CmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		CmdInfo.commandPool = Context.CommandPool;
+		CmdInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		CmdInfo.commandBufferCount = 1;
+
+		VkCommandBuffer CmdBuffer;
+		TEST_VK_CHECK(vkAllocateCommandBuffers(Context.Device, &CmdInfo, &CmdBuffer));
+
+		VkCommandBufferBeginInfo BeginInfo = { };
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		TEST_VK_CHECK(vkBeginCommandBuffer(CmdBuffer, &BeginInfo));
+
+		// Batches 0, 2 and 3 use 16 bit indices
+		CullConstants Constants = { };
+		Constants.InstanceCount = InstanceCount;
+		Constants.BatchCount = BatchCount;
+		Constants.InstanceStride = InstanceStride;
+		Constants.BatchRegion = 0;
+		Constants.ViewRegion = ViewRegion;
+		Constants.ViewRegionStride = ViewRegionStride;
+		Constants.OutputViewStride = OutputViewStride;
+		Constants.MaxDrawCount = MaxDrawCount;
+		Constants.WideIndexBase = 3;
+
+		vkCmdBindDescriptorSets(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Context.PipelineLayout, 0, 1, &Context.Set, 0, nullptr);
+		vkCmdPushConstants(CmdBuffer, Context.PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &Constants);
+
+		vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Context.CullPipeline);
+		vkCmdDispatch(CmdBuffer, (InstanceCount + WorkGroupSize - 1) / WorkGroupSize, ViewCount, 1);
+
+		VkMemoryBarrier2 CullBarrier = { };
+		CullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+		CullBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		CullBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+		CullBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		CullBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+		VkDependencyInfo CullDepInfo = { };
+		CullDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		CullDepInfo.memoryBarrierCount = 1;
+		CullDepInfo.pMemoryBarriers = &CullBarrier;
+
+		vkCmdPipelineBarrier2(CmdBuffer, &CullDepInfo);
+
+		vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Context.EmitPipeline);
+		vkCmdDispatch(CmdBuffer, (BatchCount + WorkGroupSize - 1) / WorkGroupSize, ViewCount, 1);
+
+		VkMemoryBarrier2 HostBarrier = { };
+		HostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+		HostBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		HostBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+		HostBarrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+		HostBarrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+		VkDependencyInfo HostDepInfo = { };
+		HostDepInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		HostDepInfo.memoryBarrierCount = 1;
+		HostDepInfo.pMemoryBarriers = &HostBarrier;
+
+		vkCmdPipelineBarrier2(CmdBuffer, &HostDepInfo);
+
+		TEST_VK_CHECK(vkEndCommandBuffer(CmdBuffer));
+
+		VkFenceCreateInfo FenceInfo = { };
+		FenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		TEST_VK_CHECK(vkCreateFence(Context.Device, &FenceInfo, nullptr, &Context.Fence));
+
+		VkSubmitInfo SubmitInfo = { };
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &CmdBuffer;
+
+		TEST_VK_CHECK(vkQueueSubmit(Context.Queue, 1, &SubmitInfo, Context.Fence));
+		TEST_VK_CHECK(vkWaitForFences(Context.Device, 1, &Context.Fence, VK_TRUE, UINT64_MAX));
+
+		return true;
+	}
+
+	static bool IsCommand(const u32* Command, u32 IndexCount, u32 InstanceCount, u32 FirstIndex, s32 VertexOffset, u32 FirstInstance)
+	{
+		return Command[0] == IndexCount && Command[1] == InstanceCount && Command[2] == FirstIndex &&
+			(s32)Command[3] == VertexOffset && Command[4] == FirstInstance;
+	}
+
+	// Order of instances inside batch and of draws with same index type depends on atomics, so both are searched
+	static bool HasInstance(const f32* Instances, u32 FirstSlot, u32 SlotCount, const glm::mat4& Matrix)
+	{
+		for (u32 i = 0; i < SlotCount; ++i)
+		{
+			if (memcmp(Instances + (FirstSlot + i) * InstanceStride, &Matrix, sizeof(Matrix)) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static const u32* FindCommand(const u32* ViewOutput, u32 FirstDraw, u32 DrawCount, u32 FirstInstance)
+	{
+		for (u32 i = 0; i < DrawCount; ++i)
+		{
+			const u32* Command = ViewOutput + OutputCommandsWordOffset + (FirstDraw + i) * CommandWords;
+			if (Command[4] == FirstInstance)
+			{
+				return Command;
+			}
+		}
+
+		return nullptr;
+	}
+
+	static bool CheckOutput(const glm::mat4* Matrices)
+	{
+		const u32* Output = (const u32*)Context.Buffers[4].MappedData;
+		const f32* Instances = (const f32*)Context.Buffers[3].MappedData;
+
+		const u32* View0 = Output;
+		const u32* VisibleCounters0 = View0 + OutputCommandsWordOffset + MaxDrawCount * CommandWords;
+
+		// Batch 3 is skipped for meshlets in view 0, batch 2 draws only moved sphere instance
+		TEST_CHECK(VisibleCounters0[0] == 2 && VisibleCounters0[1] == 1 && VisibleCounters0[2] == 1 && VisibleCounters0[3] == 0);
+		TEST_CHECK(View0[0] == 2 && View0[1] == 1);
+
+		const u32* Batch0Draw = FindCommand(View0, 0, View0[0], ViewRegion + 0);
+		const u32* Batch2Draw = FindCommand(View0, 0, View0[0], ViewRegion + 5);
+		TEST_CHECK(Batch0Draw != nullptr && IsCommand(Batch0Draw, 36, 2, 0, 0, ViewRegion + 0));
+		TEST_CHECK(Batch2Draw != nullptr && IsCommand(Batch2Draw, 24, 1, 200, 3, ViewRegion + 5));
+		TEST_CHECK(IsCommand(View0 + OutputCommandsWordOffset + 3 * CommandWords, 60, 1, 100, 7, ViewRegion + 3));
+
+		TEST_CHECK(HasInstance(Instances, ViewRegion + 0, 2, Matrices[0]));
+		TEST_CHECK(HasInstance(Instances, ViewRegion + 0, 2, Matrices[2]));
+		TEST_CHECK(HasInstance(Instances, ViewRegion + 3, 1, Matrices[4]));
+		TEST_CHECK(HasInstance(Instances, ViewRegion + 5, 1, Matrices[5]));
+
+		// Only instance 1 is inside view 1, it is drawn with LOD of view 1
+		const u32* View1 = Output + OutputViewStride;
+		const u32* VisibleCounters1 = View1 + OutputCommandsWordOffset + MaxDrawCount * CommandWords;
+
+		TEST_CHECK(VisibleCounters1[0] == 1 && VisibleCounters1[1] == 0 && VisibleCounters1[2] == 0 && VisibleCounters1[3] == 0);
+		TEST_CHECK(View1[0] == 1 && View1[1] == 0);
+		TEST_CHECK(IsCommand(View1 + OutputCommandsWordOffset, 12, 1, 36, 0, ViewRegion + ViewRegionStride));
+		TEST_CHECK(HasInstance(Instances, ViewRegion + ViewRegionStride, 1, Matrices[1]));
+
+		return true;
+	}
+
+	static void DestroyContext()
+	{
+		if (Context.Device != VK_NULL_HANDLE)
+		{
+			vkDeviceWaitIdle(Context.Device);
+
+			vkDestroyFence(Context.Device, Context.Fence, nullptr);
+			vkDestroyCommandPool(Context.Device, Context.CommandPool, nullptr);
+			vkDestroyPipeline(Context.Device, Context.CullPipeline, nullptr);
+			vkDestroyPipeline(Context.Device, Context.EmitPipeline, nullptr);
+			vkDestroyShaderModule(Context.Device, Context.CullShader, nullptr);
+			vkDestroyShaderModule(Context.Device, Context.EmitShader, nullptr);
+			vkDestroyDescriptorPool(Context.Device, Context.Pool, nullptr);
+			vkDestroyPipelineLayout(Context.Device, Context.PipelineLayout, nullptr);
+			vkDestroyDescriptorSetLayout(Context.Device, Context.SetLayout, nullptr);
+
+			for (u32 i = 0; i < BindingCount; ++i)
+			{
+				vkDestroyBuffer(Context.Device, Context.Buffers[i].Buffer, nullptr);
+				vkFreeMemory(Context.Device, Context.Buffers[i].Memory, nullptr);
+			}
+
+			vkDestroyDevice(Context.Device, nullptr);
+		}
+
+		if (Context.Instance != VK_NULL_HANDLE)
+		{
+			vkDestroyInstance(Context.Instance, nullptr);
+		}
+	}
+
+	static bool RunCullingTest(const std::string& ShaderDirectory)
+	{
+		if (!CreateDevice())
+		{
+			return false;
+		}
+
+		const u64 Sizes[BindingCount] =
+		{
+			ViewCount * PlanesPerView * sizeof(glm::vec4),
+			BatchCount * sizeof(CullBatch),
+			InstanceCount * sizeof(u32),
+			InstanceSlots * InstanceStride * sizeof(f32),
+			ViewCount * OutputViewStride * sizeof(u32),
+		};
+
+		for (u32 i = 0; i < BindingCount; ++i)
+		{
+			if (!CreateHostBuffer(Sizes[i], Context.Buffers + i))
+			{
+				return false;
+			}
+		}
+
+		if (!CreatePipelines(ShaderDirectory))
+		{
+			return false;
+		}
+
+		WritePlanes((glm::vec4*)Context.Buffers[0].MappedData);
+
+		CullBatch* Batches = (CullBatch*)Context.Buffers[1].MappedData;
+		WriteBatch(Batches + 0, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 36, 12, 0, 36, 0, 0, 3, 0, 0);
+		WriteBatch(Batches + 1, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 60, 60, 100, 100, 7, 3, 2, 1, 0);
+		WriteBatch(Batches + 2, glm::vec4(0.0f, 0.0f, 15.0f, 1.0f), 24, 24, 200, 200, 3, 5, 1, 0, 0);
+		WriteBatch(Batches + 3, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 48, 48, 300, 300, 0, 6, 1, 0, 1);
+
+		const u32 InstanceBatches[InstanceCount] = { 0, 0, 0, 1, 1, 2, 3 };
+		memcpy(Context.Buffers[2].MappedData, InstanceBatches, sizeof(InstanceBatches));
+
+		glm::mat4 Matrices[InstanceCount];
+		GetInstanceMatrices(Matrices);
+
+		f32* Instances = (f32*)Context.Buffers[3].MappedData;
+		for (u32 i = 0; i < InstanceCount; ++i)
+		{
+			memcpy(Instances + i * InstanceStride, Matrices + i, sizeof(glm::mat4));
+		}
+
+		return Dispatch() && CheckOutput(Matrices);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string ShaderDirectory = argc > 1 ? argv[1] : "./Resources/Shaders/";
+	if (ShaderDirectory.back() != '/' && ShaderDirectory.back() != '\\')
+	{
+		ShaderDirectory += '/';
+	}
+
+	const bool Passed = CullingTests::RunCullingTest(ShaderDirectory);
+	CullingTests::DestroyContext();
+
+	printf("CullingTests: %s\n", Passed ? "passed" : "failed");
+	return Passed ? 0 : 1;
+}